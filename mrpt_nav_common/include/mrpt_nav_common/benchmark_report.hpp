@@ -0,0 +1,248 @@
+/* +------------------------------------------------------------------------+
+   |                             mrpt_navigation                            |
+   |                                                                        |
+   | Copyright (c) 2014-2024, Individual contributors, see commit authors   |
+   | See: https://github.com/mrpt-ros-pkg/mrpt_navigation                   |
+   | All rights reserved. Released under BSD 3-Clause license. See LICENSE  |
+   +------------------------------------------------------------------------+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/* Result statistics, JSON reports and regression gates shared by the
+ * offline benchmark apps of the mrpt_navigation packages.
+ * Header-only and without ROS dependencies. */
+
+namespace mrpt_nav_common::benchmark
+{
+/** Quotes a string as a JSON string literal, escaping it as needed */
+inline std::string json_string(const std::string& s)
+{
+	std::string out = "\"";
+	for (const char c : s)
+	{
+		switch (c)
+		{
+			case '"':
+				out += "\\\"";
+				break;
+			case '\\':
+				out += "\\\\";
+				break;
+			case '\n':
+				out += "\\n";
+				break;
+			case '\r':
+				out += "\\r";
+				break;
+			case '\t':
+				out += "\\t";
+				break;
+			default:
+				if (static_cast<unsigned char>(c) < 0x20)
+				{
+					char buf[8];
+					std::snprintf(
+						buf, sizeof(buf), "\\u%04x", static_cast<unsigned>(c));
+					out += buf;
+				}
+				else
+					out += c;
+		}
+	}
+	return out + "\"";
+}
+
+/** A number as a JSON value. Non-finite values, which JSON cannot hold,
+ * become `null`. */
+template <typename T>
+std::string json_number(T value)
+{
+	static_assert(std::is_arithmetic_v<T>);
+	if constexpr (std::is_same_v<T, bool>)
+		return value ? "true" : "false";
+	else if constexpr (std::is_integral_v<T>)
+		return std::to_string(value);
+	else
+	{
+		if (!std::isfinite(value)) return "null";
+		char buf[32];
+		std::snprintf(buf, sizeof(buf), "%.9g", static_cast<double>(value));
+		return buf;
+	}
+}
+
+/** A JSON object, with its members in insertion order */
+class JSONObject
+{
+   public:
+	JSONObject() = default;
+
+	JSONObject& add(const std::string& key, const std::string& value)
+	{
+		return add_raw(key, json_string(value));
+	}
+	JSONObject& add(const std::string& key, const char* value)
+	{
+		return add(key, std::string(value));
+	}
+	template <
+		typename T, std::enable_if_t<std::is_arithmetic_v<T>, int> = 0>
+	JSONObject& add(const std::string& key, T value)
+	{
+		return add_raw(key, json_number(value));
+	}
+	JSONObject& add(const std::string& key, const JSONObject& value)
+	{
+		return add_raw(key, value.asString());
+	}
+	JSONObject& add(
+		const std::string& key, const std::vector<JSONObject>& values)
+	{
+		std::string s = "[";
+		for (size_t i = 0; i < values.size(); i++)
+			s += (i ? ", " : "") + values[i].asString();
+		return add_raw(key, s + "]");
+	}
+
+	/** The object as JSON text. With `multiline`, one top-level member per
+	 * line, for easier diffs between benchmark runs. */
+	std::string asString(bool multiline = false) const
+	{
+		std::string s = "{";
+		for (size_t i = 0; i < members_.size(); i++)
+		{
+			if (i) s += ",";
+			s += multiline ? "\n  " : (i ? " " : "");
+			s += json_string(members_[i].first) + ": " + members_[i].second;
+		}
+		return s + (multiline ? "\n}\n" : "}");
+	}
+
+	/// Saves the object to a file. Returns false on errors.
+	bool saveToFile(const std::string& file) const
+	{
+		std::ofstream f(file);
+		if (!f.is_open()) return false;
+		f << asString(true);
+		return f.good();
+	}
+
+   private:
+	JSONObject& add_raw(const std::string& key, const std::string& value)
+	{
+		members_.emplace_back(key, value);
+		return *this;
+	}
+
+	std::vector<std::pair<std::string, std::string>> members_;
+};
+
+/** Statistics of a set of values: mean, nearest-rank percentiles and
+ * maximum. */
+struct Summary
+{
+	Summary() = default;
+	explicit Summary(std::vector<double> v)
+	{
+		count = v.size();
+		if (v.empty()) return;
+		std::sort(v.begin(), v.end());
+		double sum = 0;
+		for (const double x : v) sum += x;
+		mean = sum / v.size();
+		auto pct = [&v](double p)
+		{
+			const auto n = static_cast<size_t>(std::ceil(p * v.size()));
+			return v[std::clamp<size_t>(n, 1, v.size()) - 1];
+		};
+		p50 = pct(0.50);
+		p90 = pct(0.90);
+		p95 = pct(0.95);
+		p99 = pct(0.99);
+		max = v.back();
+	}
+
+	size_t count = 0;
+	double mean = 0, p50 = 0, p90 = 0, p95 = 0, p99 = 0, max = 0;
+
+	/// All values multiplied by `scale`, e.g. 1e3 for [s] to [ms]
+	JSONObject asJSON(double scale = 1.0) const
+	{
+		JSONObject o;
+		o.add("mean", scale * mean)
+			.add("p50", scale * p50)
+			.add("p90", scale * p90)
+			.add("p95", scale * p95)
+			.add("p99", scale * p99)
+			.add("max", scale * max);
+		return o;
+	}
+
+	std::string asString(double scale = 1.0, int decimals = 3) const
+	{
+		std::ostringstream ss;
+		ss << std::fixed << std::setprecision(decimals)
+		   << "mean=" << scale * mean << " p50=" << scale * p50
+		   << " p90=" << scale * p90 << " p95=" << scale * p95
+		   << " p99=" << scale * p99 << " max=" << scale * max;
+		return ss.str();
+	}
+};
+
+/** Thresholds on benchmark results, for use in CI. Failed checks are
+ * reported to stderr, and make exitCode() return 2 (1 is left for usage
+ * and I/O errors). Thresholds <= 0 disable their check. */
+class RegressionGates
+{
+   public:
+	RegressionGates() = default;
+
+	void checkAtMost(
+		const std::string& what, double value, double threshold,
+		const std::string& units = {})
+	{
+		if (threshold > 0 && value > threshold)
+			fail(what, value, "above", threshold, units);
+	}
+
+	void checkAtLeast(
+		const std::string& what, double value, double threshold,
+		const std::string& units = {})
+	{
+		if (threshold > 0 && value < threshold)
+			fail(what, value, "below", threshold, units);
+	}
+
+	bool failed() const { return failed_; }
+	int exitCode() const { return failed_ ? 2 : 0; }
+
+   private:
+	bool failed_ = false;
+
+	void fail(
+		const std::string& what, double value, const char* relation,
+		double threshold, const std::string& units)
+	{
+		const std::string u = units.empty() ? "" : " " + units;
+		std::ostringstream ss;
+		ss << std::fixed << std::setprecision(3) << "REGRESSION: " << what
+		   << " " << value << u << " is " << relation << " the threshold "
+		   << threshold << u << "\n";
+		std::cerr << ss.str();
+		failed_ = true;
+	}
+};
+
+}  // namespace mrpt_nav_common::benchmark
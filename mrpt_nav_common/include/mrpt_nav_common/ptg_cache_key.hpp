@@ -0,0 +1,30 @@
+/* +------------------------------------------------------------------------+
+   |                             mrpt_navigation                            |
+   |                                                                        |
+   | Copyright (c) 2014-2024, Individual contributors, see commit authors   |
+   | See: https://github.com/mrpt-ros-pkg/mrpt_navigation                   |
+   | All rights reserved. Released under BSD 3-Clause license. See LICENSE  |
+   +------------------------------------------------------------------------+ */
+
+#pragma once
+
+#include <mrpt/config/CConfigFileBase.h>
+
+#include <string>
+
+namespace mrpt_nav_common
+{
+/** Returns a key (an hexadecimal MD5 hash string) that identifies the PTG
+ * tables built from the given section of a config file, to name on-disk
+ * caches of them.
+ *
+ * It depends on the MRPT version, since the tables file format may change
+ * between versions, on all the key-value pairs of that section, but not on
+ * their order, comments or other sections, and on `extra`: anything else the
+ * tables depend on, e.g. a robot shape not defined in that section.
+ */
+std::string ptg_cache_key(
+	const mrpt::config::CConfigFileBase& cfg, const std::string& section,
+	const std::string& extra = {});
+
+}  // namespace mrpt_nav_common
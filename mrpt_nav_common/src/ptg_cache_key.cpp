@@ -0,0 +1,31 @@
+/* +------------------------------------------------------------------------+
+   |                             mrpt_navigation                            |
+   |                                                                        |
+   | Copyright (c) 2014-2024, Individual contributors, see commit authors   |
+   | See: https://github.com/mrpt-ros-pkg/mrpt_navigation                   |
+   | All rights reserved. Released under BSD 3-Clause license. See LICENSE  |
+   +------------------------------------------------------------------------+ */
+
+#include <mrpt/system/md5.h>
+#include <mrpt/version.h>
+#include <mrpt_nav_common/ptg_cache_key.hpp>
+
+#include <algorithm>
+#include <vector>
+
+std::string mrpt_nav_common::ptg_cache_key(
+	const mrpt::config::CConfigFileBase& cfg, const std::string& section,
+	const std::string& extra)
+{
+	std::string s = MRPT_VERSION_STR "\n";
+
+	std::vector<std::string> keys;
+	cfg.getAllKeys(section, keys);
+	std::sort(keys.begin(), keys.end());
+	for (const auto& k : keys)
+		s += k + "=" + cfg.read_string(section, k, "") + "\n";
+
+	s += extra;
+
+	return mrpt::system::md5(s);
+}
@@ -0,0 +1,59 @@
+/* +------------------------------------------------------------------------+
+   |                             mrpt_navigation                            |
+   |                                                                        |
+   | Copyright (c) 2014-2024, Individual contributors, see commit authors   |
+   | See: https://github.com/mrpt-ros-pkg/mrpt_navigation                   |
+   | All rights reserved. Released under BSD 3-Clause license. See LICENSE  |
+   +------------------------------------------------------------------------+ */
+
+#include <gtest/gtest.h>
+#include <mrpt/config/CConfigFileMemory.h>
+#include <mrpt_nav_common/ptg_cache_key.hpp>
+
+using mrpt_nav_common::ptg_cache_key;
+
+TEST(PTGCacheKey, DependsOnlyOnSectionValuesAndExtra)
+{
+	const std::string ini =
+		"[SelfDriving]\n"
+		"PTG_COUNT = 1\n"
+		"PTG0_Type = ptg_diff_drive_C\n"
+		"RobotModel_circular_shape_radius = 0.3\n"
+		"[Other]\n"
+		"x = 1\n";
+
+	mrpt::config::CConfigFileMemory cfg(ini);
+	const auto key = ptg_cache_key(cfg, "SelfDriving");
+	EXPECT_EQ(key.size(), 32U);
+	EXPECT_EQ(ptg_cache_key(cfg, "SelfDriving"), key);
+
+	// Comments, key order and other sections do not matter:
+	mrpt::config::CConfigFileMemory cfg2(
+		"# comment\n"
+		"[SelfDriving]\n"
+		"RobotModel_circular_shape_radius = 0.3\n"
+		"PTG0_Type = ptg_diff_drive_C\n"
+		"PTG_COUNT = 1\n"
+		"[Other]\n"
+		"x = 1\n"
+		"y = 2\n");
+	EXPECT_EQ(ptg_cache_key(cfg2, "SelfDriving"), key);
+
+	// Values in the section do, either changed or new ones:
+	cfg2.write("SelfDriving", "RobotModel_circular_shape_radius", 0.4);
+	EXPECT_NE(ptg_cache_key(cfg2, "SelfDriving"), key);
+
+	mrpt::config::CConfigFileMemory cfg3(ini);
+	cfg3.write("SelfDriving", "PTG0_Type", std::string("ptg_diff_drive_CS"));
+	EXPECT_NE(ptg_cache_key(cfg3, "SelfDriving"), key);
+
+	mrpt::config::CConfigFileMemory cfg4(ini);
+	cfg4.write("SelfDriving", "PTG0_K", 1.0);
+	EXPECT_NE(ptg_cache_key(cfg4, "SelfDriving"), key);
+
+	// ...and so does the extra data:
+	const auto keyShape = ptg_cache_key(cfg, "SelfDriving", "0.3\n");
+	EXPECT_NE(keyShape, key);
+	EXPECT_EQ(ptg_cache_key(cfg, "SelfDriving", "0.3\n"), keyShape);
+	EXPECT_NE(ptg_cache_key(cfg, "SelfDriving", "0.35\n"), keyShape);
+}
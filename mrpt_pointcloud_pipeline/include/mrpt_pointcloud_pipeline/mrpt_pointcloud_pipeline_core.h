@@ -0,0 +1,114 @@
+/* +------------------------------------------------------------------------+
+   |                             mrpt_navigation                            |
+   |                                                                        |
+   | Copyright (c) 2014-2024, Individual contributors, see commit authors   |
+   | See: https://github.com/mrpt-ros-pkg/mrpt_navigation                   |
+   | All rights reserved. Released under BSD 3-Clause license. See LICENSE  |
+   +------------------------------------------------------------------------+ */
+
+#pragma once
+
+#include <mp2p_icp/metricmap.h>
+#include <mp2p_icp_filters/FilterBase.h>
+#include <mp2p_icp_filters/Generator.h>
+#include <mrpt/containers/yaml.h>
+#include <mrpt/obs/CObservation.h>
+#include <mrpt/poses/CPose3D.h>
+#include <mrpt/system/COutputLogger.h>
+#include <mrpt/system/CTimeLogger.h>
+
+#include <map>
+#include <mutex>
+#include <string>
+
+/**
+ * The core C++ non-ROS part of the local obstacles node: keeps the time
+ * window of recent observations and runs the mp2p_icp generators and filter
+ * pipelines over them to build the local obstacle map(s).
+ *
+ * It is used by the ROS 2 node, but also by offline tools (e.g. the
+ * benchmark app) that feed observations read from rawlog files.
+ */
+class LocalObstaclesCore : public mrpt::system::COutputLogger
+{
+   public:
+	LocalObstaclesCore();
+	virtual ~LocalObstaclesCore() = default;
+
+	struct Parameters
+	{
+		Parameters() = default;
+
+		//!< In secs (default: 0.2).
+		double time_window = 0.20;
+
+		//!< If true, only the first observation of each topic in the time
+		//!< window is used.
+		bool one_observation_per_topic = false;
+	};
+
+	Parameters params;
+
+	/// Sensor data:
+	struct InfoPerTimeStep
+	{
+		std::string sourceTopic;
+		mrpt::obs::CObservation::Ptr observation;
+		mrpt::poses::CPose3D robot_pose;
+	};
+	using obs_list_t = std::multimap<double, InfoPerTimeStep>;
+
+	/** @name Main API
+	 *  @{ */
+
+	/** Loads the generators and pipelines from a YAML file with the entries
+	 * `generators`, `per_observation`, and `final`.
+	 * Refer to mp2p_icp docs.
+	 */
+	void load_pipeline_from_yaml_file(const std::string& yamlFile);
+
+	/// \overload
+	void load_pipeline_from_yaml(const mrpt::containers::yaml& cfg);
+
+	/** Inserts a new observation into the history. The robot pose must be
+	 * given in the reference frame (typ: /odom).
+	 *  Multi thread safe.
+	 */
+	void add_observation(double timestamp, const InfoPerTimeStep& ipt);
+
+	/** Removes the observations older than the time window (wrt the latest
+	 * one) and returns a local copy of the remaining ones, already applying
+	 * the `one_observation_per_topic` option.
+	 *  Multi thread safe.
+	 */
+	obs_list_t latch_observation_window();
+
+	/** Builds the local map from the given observations, each one relative
+	 * to the robot at its own timestamp (no motion compensation is applied),
+	 * and applies the final filtering pipeline.
+	 */
+	mp2p_icp::metric_map_t build_local_map(const obs_list_t& obs);
+
+	/// Number of observations in the history (multi thread safe).
+	size_t history_size() const;
+
+	/// Empties the observation history (multi thread safe).
+	void clear_history();
+
+	/** @} */
+
+	mrpt::system::CTimeLogger& profiler() { return profiler_; }
+
+   private:
+	/// The history of past observations during the interest time window.
+	obs_list_t hist_obs_;
+	mutable std::mutex hist_obs_mtx_;
+
+	/// Used for example to run voxel grid decimation, etc.
+	/// Refer to mp2p_icp docs
+	mp2p_icp_filters::FilterPipeline per_obs_pipeline_, final_pipeline_;
+	mp2p_icp_filters::GeneratorSet generator_;
+
+	mrpt::system::CTimeLogger profiler_{
+		true /*enabled*/, "mrpt_pointcloud_pipeline" /*name*/};
+};
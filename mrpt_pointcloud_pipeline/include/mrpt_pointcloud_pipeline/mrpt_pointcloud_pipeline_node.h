@@ -25,9 +25,11 @@
 #include <mrpt/ros2bridge/laser_scan.h>
 #include <mrpt/ros2bridge/point_cloud2.h>
 #include <mrpt/ros2bridge/pose.h>
+#include <mrpt/system/CTicTac.h>
 #include <mrpt/system/CTimeLogger.h>
 #include <mrpt/system/filesystem.h>
 #include <mrpt/system/string_utils.h>
+#include <mrpt_pointcloud_pipeline/mrpt_pointcloud_pipeline_core.h>
 
 /* ros2 deps */
 #include <tf2_ros/buffer.h>
@@ -57,6 +59,9 @@ class LocalObstaclesNode : public rclcpp::Node
 	/* Dtor*/
 	~LocalObstaclesNode() {}
 
+	/// Number of threads for the multi-threaded executor (0=auto)
+	size_t executor_threads() const { return m_executor_threads; }
+
    private:
 	/* Read parameters from the node handle*/
 	void read_parameters();
@@ -98,13 +103,19 @@ class LocalObstaclesNode : public rclcpp::Node
 		}
 		for (const auto& source : lstSources)
 		{
+			// Sensor callbacks run in a reentrant group, in parallel to each
+			// other and to the publishing timer:
+			rclcpp::SubscriptionOptions subOpts;
+			subOpts.callback_group = m_cbgroup_sensors;
+
 			const auto sub = this->create_subscription<MessageT>(
-				source, 1,
+				source, m_sensor_queue_size,
 				[source, callback,
 				 this](const typename MessageT::SharedPtr msg) {
 					callback(msg, source);
-				});
-			subscriptions.push_back(sub);  // 1 is the queue size
+				},
+				subOpts);
+			subscriptions.push_back(sub);
 			num_subscriptions++;
 		}
 
@@ -112,36 +123,64 @@ class LocalObstaclesNode : public rclcpp::Node
 		return num_subscriptions;
 	}
 
+	/** Like CTimeLoggerEntry, but safe to use from callbacks running in
+	 * parallel in the multi-threaded executor. */
+	class ProfilerEntry
+	{
+	   public:
+		ProfilerEntry(LocalObstaclesNode& node, const char* name)
+			: m_node(node), m_name(name)
+		{
+		}
+		~ProfilerEntry() { stop(); }
+
+		void stop()
+		{
+			if (m_stopped) return;
+			m_stopped = true;
+			const double dt = m_tictac.Tac();
+			std::lock_guard<std::mutex> lck(m_node.m_profiler_mtx);
+			m_node.m_profiler.registerUserMeasure(m_name, dt, true);
+		}
+
+	   private:
+		LocalObstaclesNode& m_node;
+		const char* m_name;
+		mrpt::system::CTicTac m_tictac;
+		bool m_stopped = false;
+	};
+
 	// member variables
 	CTimeLogger m_profiler;
+	std::mutex m_profiler_mtx;	//!< Use via ProfilerEntry
 	bool m_show_gui = false;
-	bool m_one_observation_per_topic = false;
 	std::string m_frameid_reference = "odom";  //!< type:"odom"
 	std::string m_frameid_robot = "base_link";	//!< type: "base_link"
 	std::string m_topics_source_2dscan =
 		"scan, laser1";	 //!< Default: "scan, laser1"
 	std::string m_topics_source_pointclouds = "";
 
-	//!< In secs (default: 0.2). Can't be smaller than m_publish_period
-	double m_time_window = 0.20;
-
-	//!< In secs (default: 0.05). Can't be larger than m_time_window
+	//!< In secs (default: 0.05). Can't be larger than the core time_window
 	double m_publish_period = 0.05;
 
 	rclcpp::TimerBase::SharedPtr m_timer_publish;
 
-	// Sensor data:
-	struct InfoPerTimeStep
-	{
-		std::string sourceTopic;
-		CObservation::Ptr observation;
-		mrpt::poses::CPose3D robot_pose;
-	};
-	using obs_list_t = std::multimap<double, InfoPerTimeStep>;
+	//!< Queue depth of each sensor subscription (default: 1)
+	int m_sensor_queue_size = 1;
+
+	//!< Threads for the multi-threaded executor (default: 0=auto)
+	size_t m_executor_threads = 0;
+
+	/// Sensor conversion (reentrant) and publishing (mutually exclusive)
+	/// stages run in different groups, so they do not delay each other.
+	rclcpp::CallbackGroup::SharedPtr m_cbgroup_sensors, m_cbgroup_publish;
+
+	using InfoPerTimeStep = LocalObstaclesCore::InfoPerTimeStep;
+	using obs_list_t = LocalObstaclesCore::obs_list_t;
 
-	/// The history of past observations duringthe interest time window.
-	obs_list_t m_hist_obs;
-	std::mutex m_hist_obs_mtx;	//!< mutex
+	/// The ROS-agnostic part: observation time window, generators and
+	/// filter pipelines.
+	LocalObstaclesCore m_core;
 
 	mrpt::gui::CDisplayWindow3D::Ptr m_gui_win;
 	bool m_visible_raw = true, m_visible_output = true;
@@ -149,8 +188,6 @@ class LocalObstaclesNode : public rclcpp::Node
 	/// Used for example to run voxel grid decimation, etc.
 	/// Refer to mp2p_icp docs
 	std::string m_pipeline_yaml_file;
-	mp2p_icp_filters::FilterPipeline m_per_obs_pipeline, m_final_pipeline;
-	mp2p_icp_filters::GeneratorSet m_generator;
 
 	struct LayerTopicNames
 	{
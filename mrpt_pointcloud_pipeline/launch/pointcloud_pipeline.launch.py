@@ -42,6 +42,15 @@ def generate_launch_description():
         'one_observation_per_topic',
         default_value='false'
     )
+    sensor_queue_size_arg = DeclareLaunchArgument(
+        'sensor_queue_size',
+        default_value='1'
+    )
+    executor_threads_arg = DeclareLaunchArgument(
+        'executor_threads',
+        default_value='0',
+        description='Number of threads of the multi-threaded executor (0=auto)'
+    )
     pipeline_yaml_file_arg = DeclareLaunchArgument(
         'pipeline_yaml_file',
         default_value=os.path.join(
@@ -95,6 +104,8 @@ def generate_launch_description():
             {'frameid_robot': LaunchConfiguration('frameid_robot')},
             {'one_observation_per_topic': LaunchConfiguration(
                 'one_observation_per_topic')},
+            {'sensor_queue_size': LaunchConfiguration('sensor_queue_size')},
+            {'executor_threads': LaunchConfiguration('executor_threads')},
         ],
         arguments=['--ros-args', '--log-level',
                    LaunchConfiguration('log_level')],
@@ -113,6 +124,8 @@ def generate_launch_description():
         frameid_robot_arg,
         log_level_launch_arg,
         one_observation_per_topic_arg,
+        sensor_queue_size_arg,
+        executor_threads_arg,
         mrpt_pointcloud_pipeline_node,
     ])
 
@@ -0,0 +1,149 @@
+/* +------------------------------------------------------------------------+
+   |                             mrpt_navigation                            |
+   |                                                                        |
+   | Copyright (c) 2014-2024, Individual contributors, see commit authors   |
+   | See: https://github.com/mrpt-ros-pkg/mrpt_navigation                   |
+   | All rights reserved. Released under BSD 3-Clause license. See LICENSE  |
+   +------------------------------------------------------------------------+ */
+
+#include <mp2p_icp/icp_pipeline_from_yaml.h>
+#include <mrpt/core/lock_helper.h>
+#include <mrpt/system/filesystem.h>
+#include <mrpt_pointcloud_pipeline/mrpt_pointcloud_pipeline_core.h>
+
+#include <iterator>
+#include <set>
+
+using mrpt::system::CTimeLoggerEntry;
+
+LocalObstaclesCore::LocalObstaclesCore()
+	: mrpt::system::COutputLogger("LocalObstaclesCore")
+{
+}
+
+void LocalObstaclesCore::load_pipeline_from_yaml_file(
+	const std::string& yamlFile)
+{
+	ASSERT_FILE_EXISTS_(yamlFile);
+	load_pipeline_from_yaml(mrpt::containers::yaml::FromFile(yamlFile));
+}
+
+void LocalObstaclesCore::load_pipeline_from_yaml(
+	const mrpt::containers::yaml& cfg)
+{
+	ASSERT_(cfg.has("generators"));
+	ASSERT_(cfg.has("per_observation"));
+	ASSERT_(cfg.has("final"));
+
+	generator_ = mp2p_icp_filters::generators_from_yaml(cfg["generators"]);
+	per_obs_pipeline_ =
+		mp2p_icp_filters::filter_pipeline_from_yaml(cfg["per_observation"]);
+	final_pipeline_ = mp2p_icp_filters::filter_pipeline_from_yaml(cfg["final"]);
+}
+
+void LocalObstaclesCore::add_observation(
+	double timestamp, const InfoPerTimeStep& ipt)
+{
+	auto lck = mrpt::lockHelper(hist_obs_mtx_);
+	hist_obs_.insert(hist_obs_.end(), obs_list_t::value_type(timestamp, ipt));
+}
+
+size_t LocalObstaclesCore::history_size() const
+{
+	auto lck = mrpt::lockHelper(hist_obs_mtx_);
+	return hist_obs_.size();
+}
+
+void LocalObstaclesCore::clear_history()
+{
+	auto lck = mrpt::lockHelper(hist_obs_mtx_);
+	hist_obs_.clear();
+}
+
+LocalObstaclesCore::obs_list_t LocalObstaclesCore::latch_observation_window()
+{
+	// Purge old observations & latch a local copy:
+	obs_list_t obs;
+	{
+		CTimeLoggerEntry tle(profiler_, "latch_observation_window.removingOld");
+		auto lck = mrpt::lockHelper(hist_obs_mtx_);
+
+		// Purge old obs:
+		if (!hist_obs_.empty())
+		{
+			const double last_time = hist_obs_.rbegin()->first;
+			obs_list_t::iterator it_first_valid =
+				hist_obs_.lower_bound(last_time - params.time_window);
+			const size_t nToRemove =
+				std::distance(hist_obs_.begin(), it_first_valid);
+			MRPT_LOG_DEBUG_FMT(
+				"[latch_observation_window] Removing %u old entries, "
+				"last_time=%lf",
+				static_cast<unsigned int>(nToRemove), last_time);
+			hist_obs_.erase(hist_obs_.begin(), it_first_valid);
+		}
+		// Local copy in this thread:
+		obs = hist_obs_;
+	}
+
+	// Keep only one obs per topic?
+	if (params.one_observation_per_topic)
+	{
+		// TODO(jlbc): Remove in reverse order to keep the latest one!
+		std::set<std::string> foundTopics;
+		for (auto it = obs.begin(); it != obs.end();)
+		{
+			const auto& topic = it->second.sourceTopic;
+			if (foundTopics.count(topic) != 0)
+			{
+				// duplicated entry, delete:
+				it = obs.erase(it);
+			}
+			else
+			{
+				foundTopics.insert(topic);
+				++it;  // move on:
+			}
+		}
+	}
+
+	return obs;
+}
+
+mp2p_icp::metric_map_t LocalObstaclesCore::build_local_map(
+	const obs_list_t& obs)
+{
+	CTimeLoggerEntry tle(profiler_, "build_local_map");
+
+	MRPT_LOG_DEBUG_FMT(
+		"[build_local_map] Building local map with %u observations",
+		static_cast<unsigned int>(obs.size()));
+
+	mp2p_icp::metric_map_t mm;
+
+	// Insert each observation into the map:
+	for (const auto& [timestamp, ipt] : obs)
+	{
+		// Insert obs:
+		CTimeLoggerEntry tleObsFilter(
+			profiler_, "build_local_map.apply_per_obs_pipeline");
+
+		// Apply optional generators for auxiliary map layers, etc:
+		mp2p_icp_filters::apply_generators(generator_, *ipt.observation, mm);
+
+		// per-observation filtering:
+		mp2p_icp_filters::apply_filter_pipeline(per_obs_pipeline_, mm);
+
+		tleObsFilter.stop();
+	}
+
+	// Apply final filtering:
+	CTimeLoggerEntry tleFilter(
+		profiler_, "build_local_map.apply_final_pipeline");
+
+	mp2p_icp_filters::apply_filter_pipeline(final_pipeline_, mm);
+
+	tleFilter.stop();
+
+	return mm;
+}
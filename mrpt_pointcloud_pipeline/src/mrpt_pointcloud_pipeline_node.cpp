@@ -25,8 +25,44 @@ LocalObstaclesNode::LocalObstaclesNode(const rclcpp::NodeOptions& options)
 {
 	m_profiler.setName(Node::get_name());
 
+	// Redirect MRPT logger to ROS logger:
+	m_core.logging_enable_console_output = false;  // No console, go thru ROS
+	m_core.logRegisterCallback(
+		[this](
+			std::string_view msg, const mrpt::system::VerbosityLevel level,
+			[[maybe_unused]] std::string_view loggerName,
+			[[maybe_unused]] const mrpt::Clock::time_point timestamp)
+		{
+			switch (level)
+			{
+				case mrpt::system::LVL_DEBUG:
+					RCLCPP_DEBUG_STREAM(this->get_logger(), msg);
+					break;
+				case mrpt::system::LVL_INFO:
+					RCLCPP_INFO_STREAM(this->get_logger(), msg);
+					break;
+				case mrpt::system::LVL_WARN:
+					RCLCPP_WARN_STREAM(this->get_logger(), msg);
+					break;
+				case mrpt::system::LVL_ERROR:
+					RCLCPP_ERROR_STREAM(this->get_logger(), msg);
+					break;
+				default:
+					break;
+			};
+		});
+	// Effective level: the logger own level is UNSET (0) by default.
+	if (rcutils_logging_get_logger_effective_level(get_logger().get_name()) <=
+		RCUTILS_LOG_SEVERITY_DEBUG)
+		m_core.setMinLoggingLevel(mrpt::system::LVL_DEBUG);
+
 	read_parameters();
 
+	m_cbgroup_sensors =
+		create_callback_group(rclcpp::CallbackGroupType::Reentrant);
+	m_cbgroup_publish =
+		create_callback_group(rclcpp::CallbackGroupType::MutuallyExclusive);
+
 	// Init ROS subs:
 	// Subscribe to one or more laser sources:
 	size_t nSubsTotal = 0;
@@ -66,59 +102,16 @@ LocalObstaclesNode::LocalObstaclesNode(const rclcpp::NodeOptions& options)
 
 	m_timer_publish = create_wall_timer(
 		std::chrono::duration<double>(m_publish_period),
-		[this]() { this->on_do_publish(); });
+		[this]() { this->on_do_publish(); }, m_cbgroup_publish);
 }  // end ctor
 
 /** Callback: On recalc local map & publish it */
 void LocalObstaclesNode::on_do_publish()
 {
-	CTimeLoggerEntry tle(m_profiler, "on_do_publish");
+	ProfilerEntry tle(*this, "on_do_publish");
 
 	// Purge old observations & latch a local copy:
-	obs_list_t obs;
-	{
-		CTimeLoggerEntry tle(m_profiler, "onDoPublish.removingOld");
-		m_hist_obs_mtx.lock();
-
-		// Purge old obs:
-		if (!m_hist_obs.empty())
-		{
-			const double last_time = m_hist_obs.rbegin()->first;
-			obs_list_t::iterator it_first_valid =
-				m_hist_obs.lower_bound(last_time - m_time_window);
-			const size_t nToRemove =
-				std::distance(m_hist_obs.begin(), it_first_valid);
-			RCLCPP_DEBUG(
-				get_logger(),
-				"[onDoPublish] Removing %u old entries, last_time=%lf",
-				static_cast<unsigned int>(nToRemove), last_time);
-			m_hist_obs.erase(m_hist_obs.begin(), it_first_valid);
-		}
-		// Local copy in this thread:
-		obs = m_hist_obs;
-		m_hist_obs_mtx.unlock();
-	}
-
-	// Keep only one obs per topic?
-	if (m_one_observation_per_topic)
-	{
-		// TODO(jlbc): Remove in reverse order to keep the latest one!
-		std::set<std::string> foundTopics;
-		for (auto it = obs.begin(); it != obs.end();)
-		{
-			const auto& topic = it->second.sourceTopic;
-			if (foundTopics.count(topic) != 0)
-			{
-				// duplicated entry, delete:
-				it = obs.erase(it);
-			}
-			else
-			{
-				foundTopics.insert(topic);
-				++it;  // move on:
-			}
-		}
-	}
+	const obs_list_t obs = m_core.latch_observation_window();
 
 	RCLCPP_DEBUG(
 		get_logger(), "Building local map with %u observations.",
@@ -126,69 +119,28 @@ void LocalObstaclesNode::on_do_publish()
 
 	if (obs.empty()) return;
 
-	// Build local map(s):
-	// -----------------------------------------------
-	mp2p_icp::metric_map_t mm;
-
+	// Get the latest robot pose in the reference frame (typ: /odom ->
+	// /base_link), to show the observation poses relative to it in the GUI:
 	mrpt::poses::CPose3D curRobotPose;
+	try
 	{
-		CTimeLoggerEntry tle2(m_profiler, "on_do_publish.buildLocalMap");
-
-		// Get the latest robot pose in the reference frame (typ: /odom ->
-		// /base_link)
-		// so we can build the local map RELATIVE to it:
-
-		try
-		{
-			geometry_msgs::msg::TransformStamped tx;
-			tx = m_tf_buffer->lookupTransform(
-				m_frameid_reference, m_frameid_robot, tf2::TimePointZero);
-
-			tf2::Transform tfx;
-			tf2::fromMsg(tx.transform, tfx);
-			curRobotPose = mrpt::ros2bridge::fromROS(tfx);
-		}
-		catch (const tf2::ExtrapolationException& ex)
-		{
-			RCLCPP_ERROR(get_logger(), "%s", ex.what());
-			return;
-		}
-
-		RCLCPP_DEBUG(
-			get_logger(),
-			"[onDoPublish] Building local map relative to latest robot "
-			"pose: %s",
-			curRobotPose.asString().c_str());
-
-		// For each observation: compute relative robot pose & insert obs
-		// into map:
-		for (const auto& [timestamp, ipt] : obs)
-		{
-			// Relative pose in the past:
-			const mrpt::poses::CPose3D relPose = ipt.robot_pose - curRobotPose;
+		geometry_msgs::msg::TransformStamped tx;
+		tx = m_tf_buffer->lookupTransform(
+			m_frameid_reference, m_frameid_robot, tf2::TimePointZero);
 
-			// Insert obs:
-			CTimeLoggerEntry tleObsFilter(
-				m_profiler, "on_do_publish.apply_per_obs_pipeline");
-
-			// Apply optional generators for auxiliary map layers, etc:
-			mp2p_icp_filters::apply_generators(
-				m_generator, *ipt.observation, mm);
-
-			// per-observation filtering:
-			mp2p_icp_filters::apply_filter_pipeline(m_per_obs_pipeline, mm);
-
-			tleObsFilter.stop();
-		}
+		tf2::Transform tfx;
+		tf2::fromMsg(tx.transform, tfx);
+		curRobotPose = mrpt::ros2bridge::fromROS(tfx);
+	}
+	catch (const tf2::ExtrapolationException& ex)
+	{
+		RCLCPP_ERROR(get_logger(), "%s", ex.what());
+		return;
 	}
 
-	// Apply final filtering:
-	CTimeLoggerEntry tleFilter(
-		m_profiler, "on_do_publish.apply_final_pipeline");
-
-	mp2p_icp_filters::apply_filter_pipeline(m_final_pipeline, mm);
-
-	tleFilter.stop();
+	// Build local map(s) and apply final filtering:
+	// -----------------------------------------------
+	const mp2p_icp::metric_map_t mm = m_core.build_local_map(obs);
 
 	// Publish them:
 	for (auto& e : layer2topic_)
@@ -332,13 +284,12 @@ void LocalObstaclesNode::on_new_sensor_laser_2d(
 	const sensor_msgs::msg::LaserScan::SharedPtr& scan,
 	const std::string& topicName)
 {
-	CTimeLoggerEntry tle(m_profiler, "on_new_sensor_laser_2d");
+	ProfilerEntry tle(*this, "on_new_sensor_laser_2d");
 
 	geometry_msgs::msg::TransformStamped sensorOnRobot;
 	try
 	{
-		CTimeLoggerEntry tle2(
-			m_profiler, "onNewSensor_Laser2D.lookupTransform_sensor");
+		ProfilerEntry tle2(*this, "onNewSensor_Laser2D.lookupTransform_sensor");
 		sensorOnRobot = m_tf_buffer->lookupTransform(
 			m_frameid_robot, scan->header.frame_id, tf2::TimePointZero);
 	}
@@ -374,8 +325,7 @@ void LocalObstaclesNode::on_new_sensor_laser_2d(
 	mrpt::poses::CPose3D robotPose;
 	try
 	{
-		CTimeLoggerEntry tle3(
-			m_profiler, "onNewSensor_Laser2D.lookupTransform_robot");
+		ProfilerEntry tle3(*this, "onNewSensor_Laser2D.lookupTransform_robot");
 
 		geometry_msgs::msg::TransformStamped robotTfStamp;
 		try
@@ -411,9 +361,7 @@ void LocalObstaclesNode::on_new_sensor_laser_2d(
 	ipt.observation = obsScan;
 	ipt.robot_pose = robotPose;
 
-	m_hist_obs_mtx.lock();
-	m_hist_obs.insert(m_hist_obs.end(), obs_list_t::value_type(timestamp, ipt));
-	m_hist_obs_mtx.unlock();
+	m_core.add_observation(timestamp, ipt);
 
 }  // end on_new_sensor_laser_2d
 
@@ -421,14 +369,14 @@ void LocalObstaclesNode::on_new_sensor_pointcloud(
 	const sensor_msgs::msg::PointCloud2::SharedPtr& pts,
 	const std::string& topicName)
 {
-	CTimeLoggerEntry tle(m_profiler, "on_new_sensor_pointcloud");
+	ProfilerEntry tle(*this, "on_new_sensor_pointcloud");
 
 	// Get the relative position of the sensor wrt the robot:
 	geometry_msgs::msg::TransformStamped sensorOnRobot;
 	try
 	{
-		CTimeLoggerEntry tle2(
-			m_profiler, "on_new_sensor_pointcloud.lookupTransform_sensor");
+		ProfilerEntry tle2(
+			*this, "on_new_sensor_pointcloud.lookupTransform_sensor");
 
 		sensorOnRobot = m_tf_buffer->lookupTransform(
 			m_frameid_robot, pts->header.frame_id, tf2::TimePointZero);
@@ -470,8 +418,8 @@ void LocalObstaclesNode::on_new_sensor_pointcloud(
 	mrpt::poses::CPose3D robotPose;
 	try
 	{
-		CTimeLoggerEntry tle3(
-			m_profiler, "onNewSensor_pointcloud.lookupTransform_robot");
+		ProfilerEntry tle3(
+			*this, "onNewSensor_pointcloud.lookupTransform_robot");
 
 		geometry_msgs::msg::TransformStamped robotTfStamp;
 		try
@@ -507,9 +455,7 @@ void LocalObstaclesNode::on_new_sensor_pointcloud(
 	ipt.observation = obsPts;
 	ipt.robot_pose = robotPose;
 
-	m_hist_obs_mtx.lock();
-	m_hist_obs.insert(m_hist_obs.end(), obs_list_t::value_type(timestamp, ipt));
-	m_hist_obs_mtx.unlock();
+	m_core.add_observation(timestamp, ipt);
 }  // end on_new_sensor_pointcloud
 
 // read params from parameter server
@@ -529,23 +475,37 @@ void LocalObstaclesNode::read_parameters()
 	RCLCPP_INFO(get_logger(), "frameid_robot: %s", m_frameid_robot.c_str());
 
 	this->declare_parameter<double>("time_window", 0.20);
-	this->get_parameter("time_window", m_time_window);
-	RCLCPP_INFO(get_logger(), "time_window: %f", m_time_window);
+	this->get_parameter("time_window", m_core.params.time_window);
+	RCLCPP_INFO(get_logger(), "time_window: %f", m_core.params.time_window);
 
 	this->declare_parameter<bool>(
-		"one_observation_per_topic", m_one_observation_per_topic);
+		"one_observation_per_topic", m_core.params.one_observation_per_topic);
 	this->get_parameter(
-		"one_observation_per_topic", m_one_observation_per_topic);
+		"one_observation_per_topic", m_core.params.one_observation_per_topic);
 	RCLCPP_INFO(
 		get_logger(), "one_observation_per_topic: %s",
-		m_one_observation_per_topic ? "true" : "false");
+		m_core.params.one_observation_per_topic ? "true" : "false");
 
 	this->declare_parameter<double>("publish_period", 0.05);
 	this->get_parameter("publish_period", m_publish_period);
 	RCLCPP_INFO(get_logger(), "publish_period: %f", m_publish_period);
 
-	// publish_period can't be larger than m_time_window:
-	ASSERT_LE_(m_publish_period, m_time_window);
+	// publish_period can't be larger than time_window:
+	ASSERT_LE_(m_publish_period, m_core.params.time_window);
+
+	this->declare_parameter<int>("sensor_queue_size", m_sensor_queue_size);
+	this->get_parameter("sensor_queue_size", m_sensor_queue_size);
+	RCLCPP_INFO(get_logger(), "sensor_queue_size: %i", m_sensor_queue_size);
+	ASSERT_GE_(m_sensor_queue_size, 1);
+
+	{
+		int nThreads = static_cast<int>(m_executor_threads);
+		this->declare_parameter<int>("executor_threads", nThreads);
+		this->get_parameter("executor_threads", nThreads);
+		RCLCPP_INFO(get_logger(), "executor_threads: %i", nThreads);
+		ASSERT_GE_(nThreads, 0);
+		m_executor_threads = static_cast<size_t>(nThreads);
+	}
 
 	this->declare_parameter<std::string>(
 		"source_topics_2d_scans", "scan, laser1");
@@ -573,15 +533,7 @@ void LocalObstaclesNode::read_parameters()
 
 		RCLCPP_DEBUG_STREAM(get_logger(), cfg);
 
-		ASSERT_(cfg.has("generators"));
-		ASSERT_(cfg.has("per_observation"));
-		ASSERT_(cfg.has("final"));
-
-		m_generator = mp2p_icp_filters::generators_from_yaml(cfg["generators"]);
-		m_per_obs_pipeline =
-			mp2p_icp_filters::filter_pipeline_from_yaml(cfg["per_observation"]);
-		m_final_pipeline =
-			mp2p_icp_filters::filter_pipeline_from_yaml(cfg["final"]);
+		m_core.load_pipeline_from_yaml(cfg);
 	}
 
 	// Output layer(s) ==> ROS topic(s) mapping:
@@ -627,7 +579,11 @@ int main(int argc, char** argv)
 
 	auto node = std::make_shared<LocalObstaclesNode>();
 
-	rclcpp::spin(node);
+	// Sensor ingestion and local map publishing run in parallel:
+	rclcpp::executors::MultiThreadedExecutor executor(
+		rclcpp::ExecutorOptions(), node->executor_threads());
+	executor.add_node(node);
+	executor.spin();
 
 	rclcpp::shutdown();
 
@@ -0,0 +1,306 @@
+/* +------------------------------------------------------------------------+
+   |                             mrpt_navigation                            |
+   |                                                                        |
+   | Copyright (c) 2014-2024, Individual contributors, see commit authors   |
+   | See: https://github.com/mrpt-ros-pkg/mrpt_navigation                   |
+   | All rights reserved. Released under BSD 3-Clause license. See LICENSE  |
+   +------------------------------------------------------------------------+ */
+
+/* Offline benchmark for the local obstacles point cloud pipeline.
+ *
+ * Replays the 2D scans and point clouds of a rawlog file through a
+ * point-cloud-pipeline.yaml file, using the same core class than the ROS 2
+ * node, and reports per-cycle latency percentiles, throughput and memory use.
+ *
+ * Example:
+ *  pointcloud_pipeline_benchmark \
+ *    -r mrpt_tutorials/datasets/driving_in_office_obs.rawlog \
+ *    -p mrpt_pointcloud_pipeline/params/point-cloud-pipeline.yaml
+ */
+
+#include <mrpt/3rdparty/tclap/CmdLine.h>
+#include <mrpt/core/exceptions.h>
+#include <mrpt/core/format.h>
+#include <mrpt/maps/CPointsMap.h>
+#include <mrpt/obs/CActionCollection.h>
+#include <mrpt/obs/CActionRobotMovement2D.h>
+#include <mrpt/obs/CObservation2DRangeScan.h>
+#include <mrpt/obs/CObservation3DRangeScan.h>
+#include <mrpt/obs/CObservationOdometry.h>
+#include <mrpt/obs/CObservationPointCloud.h>
+#include <mrpt/obs/CRawlog.h>
+#include <mrpt/obs/CSensoryFrame.h>
+#include <mrpt/system/CTicTac.h>
+#include <mrpt/system/memory.h>
+#include <mrpt/system/os.h>
+#include <mrpt_nav_common/benchmark_report.hpp>
+#include <mrpt_pointcloud_pipeline/mrpt_pointcloud_pipeline_core.h>
+
+#include <algorithm>
+#include <iostream>
+#include <optional>
+#include <vector>
+
+using namespace mrpt::obs;
+using namespace mrpt_nav_common::benchmark;
+
+// CLI flags:
+static TCLAP::CmdLine cmd(
+	"pointcloud_pipeline_benchmark", ' ', MRPT_getVersion().c_str());
+
+static TCLAP::ValueArg<std::string> arg_rawlog(
+	"r", "rawlog", "Input dataset (*.rawlog) with scans and/or point clouds",
+	true, "", "dataset.rawlog", cmd);
+
+static TCLAP::ValueArg<std::string> arg_pipeline(
+	"p", "pipeline", "Pipeline definition file (point-cloud-pipeline.yaml)",
+	true, "", "pipeline.yaml", cmd);
+
+static TCLAP::ValueArg<double> arg_time_window(
+	"", "time-window", "Observations time window [s] (Default: 0.20)", false,
+	0.20, "0.20", cmd);
+
+static TCLAP::ValueArg<double> arg_publish_period(
+	"", "publish-period",
+	"Period [s] between processing cycles, in dataset time (Default: 0.05)",
+	false, 0.05, "0.05", cmd);
+
+static TCLAP::SwitchArg arg_one_obs_per_topic(
+	"", "one-observation-per-topic",
+	"Keep only one observation per sensor label in each time window", cmd,
+	false);
+
+static TCLAP::ValueArg<unsigned int> arg_repeat(
+	"", "repeat", "Number of times to replay the whole dataset (Default: 1)",
+	false, 1, "1", cmd);
+
+static TCLAP::ValueArg<std::string> arg_json(
+	"", "json", "Optional output file to save the results as JSON", false, "",
+	"results.json", cmd);
+
+static TCLAP::ValueArg<double> arg_max_p99(
+	"", "max-p99-ms",
+	"Maximum 99% percentile [ms] of the processing cycle latency. If given, "
+	"exit with code 2 when it is exceeded.",
+	false, 0.0, "0.0", cmd);
+
+static TCLAP::SwitchArg arg_verbose(
+	"v", "verbose", "Enable debug output of the core class", cmd, false);
+
+namespace
+{
+size_t count_input_points(const CObservation& obs)
+{
+	if (auto o = dynamic_cast<const CObservation2DRangeScan*>(&obs); o)
+		return o->getScanSize();
+	if (auto o = dynamic_cast<const CObservationPointCloud*>(&obs);
+		o && o->pointcloud)
+		return o->pointcloud->size();
+	if (auto o = dynamic_cast<const CObservation3DRangeScan*>(&obs); o)
+		return o->points3D_x.size();
+	return 0;
+}
+
+bool is_handled_observation(const CObservation& obs)
+{
+	return IS_CLASS(obs, CObservation2DRangeScan) ||
+		IS_CLASS(obs, CObservationPointCloud) ||
+		IS_CLASS(obs, CObservation3DRangeScan);
+}
+
+size_t count_output_points(const mp2p_icp::metric_map_t& mm)
+{
+	size_t n = 0;
+	for (const auto& [name, layer] : mm.layers)
+	{
+		if (auto pts = std::dynamic_pointer_cast<mrpt::maps::CPointsMap>(layer);
+			pts)
+			n += pts->size();
+	}
+	return n;
+}
+
+struct BenchmarkStats
+{
+	std::vector<double> cycle_latencies;  //!< [s]
+	size_t input_observations = 0;
+	size_t input_points = 0;  //!< accumulated over all cycles
+	size_t output_points = 0;  //!< accumulated over all cycles
+	unsigned long mem_start = 0, mem_peak = 0;	//!< [bytes]
+};
+
+}  // namespace
+
+int main(int argc, char** argv)
+{
+	try
+	{
+		if (!cmd.parse(argc, argv)) return 1;
+
+		LocalObstaclesCore core;
+		if (arg_verbose.isSet())
+			core.setMinLoggingLevel(mrpt::system::LVL_DEBUG);
+
+		core.params.time_window = arg_time_window.getValue();
+		core.params.one_observation_per_topic = arg_one_obs_per_topic.isSet();
+		core.load_pipeline_from_yaml_file(arg_pipeline.getValue());
+
+		const double publishPeriod = arg_publish_period.getValue();
+		ASSERT_GT_(publishPeriod, 0.0);
+		ASSERT_LE_(publishPeriod, core.params.time_window);
+
+		std::cout << "Loading rawlog: " << arg_rawlog.getValue() << "\n";
+		CRawlog dataset;
+		if (!dataset.loadFromRawLogFile(arg_rawlog.getValue()))
+		{
+			std::cerr << "Error loading rawlog file\n";
+			return 1;
+		}
+		std::cout << "Loaded " << dataset.size() << " entries.\n";
+
+		BenchmarkStats stats;
+		stats.mem_start = mrpt::system::getMemoryUsage();
+		stats.mem_peak = stats.mem_start;
+
+		for (unsigned int rep = 0; rep < arg_repeat.getValue(); rep++)
+		{
+			// Robot pose in the reference frame, from odometry observations
+			// or actions:
+			mrpt::poses::CPose3D robotPose;
+			std::optional<double> nextCycleTime;
+			core.clear_history();
+
+			auto processObservation = [&](const CObservation::Ptr& obs)
+			{
+				if (!obs) return;
+
+				if (auto odo = std::dynamic_pointer_cast<CObservationOdometry>(
+						obs);
+					odo)
+				{
+					robotPose = mrpt::poses::CPose3D(odo->odometry);
+					return;
+				}
+				if (!is_handled_observation(*obs)) return;
+
+				const double t = mrpt::Clock::toDouble(obs->timestamp);
+
+				LocalObstaclesCore::InfoPerTimeStep ipt;
+				ipt.sourceTopic = obs->sensorLabel;
+				ipt.observation = obs;
+				ipt.robot_pose = robotPose;
+				core.add_observation(t, ipt);
+				stats.input_observations++;
+
+				if (!nextCycleTime) nextCycleTime = t;
+				if (t < *nextCycleTime) return;
+				nextCycleTime = t + publishPeriod;
+
+				// Run one cycle, as the node timer would do:
+				mrpt::system::CTicTac tictac;
+
+				const auto obsWindow = core.latch_observation_window();
+				if (obsWindow.empty()) return;
+
+				const auto mm = core.build_local_map(obsWindow);
+
+				stats.cycle_latencies.push_back(tictac.Tac());
+
+				for (const auto& [stamp, o] : obsWindow)
+					stats.input_points += count_input_points(*o.observation);
+				stats.output_points += count_output_points(mm);
+
+				stats.mem_peak = std::max(
+					stats.mem_peak, mrpt::system::getMemoryUsage());
+			};
+
+			for (size_t i = 0; i < dataset.size(); i++)
+			{
+				switch (dataset.getType(i))
+				{
+					case CRawlog::etActionCollection:
+					{
+						const auto acts = dataset.getAsAction(i);
+						if (auto mov = acts->getBestMovementEstimation(); mov)
+							robotPose = robotPose +
+								mrpt::poses::CPose3D(
+											mov->poseChange->getMeanVal());
+					}
+					break;
+					case CRawlog::etSensoryFrame:
+						for (const auto& obs : *dataset.getAsObservations(i))
+							processObservation(obs);
+						break;
+					case CRawlog::etObservation:
+						processObservation(dataset.getAsObservation(i));
+						break;
+					default:
+						break;
+				};
+			}
+		}
+
+		// Report:
+		// -----------------------------------------------
+		const auto& lat = stats.cycle_latencies;
+		if (lat.empty())
+		{
+			std::cerr << "No processing cycle was run: does the rawlog "
+						 "contain 2D scans or point clouds?\n";
+			return 1;
+		}
+
+		double totalTime = 0;
+		for (const double l : lat) totalTime += l;
+
+		const Summary latency(lat);
+		const double inPtsPerSec = stats.input_points / totalTime;
+		const double outPtsPerSec = stats.output_points / totalTime;
+		const double memMiB = 1.0 / (1024.0 * 1024.0);
+
+		std::cout << mrpt::format(
+			"\nCycles: %zu  Input observations: %zu\n"
+			"Cycle latency [ms]: %s\n"
+			"Throughput [points/s]: input=%.0f output=%.0f\n"
+			"Memory [MiB]: start=%.02f peak=%.02f\n",
+			lat.size(), stats.input_observations,
+			latency.asString(1e3).c_str(), inPtsPerSec, outPtsPerSec,
+			stats.mem_start * memMiB, stats.mem_peak * memMiB);
+
+		std::cout << "\n" << core.profiler().getStatsAsText() << "\n";
+
+		if (arg_json.isSet())
+		{
+			JSONObject memory;
+			memory.add("start", stats.mem_start).add("peak", stats.mem_peak);
+
+			JSONObject report;
+			report.add("rawlog", arg_rawlog.getValue())
+				.add("pipeline", arg_pipeline.getValue())
+				.add("cycles", lat.size())
+				.add("input_observations", stats.input_observations)
+				.add("latency_ms", latency.asJSON(1e3))
+				.add("input_points_per_second", inPtsPerSec)
+				.add("output_points_per_second", outPtsPerSec)
+				.add("memory_bytes", memory);
+
+			if (!report.saveToFile(arg_json.getValue()))
+			{
+				std::cerr << "Error writing to: " << arg_json.getValue()
+						  << "\n";
+				return 1;
+			}
+		}
+
+		RegressionGates gates;
+		gates.checkAtMost(
+			"p99 latency", 1e3 * latency.p99, arg_max_p99.getValue(), "ms");
+		return gates.exitCode();
+	}
+	catch (const std::exception& e)
+	{
+		std::cerr << "Exit due to exception:\n"
+				  << mrpt::exception_to_str(e) << std::endl;
+		return 1;
+	}
+}
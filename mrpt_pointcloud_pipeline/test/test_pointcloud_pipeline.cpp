@@ -0,0 +1,74 @@
+/* +------------------------------------------------------------------------+
+   |                             mrpt_navigation                            |
+   |                                                                        |
+   | Copyright (c) 2014-2024, Individual contributors, see commit authors   |
+   | See: https://github.com/mrpt-ros-pkg/mrpt_navigation                   |
+   | All rights reserved. Released under BSD 3-Clause license. See LICENSE  |
+   +------------------------------------------------------------------------+ */
+
+#include <gtest/gtest.h>
+#include <mrpt/core/get_env.h>
+#include <mrpt/obs/CObservation2DRangeScan.h>
+#include <mrpt/obs/CRawlog.h>
+#include <mrpt_pointcloud_pipeline/mrpt_pointcloud_pipeline_core.h>
+
+struct TestParams
+{
+	const std::string TEST_PIPELINE_YAML_FILE = mrpt::get_env<std::string>(
+		"TEST_PIPELINE_YAML_FILE", MRPT_POINTCLOUD_PIPELINE_SOURCE_DIR
+		"/params/point-cloud-pipeline.yaml");
+
+	const std::string TEST_RAWLOG_FILE = mrpt::get_env<std::string>(
+		"TEST_RAWLOG_FILE", MRPT_POINTCLOUD_PIPELINE_SOURCE_DIR
+		"/../mrpt_tutorials/datasets/driving_in_office_obs.rawlog");
+};
+
+TEST(PointCloudPipeline, EmptyWindow)
+{
+	LocalObstaclesCore core;
+	EXPECT_TRUE(core.latch_observation_window().empty());
+	EXPECT_EQ(core.history_size(), 0U);
+}
+
+TEST(PointCloudPipeline, RunRealDataset)
+{
+	TestParams _;
+
+	LocalObstaclesCore core;
+	core.load_pipeline_from_yaml_file(_.TEST_PIPELINE_YAML_FILE);
+
+	mrpt::obs::CRawlog dataset;
+	dataset.loadFromRawLogFile(_.TEST_RAWLOG_FILE);
+	EXPECT_GT(dataset.size(), 20U);
+
+	size_t cycles = 0;
+	for (const auto& observation : dataset)
+	{
+		const auto obs =
+			std::dynamic_pointer_cast<mrpt::obs::CObservation2DRangeScan>(
+				observation);
+		if (!obs) continue;
+
+		LocalObstaclesCore::InfoPerTimeStep ipt;
+		ipt.sourceTopic = obs->sensorLabel;
+		ipt.observation = obs;
+		core.add_observation(mrpt::Clock::toDouble(obs->timestamp), ipt);
+
+		const auto window = core.latch_observation_window();
+		ASSERT_FALSE(window.empty());
+
+		// All observations must be within the time window:
+		EXPECT_LE(
+			window.rbegin()->first - window.begin()->first,
+			core.params.time_window);
+
+		const auto mm = core.build_local_map(window);
+
+		const auto out = mm.point_layer("output");
+		ASSERT_TRUE(out);
+		EXPECT_GT(out->size(), 0U);
+
+		cycles++;
+	}
+	EXPECT_GT(cycles, 10U);
+}
@@ -0,0 +1,553 @@
+/* +------------------------------------------------------------------------+
+   |                             mrpt_navigation                            |
+   |                                                                        |
+   | Copyright (c) 2014-2024, Individual contributors, see commit authors   |
+   | See: https://github.com/mrpt-ros-pkg/mrpt_navigation                   |
+   | All rights reserved. Released under BSD 3-Clause license. See LICENSE  |
+   +------------------------------------------------------------------------+ */
+
+#pragma once
+
+#include <mrpt/config/CConfigFileBase.h>
+#include <mrpt/core/Clock.h>
+#include <mrpt/core/WorkerThreadsPool.h>
+#include <mrpt/core/bits_math.h>
+#include <mrpt/kinematics/CVehicleSimul_DiffDriven.h>
+#include <mrpt/maps/CSimplePointsMap.h>
+#include <mrpt/math/CPolygon.h>
+#include <mrpt/math/TPose2D.h>
+#include <mrpt/math/TTwist2D.h>
+#include <mrpt/nav/reactive/CReactiveNavigationSystem.h>
+#include <mrpt/nav/reactive/CRobot2NavInterface.h>
+#include <mrpt/nav/tpspace/CParameterizedTrajectoryGenerator.h>
+#include <mrpt/poses/CPose2D.h>
+
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/* The core C++ non-ROS parts of the reactive navigation node. */
+
+namespace mrpt_reactivenav2d
+{
+/// The robot shape used to build the PTG collision grids.
+struct RobotShape
+{
+	//!< Polygonal shape. Empty means "use the one in the config file".
+	mrpt::math::CPolygon polygon;
+
+	//!< Circular shape radius. <=0 means "use the one in the config file".
+	double circularRadius = -1.0;
+};
+
+/** The reactive navigation engine used by the ROS node: a
+ * CReactiveNavigationSystem that can keep the PTG tables (collision grids)
+ * in a dedicated cache directory, and that can transform the obstacles
+ * into the TP-Space of each PTG in parallel.
+ */
+class ReactiveNavEngine : public mrpt::nav::CReactiveNavigationSystem
+{
+   public:
+	using mrpt::nav::CReactiveNavigationSystem::CReactiveNavigationSystem;
+
+	/** Sets the directory where the PTG tables are saved to, and loaded from
+	 * if they already exist and match the current PTG parameters.
+	 * If empty (default), the log files directory is used, as in the base
+	 * class. Changing it forces PTG re-initialization.
+	 */
+	void setPTGCacheDirectory(const std::string& dir);
+
+	const std::string& getPTGCacheDirectory() const { return ptgCacheDir_; }
+
+	/// Applies the shape to the engine, if defined.
+	void changeRobotShape(const RobotShape& shape);
+
+	using mrpt::nav::CReactiveNavigationSystem::changeRobotShape;
+
+	/** Enables or disables the parallel evaluation of PTGs.
+	 * When enabled, right after sensing the obstacles in each navigation
+	 * step, the obstacles are transformed into TP-Space and the clearance
+	 * diagrams built for all PTGs at once, each one in a task of a persistent
+	 * thread pool. Results are identical to those of serial evaluation.
+	 *
+	 * \param numThreads Number of worker threads. 0 means one per CPU core.
+	 */
+	void enableParallelPTGEvaluation(bool enable, size_t numThreads = 0);
+
+	bool isParallelPTGEvaluationEnabled() const
+	{
+		return ptgThreadPool_ != nullptr;
+	}
+
+   protected:
+	void STEP1_InitPTGs() override;
+
+	bool implementSenseObstacles(
+		mrpt::system::TTimeStamp& obs_timestamp) override;
+
+	void STEP3_WSpaceToTPSpace(
+		const size_t ptg_idx, std::vector<double>& out_TPObstacles,
+		mrpt::nav::ClearanceDiagram& out_clearance,
+		const mrpt::math::TPose2D& rel_pose_PTG_origin_wrt_sense,
+		const bool eval_clearance) override;
+
+   private:
+	std::string ptgCacheDir_;
+
+	std::unique_ptr<mrpt::WorkerThreadsPool> ptgThreadPool_;
+
+	/// Set after sensing new obstacles, until the first STEP3 call.
+	bool newObstaclesPending_ = false;
+
+	/// Per-PTG results of the latest parallel evaluation, valid for one
+	/// (obstacles, relative pose, eval_clearance) set of inputs only.
+	struct PTGResult
+	{
+		bool valid = false;	 //!< Reset once used
+		std::vector<double> TPObstacles;
+		mrpt::nav::ClearanceDiagram clearance;
+	};
+	std::vector<PTGResult> ptgResults_;
+	mrpt::math::TPose2D ptgResultsRelPose_;
+	bool ptgResultsEvalClearance_ = false;
+
+	void evaluate_all_ptgs_in_parallel(
+		const mrpt::math::TPose2D& rel_pose_PTG_origin_wrt_sense,
+		const bool eval_clearance);
+};
+
+/** Provides the robot pose and velocity without blocking, by combining the
+ * latest known transformation between the reference (e.g. `map`) and
+ * odometry frames, which is usually published at a low rate, with the
+ * high-rate odometry stream.
+ *
+ * Latency compensation: the latest odometry pose is extrapolated up to the
+ * query time using the latest odometry twist (constant velocity model).
+ *
+ * All methods are multi-thread safe.
+ */
+class RobotPoseProvider
+{
+   public:
+	RobotPoseProvider() = default;
+
+	struct Parameters
+	{
+		Parameters() = default;
+
+		//!< Odometry older than this [s] is considered invalid.
+		double max_odometry_age = 0.5;
+
+		//!< Maximum time [s] to extrapolate the pose forward.
+		double max_extrapolation_time = 0.2;
+
+		//!< Odometry readings are kept this long [s], see odometry_at().
+		double odometry_history = 1.0;
+	};
+
+	Parameters params;
+
+	struct Output
+	{
+		//!< Robot pose in the reference frame, at `timestamp`
+		mrpt::math::TPose2D pose;
+		//!< Robot velocity, in the reference frame
+		mrpt::math::TTwist2D velocityGlobal;
+		//!< Robot velocity, in the robot local frame
+		mrpt::math::TTwist2D velocityLocal;
+		//!< Robot pose in the odometry frame, at `timestamp`
+		mrpt::math::TPose2D odometry;
+
+		mrpt::system::TTimeStamp timestamp;
+		//!< Time [s] the odometry was extrapolated forward
+		double extrapolatedTime = 0;
+	};
+
+	/** New odometry reading: pose in the odometry frame, and velocity in the
+	 * robot local frame. */
+	void add_odometry(
+		const mrpt::math::TPose2D& odometry,
+		const mrpt::math::TTwist2D& velocityLocal,
+		const mrpt::system::TTimeStamp& timestamp);
+
+	/// Updates the pose of the odometry frame wrt the reference frame.
+	void set_reference_to_odom(const mrpt::math::TPose2D& refToOdom);
+
+	/** Returns the robot pose and twist predicted at `queryTime`, or nothing
+	 * if there is no recent enough odometry or reference to odometry
+	 * transformation yet. */
+	std::optional<Output> get(const mrpt::system::TTimeStamp& queryTime) const;
+
+	/// Returns the latest odometry, with no extrapolation, if any.
+	std::optional<Output> latest_odometry() const;
+
+	/** Returns the robot pose in the odometry frame at `queryTime`,
+	 * interpolated between the two odometry readings around it, or
+	 * extrapolated like in get() if it is newer than all of them. Returns
+	 * nothing if it is older than the readings kept, or newer than the
+	 * extrapolation limit. */
+	std::optional<mrpt::math::TPose2D> odometry_at(
+		const mrpt::system::TTimeStamp& queryTime) const;
+
+   private:
+	mutable std::mutex mtx_;
+	std::optional<mrpt::math::TPose2D> refToOdom_;
+	std::optional<Output> lastOdometry_;
+	std::deque<Output> odometryHistory_;  //!< Oldest first
+};
+
+/** Crops obstacle points, given in the robot frame, by range and height,
+ * and optionally decimates them keeping only the point nearest to the robot
+ * in each polar sector or 2D grid cell.
+ *
+ * Points are fed one by one, so it can run while converting the incoming
+ * point cloud, without building a full-size intermediate map.
+ */
+class ObstacleDecimator
+{
+   public:
+	ObstacleDecimator() = default;
+
+	enum class Decimation : uint8_t
+	{
+		None = 0,
+		Polar,	//!< Nearest point per angular sector
+		Grid	//!< Nearest point per XY grid cell
+	};
+
+	struct Parameters
+	{
+		Parameters() = default;
+
+		double min_range = 0;  //!< [m] Closer points are discarded
+		double max_range = 0;  //!< [m] Farther points are discarded (0=off)
+		double min_z = -std::numeric_limits<double>::max();	 //!< [m]
+		double max_z = std::numeric_limits<double>::max();	//!< [m]
+
+		Decimation decimation = Decimation::None;
+		double polar_resolution = mrpt::DEG2RAD(1.0);  //!< [rad]
+		double grid_resolution = 0.05;	//!< [m]
+
+		/// Whether any cropping or decimation is actually enabled:
+		bool enabled() const
+		{
+			return min_range > 0 || max_range > 0 ||
+				min_z > -std::numeric_limits<double>::max() ||
+				max_z < std::numeric_limits<double>::max() ||
+				decimation != Decimation::None;
+		}
+	};
+
+	Parameters params;
+
+	/// Must be called before feeding the points of a new cloud.
+	void reset();
+
+	void add_point(float x, float y, float z);
+
+	/// Writes the filtered points into `out` (which is cleared first).
+	void get_result(mrpt::maps::CSimplePointsMap& out) const;
+
+	size_t input_count() const { return inputCount_; }
+
+   private:
+	struct Candidate
+	{
+		float x = 0, y = 0, z = 0;
+		float range2 = std::numeric_limits<float>::max();
+	};
+
+	size_t inputCount_ = 0;
+	std::vector<Candidate> polarBins_;
+	std::unordered_map<uint64_t, Candidate> gridCells_;
+	mrpt::maps::CSimplePointsMap passThrough_;	//!< Decimation::None
+};
+
+/** A short-term, robot-centric memory of obstacles, so that obstacles that
+ * leave the sensors field of view (e.g. beside or behind the robot during
+ * tight turns) do not vanish at once, but are forgotten after a while.
+ * Remembered obstacles that a new scan sees through (i.e. it has a farther
+ * obstacle in the same direction) are forgotten at once, so moving
+ * obstacles leave no ghosts behind them.
+ *
+ * Obstacles are kept in a fixed-size ring grid keyed by their position in
+ * the odometry frame, covering a square around the robot. Hence, moving
+ * the robot needs no data shifting, and both updating and merging the
+ * memory into a new scan cost O(points + cells).
+ */
+class ObstacleMemory
+{
+   public:
+	ObstacleMemory() = default;
+
+	struct Parameters
+	{
+		Parameters() = default;
+
+		//!< [s] How long unseen obstacles are remembered (0=disabled)
+		double decay_time = 0;
+
+		double resolution = 0.10;  //!< [m] Cell size
+		double radius = 4.0;  //!< [m] Half the side of the memory square
+
+		bool enabled() const { return decay_time > 0; }
+	};
+
+	Parameters params;
+
+	void clear();
+
+	/** Stores the obstacles sensed at `time` [s], given in the robot frame,
+	 * with the robot at `robotPose` in the odometry frame at that time
+	 * (see RobotPoseProvider::odometry_at()). Then, adds to `obstacles` the
+	 * remembered ones that were not in this scan, are not older than
+	 * `decay_time`, and are not closer to the robot than the nearest
+	 * obstacle of this scan in their direction, which is then free space.
+	 * Sensors are assumed to be at the robot origin for this check. */
+	void update_and_merge(
+		mrpt::maps::CSimplePointsMap& obstacles,
+		const mrpt::math::TPose2D& robotPose, double time);
+
+	/// Number of obstacles added by the last update_and_merge() call.
+	size_t last_merged_count() const { return lastMergedCount_; }
+
+   private:
+	struct Cell
+	{
+		int32_t ix = std::numeric_limits<int32_t>::min(), iy = 0;
+		float x = 0, y = 0;	 //!< In the odometry frame
+		double lastSeen = 0;
+	};
+	std::vector<Cell> cells_;
+	int32_t sideCells_ = 0;
+	double gridResolution_ = 0;
+	size_t lastMergedCount_ = 0;
+
+	Cell& cell_for(int32_t ix, int32_t iy);
+};
+
+/** A fixed-size histogram of time intervals (latencies), used to report
+ * percentiles with O(1) cost per sample and no memory growth.
+ */
+class LatencyHistogram
+{
+   public:
+	/** Values in [0,maxValue] are binned with `numBins` bins; larger values
+	 * are counted in the last bin. */
+	explicit LatencyHistogram(double maxValue = 1.0, size_t numBins = 1000);
+
+	void add(double value);
+	void clear();
+
+	size_t count() const { return count_; }
+	double max() const { return max_; }
+	double mean() const { return count_ ? sum_ / count_ : 0; }
+
+	/** Returns the upper edge of the bin that contains the given percentile
+	 * (p in [0,1]), or 0 if empty. */
+	double percentile(double p) const;
+
+	/// e.g. "n=100 mean=1.2ms p50=1.0ms p90=1.5ms p99=3.0ms max=3.1ms"
+	std::string asString() const;
+
+   private:
+	std::vector<size_t> bins_;
+	double binWidth_;
+	size_t count_ = 0;
+	double sum_ = 0, max_ = 0;
+};
+
+/** Gating of velocity commands while input data is stale: they are scaled
+ * by a factor. The last command is remembered, so that keeping it (a "no
+ * operation" command, see CRobot2NavInterface::changeSpeedsNOP()) is gated
+ * the same way as a new command.
+ */
+class StaleDataSpeedGate
+{
+   public:
+	StaleDataSpeedGate() = default;
+
+	struct Parameters
+	{
+		Parameters() = default;
+
+		//!< Velocity commands are scaled by this with stale data (0=stop)
+		double speed_factor = 0;
+	};
+
+	Parameters params;
+
+	/// A new command (v=vx, w=omega): returns the one to send.
+	mrpt::math::TTwist2D new_command(
+		const mrpt::math::TTwist2D& cmd, bool staleData);
+
+	/** Keeping the last command: returns the one to send, or nothing if
+	 * the robot can keep on executing the last one sent. */
+	std::optional<mrpt::math::TTwist2D> keep_command(bool staleData);
+
+   private:
+	mrpt::math::TTwist2D last_{0, 0, 0};  //!< Last command, before scaling
+};
+
+/** Common parts of the interface between ReactiveNavEngine and a
+ * differential-driven robot, shared by the ROS node and the in-process
+ * kinematic simulator (KinematicSimRobot).
+ */
+class DiffDriveRobotInterface : public mrpt::nav::CRobot2NavInterface
+{
+   public:
+	DiffDriveRobotInterface() = default;
+
+	/// Sends a zero velocity command via changeSpeeds()
+	bool stop(bool isEmergency) override;
+
+	bool startWatchdog(float T_ms) override { return true; }
+	bool stopWatchdog() override { return true; }
+
+	mrpt::kinematics::CVehicleVelCmd::Ptr getEmergencyStopCmd() override
+	{
+		return getStopCmd();
+	}
+
+	mrpt::kinematics::CVehicleVelCmd::Ptr getStopCmd() override;
+};
+
+/** A ROS-free, in-process robot to run the navigator in closed loop, e.g.
+ * for benchmarks and tests: an ideal differential-driven kinematic model
+ * moving in a world of static point obstacles, which are perceived by a
+ * 360 degrees sensor with a limited range.
+ *
+ * Time is simulated: the navigator sees the simulation time through
+ * getNavigationTime(), so it can run as fast as the CPU allows by calling
+ * ReactiveNavEngine::navigationStep() and simulate() in turns. Poses and
+ * obstacles are stamped with the simulated clock, now(). Set it as the
+ * mrpt::Clock simulated time for the navigator to measure data ages with
+ * it too.
+ *
+ * Navigation events are recorded, see events().
+ */
+class KinematicSimRobot : public DiffDriveRobotInterface
+{
+   public:
+	KinematicSimRobot() = default;
+
+	struct Parameters
+	{
+		Parameters() = default;
+
+		double sensor_range = 6.0;	//!< [m]
+	};
+
+	Parameters params;
+
+	/// Sets the obstacles, in world coordinates.
+	void set_obstacles(const mrpt::maps::CSimplePointsMap& obstacles);
+
+	const mrpt::maps::CSimplePointsMap& obstacles() const { return world_; }
+
+	/// Resets the robot to the given pose, at rest, and the recorded events.
+	void reset(const mrpt::math::TPose2D& pose);
+
+	/// Moves the robot forward in time, with the last velocity command.
+	void simulate(double dt);
+
+	mrpt::math::TPose2D pose() const { return sim_.getCurrentGTPose(); }
+
+	/// Simulation time [s] since the last reset()
+	double time() const { return sim_.getTime(); }
+
+	/// Simulated clock. It keeps increasing across reset() calls.
+	mrpt::Clock::time_point now() const
+	{
+		return mrpt::Clock::fromDouble(
+			mrpt::Clock::toDouble(timeOrigin_) + time());
+	}
+
+	/// Distance [m] from the robot center to the nearest obstacle.
+	double nearest_obstacle_distance() const;
+
+	/** Clearance [m] between the robot shape defined in the given PTG and
+	 * the nearest obstacle, as evaluated by the navigator (see
+	 * CParameterizedTrajectoryGenerator::evalClearanceToRobotShape()).
+	 * Zero or negative means collision. */
+	double nearest_obstacle_clearance(
+		const mrpt::nav::CParameterizedTrajectoryGenerator& ptg) const;
+
+	struct Events
+	{
+		size_t navigationStarts = 0;
+		size_t waypointsReached = 0;
+		size_t apparentCollisions = 0;
+		size_t waySeemsBlocked = 0;
+
+		/// Set at the end of navigation, to whether it was successful
+		std::optional<bool> navigationEndedSuccessfully;
+	};
+
+	const Events& events() const { return events_; }
+
+	/** @name CRobot2NavInterface implementation
+	 *  @{ */
+	bool getCurrentPoseAndSpeeds(
+		mrpt::math::TPose2D& curPose, mrpt::math::TTwist2D& curVel,
+		mrpt::system::TTimeStamp& timestamp, mrpt::math::TPose2D& curOdometry,
+		std::string& frame_id) override;
+
+	bool changeSpeeds(const mrpt::kinematics::CVehicleVelCmd& vel_cmd) override;
+
+	bool senseObstacles(
+		mrpt::maps::CSimplePointsMap& obstacles,
+		mrpt::system::TTimeStamp& timestamp) override;
+
+	double getNavigationTime() override { return time() - navTimerStart_; }
+	void resetNavigationTimer() override { navTimerStart_ = time(); }
+
+	void sendNavigationStartEvent() override;
+	void sendNavigationEndEvent() override;
+	void sendWaypointReachedEvent(
+		int waypoint_index, bool reached_nSkipped) override;
+	void sendNavigationEndDueToErrorEvent() override;
+	void sendWaySeemsBlockedEvent() override;
+	void sendApparentCollisionEvent() override;
+	void sendCannotGetCloserToBlockedTargetEvent() override;
+	/** @} */
+
+   private:
+	mrpt::kinematics::CVehicleSimul_DiffDriven sim_;
+	mrpt::maps::CSimplePointsMap world_;
+	double navTimerStart_ = 0;
+	mrpt::Clock::time_point timeOrigin_ = mrpt::Clock::now();
+	Events events_;
+};
+
+/** @name PTG tables on-disk cache
+ *  @{ */
+
+/** Returns a key (an hexadecimal hash string) that identifies the PTG
+ * tables built from the `[CReactiveNavigationSystem]` section of the given
+ * reactive config file and the given robot shape.
+ */
+std::string ptg_cache_key(
+	const mrpt::config::CConfigFileBase& cfg, const RobotShape& shape);
+
+/** Builds the PTG tables for the given reactive config and robot shape, and
+ * saves them into `dir`, without the need of a real robot interface.
+ * This may take several seconds, so it is intended to be run in a worker
+ * thread. \return false on any error.
+ */
+bool build_ptg_cache(
+	const mrpt::config::CConfigFileBase& cfg, const RobotShape& shape,
+	const std::string& dir);
+
+/// Returns true if build_ptg_cache() was successfully completed for `dir`.
+bool ptg_cache_is_ready(const std::string& dir);
+
+/** @} */
+
+}  // namespace mrpt_reactivenav2d
@@ -14,7 +14,6 @@
 #include <mrpt/maps/CSimplePointsMap.h>
 #include <mrpt/nav/reactive/CReactiveNavigationSystem.h>
 #include <mrpt/nav/reactive/TWaypoint.h>
-#include <mrpt/obs/CObservationOdometry.h>
 #include <mrpt/ros2bridge/point_cloud2.h>
 #include <mrpt/ros2bridge/pose.h>
 #include <mrpt/ros2bridge/time.h>
@@ -32,12 +31,20 @@
 #include <mrpt_msgs/msg/waypoint_sequence.hpp>
 #include <mrpt_nav_interfaces/action/navigate_goal.hpp>
 #include <mrpt_nav_interfaces/action/navigate_waypoints.hpp>
+#include <mrpt_nav_interfaces/msg/navigation_latency.hpp>
+#include <mrpt_nav_interfaces/msg/navigation_latency_stats.hpp>
+#include <mrpt_reactivenav2d/mrpt_reactivenav2d_core.hpp>
+#include <condition_variable>
+#include <future>
+#include <memory>
 #include <mutex>
+#include <thread>
 #include <nav_msgs/msg/odometry.hpp>
 #include <rclcpp/rclcpp.hpp>
 #include <rclcpp_action/rclcpp_action.hpp>
 #include <sensor_msgs/msg/laser_scan.hpp>
 #include <sensor_msgs/msg/point_cloud2.hpp>
+#include <sensor_msgs/point_cloud2_iterator.hpp>
 #include <std_msgs/msg/string.hpp>
 #include <tf2_geometry_msgs/tf2_geometry_msgs.hpp>
 #include <visualization_msgs/msg/marker_array.hpp>
@@ -52,7 +59,7 @@ class ReactiveNav2DNode : public rclcpp::Node
 	explicit ReactiveNav2DNode(
 		const rclcpp::NodeOptions& options = rclcpp::NodeOptions());
 	/* Dtor*/
-	~ReactiveNav2DNode() {}
+	~ReactiveNav2DNode();
 
    private:
 	// methods
@@ -86,6 +93,13 @@ class ReactiveNav2DNode : public rclcpp::Node
 
 	rclcpp::Publisher<std_msgs::msg::String>::SharedPtr pubNavEvents_;
 
+	rclcpp::Publisher<mrpt_nav_interfaces::msg::NavigationLatency>::SharedPtr
+		pubNavLatency_;
+
+	rclcpp::Publisher<
+		mrpt_nav_interfaces::msg::NavigationLatencyStats>::SharedPtr
+		pubNavLatencyStats_;
+
 	std::shared_ptr<tf2_ros::Buffer> tfBuffer_;
 	std::shared_ptr<tf2_ros::TransformListener> tfListener_;
 	/** @} */
@@ -109,6 +123,8 @@ class ReactiveNav2DNode : public rclcpp::Node
 	std::string pubTopicCmdVel_ = "/cmd_vel";
 	std::string pubTopicSelectedPtg_ = "reactivenav_selected_ptg";
 	std::string pubTopicEvents_ = "reactivenav_events";
+	std::string pubTopicNavLatency_ = "reactivenav_latency";
+	std::string pubTopicNavLatencyStats_ = "reactivenav_latency_stats";
 
 	std::string frameidReference_ = "map";
 	std::string frameidRobot_ = "base_link";
@@ -122,26 +138,166 @@ class ReactiveNav2DNode : public rclcpp::Node
 
 	bool saveNavLog_ = false;
 
+	/// Evaluate PTGs in parallel in a thread pool of this many threads
+	/// (0=one per CPU core):
+	bool parallelPtgEvaluation_ = false;
+	int parallelPtgThreads_ = 0;
+
+	/** @name PTG tables cache
+	 *  @{ */
+
+	/// If not empty, PTG tables are kept in a subdirectory of this one, named
+	/// after a hash of the PTG parameters and the robot shape.
+	std::string ptgCacheDir_;
+
+	RobotShape robotShape_;	 //!< Latest robot shape (from params or topic)
+
+	std::string ptgCacheKey_;  //!< Key of the tables in use by the engine
+
+	/** Tables being built in the background, and the shape they are for.
+	 * The build runs in a detached thread that does not access the node, so
+	 * destroying the node never waits for it. If the process exits before
+	 * it ends, the partial tables are not marked as ready (see
+	 * ptg_cache_is_ready()) and they are built again in the next run. */
+	std::future<bool> ptgCacheBuild_;
+	std::string ptgCacheBuildKey_;
+	RobotShape ptgCacheBuildShape_;
+
+	/// A shape received while another one was being built:
+	std::optional<RobotShape> ptgCacheQueuedShape_;
+
+	std::mutex ptgCacheMtx_;
+
+	/** Applies a new robot shape to the engine. With a cache directory, if
+	 * the tables for it are not built yet, they are first built in the
+	 * background while the engine keeps using the former ones. */
+	void update_robot_shape(const RobotShape& shape);
+
+	/// Checks for the end of a background PTG tables build.
+	void check_ptg_cache_build();
+
+	std::string ptg_cache_dir_for_key(const std::string& key) const
+	{
+		return ptgCacheDir_ + "/" + key;
+	}
+	/** @} */
+
 	rclcpp::TimerBase::SharedPtr timerRunNav_;
 
-	mrpt::obs::CObservationOdometry odometry_;
-	std::mutex odometryMtx_;
+	/// Robot pose and velocity from /odom and the reference-to-odom /tf
+	RobotPoseProvider poseProvider_;
+
+	struct ObstaclesSnapshot
+	{
+		mrpt::maps::CSimplePointsMap points;
+		//!< Stamp of the source message (INVALID_TIMESTAMP if none)
+		mrpt::system::TTimeStamp timestamp = INVALID_TIMESTAMP;
+		/// A newer message could not be used (no TF to the robot frame), so
+		/// `points` are out of date: they are stale data, whatever their age
+		bool outdated = false;
+	};
+
+	/// Optional cropping and decimation of incoming obstacles
+	ObstacleDecimator obstacleDecimator_;
+
+	/// Optional short-term memory of obstacles out of the sensors view.
+	/// Only used from the obstacles subscription callback.
+	ObstacleMemory obstacleMemory_;
 
-	mrpt::maps::CSimplePointsMap lastObstacles_;
-	std::mutex lastObstaclesMtx_;
+	/** Latest obstacles snapshot. It is immutable once published: the
+	 * subscriber converts each new message into a fresh map and swaps the
+	 * pointer, so readers never block the subscriber (nor vice versa).
+	 * Always access it via std::atomic_load() / std::atomic_store().
+	 */
+	std::shared_ptr<const ObstaclesSnapshot> lastObstacles_ =
+		std::make_shared<const ObstaclesSnapshot>();
+
+	/** @name Latency tracking and stale data gating
+	 *  @{ */
+
+	//!< Obstacles older than this [s] are stale (0=disabled)
+	double maxObstaclesAge_ = 0;
+	//!< Robot poses older than this [s] are stale (0=disabled)
+	double maxPoseAge_ = 0;
+	/// Scales velocity commands with stale data, also when the last one is
+	/// kept (changeSpeedsNOP()). Only used from the navigation thread.
+	StaleDataSpeedGate staleDataGate_;
+	//!< Period [s] to log and publish latency statistics (0=disabled)
+	double latencyReportPeriod_ = 10.0;
+
+	/// Timing of the navigation step in progress. Ages in seconds.
+	struct StepTiming
+	{
+		mrpt::system::TTimeStamp stepStart = INVALID_TIMESTAMP;
+		std::optional<double> obstaclesAge, poseAge, cmdPublishDelay;
+		bool obstaclesOutdated = false;	 //!< See ObstaclesSnapshot::outdated
+		bool staleData = false;
+	};
+	StepTiming currentStep_;
+
+	LatencyHistogram histObstaclesAge_, histPoseAge_, histStepTime_,
+		histCmdPublishDelay_;
+	mrpt::system::TTimeStamp lastLatencyReport_ = INVALID_TIMESTAMP;
+
+	/// Current time from the node clock (may be simulated time)
+	mrpt::system::TTimeStamp ros_now() const
+	{
+		return mrpt::ros2bridge::fromROS(get_clock()->now());
+	}
+
+	/// Seconds from the current step start to `t`
+	double time_since_step_start(const mrpt::system::TTimeStamp& t) const
+	{
+		return mrpt::system::timeDifference(currentStep_.stepStart, t);
+	}
+
+	void report_step_latency(double stepTime);
+	/** @} */
 
 	bool waitForTransform(
 		mrpt::poses::CPose3D& des, const std::string& target_frame,
 		const std::string& source_frame, const int timeoutMilliseconds = 50);
 
+	/** @name Debug visualization
+	 *  @{ */
+
+	/// Publish markers for the selected PTG path (only if subscribed)
+	bool publishDebugMarkers_ = true;
+	/// Publish markers only once every N navigation steps
+	int debugMarkersDecimation_ = 1;
+	size_t debugMarkersStepCounter_ = 0;
+
+	/// Whether to keep and publish the log record of the next nav step
+	bool debug_markers_wanted();
+
 	void publish_last_log_record_to_ros(const mrpt::nav::CLogFileRecord& lr);
 
-	visualization_msgs::msg::MarkerArray log_to_margers(
+	/// The selected PTG path, in the robot frame, or empty if none
+	std::vector<mrpt::math::TPose2D> selected_ptg_path(
 		const mrpt::nav::CLogFileRecord& lr);
 
+	visualization_msgs::msg::MarkerArray path_to_markers(
+		const std::vector<mrpt::math::TPose2D>& path,
+		const rclcpp::Time& stamp) const;
+
+	/// Markers are built and published in this thread, off the nav timer
+	std::thread debugMarkersThread_;
+	std::mutex debugMarkersMtx_;
+	std::condition_variable debugMarkersCv_;
+	struct DebugMarkersJob
+	{
+		rclcpp::Time stamp;
+		std::vector<mrpt::math::TPose2D> path;
+	};
+	std::optional<DebugMarkersJob> debugMarkersJob_;  //!< Latest one only
+	bool debugMarkersThreadExit_ = false;
+
+	void debug_markers_thread();
+	/** @} */
+
 	void publish_event_message(const std::string& text);
 
-	struct MyReactiveInterface : public mrpt::nav::CRobot2NavInterface
+	struct MyReactiveInterface : public DiffDriveRobotInterface
 	{
 		ReactiveNav2DNode& parent_;
 
@@ -166,16 +322,19 @@ class ReactiveNav2DNode : public rclcpp::Node
 		bool changeSpeeds(
 			const mrpt::kinematics::CVehicleVelCmd& vel_cmd) override;
 
-		bool stop(bool isEmergency) override;
+		/** Keep the last velocity command, unless the input data is stale:
+		 * then, it is sent again scaled by the stale data speed factor, as
+		 * changeSpeeds() would do (see StaleDataSpeedGate). */
+		bool changeSpeedsNOP() override;
 
-		/** Start the watchdog timer of the robot platform, if any.
-		 * \param T_ms Period, in ms.
-		 * \return false on any error. */
-		bool startWatchdog(float T_ms) override { return true; }
+		/// Checks the ages of the current step input data, and sets
+		/// StepTiming::staleData if too old.
+		bool input_data_is_stale();
 
-		/** Stop the watchdog timer.
-		 * \return false on any error. */
-		bool stopWatchdog() override { return true; }
+		void warn_stale_data(const char* caller);
+
+		/// Publishes a velocity command (v=vx, w=omega) to the robot.
+		void publish_cmd_vel(const mrpt::math::TTwist2D& vel);
 
 		/** Return the current set of obstacle points.
 		 * \return false on any error. */
@@ -183,18 +342,6 @@ class ReactiveNav2DNode : public rclcpp::Node
 			mrpt::maps::CSimplePointsMap& obstacles,
 			mrpt::system::TTimeStamp& timestamp) override;
 
-		mrpt::kinematics::CVehicleVelCmd::Ptr getEmergencyStopCmd() override
-		{
-			return getStopCmd();
-		}
-
-		mrpt::kinematics::CVehicleVelCmd::Ptr getStopCmd() override
-		{
-			auto ret = mrpt::kinematics::CVehicleVelCmd_DiffDriven::Create();
-			ret->setToStop();
-			return ret;
-		}
-
 		/** Callback: Start of navigation command */
 		void sendNavigationStartEvent() override;
 
@@ -230,7 +377,7 @@ class ReactiveNav2DNode : public rclcpp::Node
 	};
 
 	MyReactiveInterface reactiveInterface_{*this};
-	mrpt::nav::CReactiveNavigationSystem rnavEngine_{reactiveInterface_};
+	ReactiveNavEngine rnavEngine_{reactiveInterface_};
 	std::mutex rnavEngineMtx_;
 
 	// ACTION INTERFACE: NavigateGoal
@@ -251,8 +398,43 @@ class ReactiveNav2DNode : public rclcpp::Node
 	void execute_action_goal(
 		const std::shared_ptr<HandleNavigateGoal> goal_handle);
 
+	/** @name Navigation events for the action servers
+	 *  The action threads block on navEventsCv_ and are woken up as soon as
+	 *  a navigation event or a cancel request arrives.
+	 *  @{ */
+
 	std::optional<bool> currentNavEndedSuccessfully_;
 	std::mutex currentNavEndedSuccessfullyMtx_;
+	std::condition_variable navEventsCv_;
+
+	/// Incremented with each navigation event or cancel request, resp.
+	struct NavEventCounters
+	{
+		uint64_t events = 0;
+		uint64_t cancelRequests = 0;
+	};
+	NavEventCounters navEventCounters_;
+
+	//!< Maximum time [s] an action thread waits without navigation events.
+	double actionWatchdogPeriod_ = 1.0;
+
+	/** Wakes up the action threads. If given, also sets the outcome of the
+	 * current navigation. */
+	void signal_nav_event(
+		const std::optional<bool>& navEndedSuccessfully = std::nullopt);
+
+	/** Wakes up the action threads once the action server has moved the
+	 * goal into the CANCELING state. Call from the handle_cancel callbacks.
+	 */
+	void signal_cancel_request();
+	rclcpp::TimerBase::SharedPtr cancelSignalTimer_;
+
+	/** Blocks until there are navigation events or cancel requests newer
+	 * than `lastSeen`, or the watchdog period times out, and updates
+	 * `lastSeen`. \return true if there was a new cancel request. */
+	bool wait_for_nav_event(NavEventCounters& lastSeen);
+
+	/** @} */
 
 	// ACTION INTERFACE: NavigateWaypoints
 	// --------------------------------------
@@ -62,6 +62,45 @@ def generate_launch_description():
         'save_nav_log',
         default_value='False'
     )
+    parallel_ptg_evaluation_arg = DeclareLaunchArgument(
+        'parallel_ptg_evaluation',
+        default_value='False',
+        description='Evaluate all PTGs in parallel in each navigation step'
+    )
+    parallel_ptg_threads_arg = DeclareLaunchArgument(
+        'parallel_ptg_threads',
+        default_value='0',
+        description='Threads for parallel_ptg_evaluation (0=one per core)'
+    )
+    max_obstacles_age_arg = DeclareLaunchArgument(
+        'max_obstacles_age',
+        default_value='0.0',
+        description='Obstacles older than this [s] are stale (0=disabled)'
+    )
+    max_pose_age_arg = DeclareLaunchArgument(
+        'max_pose_age',
+        default_value='0.0',
+        description='Robot poses older than this [s] are stale (0=disabled)'
+    )
+    stale_data_speed_factor_arg = DeclareLaunchArgument(
+        'stale_data_speed_factor',
+        default_value='0.0',
+        description='Velocity scale factor when input data is stale (0=stop). '
+        'Obstacles are also stale while the latest cloud cannot be transformed '
+        'into the robot frame'
+    )
+    obstacle_memory_decay_time_arg = DeclareLaunchArgument(
+        'obstacle_memory_decay_time',
+        default_value='0.0',
+        description='Time [s] to remember obstacles out of view (0=disabled)'
+    )
+    ptg_cache_dir_arg = DeclareLaunchArgument(
+        'ptg_cache_dir',
+        default_value='',
+        description='If not empty, directory to keep the PTG tables between runs. '
+        'Tables are built in the background; a build interrupted by a shutdown '
+        'is started again in the next run'
+    )
     topic_cmd_vel_arg = DeclareLaunchArgument(
         'topic_cmd_vel',
         default_value='/cmd_vel'
@@ -98,6 +137,13 @@ def generate_launch_description():
                 'frameid_reference': LaunchConfiguration('frameid_reference'),
                 'frameid_robot': LaunchConfiguration('frameid_robot'),
                 'save_nav_log': LaunchConfiguration('save_nav_log'),
+                'ptg_cache_dir': LaunchConfiguration('ptg_cache_dir'),
+                'max_obstacles_age': LaunchConfiguration('max_obstacles_age'),
+                'max_pose_age': LaunchConfiguration('max_pose_age'),
+                'stale_data_speed_factor': LaunchConfiguration('stale_data_speed_factor'),
+                'obstacle_memory_decay_time': LaunchConfiguration('obstacle_memory_decay_time'),
+                'parallel_ptg_evaluation': LaunchConfiguration('parallel_ptg_evaluation'),
+                'parallel_ptg_threads': LaunchConfiguration('parallel_ptg_threads'),
                 'topic_cmd_vel': LaunchConfiguration('topic_cmd_vel'),
                 'pure_pursuit_mode': LaunchConfiguration('pure_pursuit_mode'),
             }
@@ -118,6 +164,13 @@ def generate_launch_description():
         frameid_reference_arg,
         frameid_robot_arg,
         save_nav_log_arg,
+        ptg_cache_dir_arg,
+        max_obstacles_age_arg,
+        max_pose_age_arg,
+        stale_data_speed_factor_arg,
+        obstacle_memory_decay_time_arg,
+        parallel_ptg_evaluation_arg,
+        parallel_ptg_threads_arg,
         topic_cmd_vel_arg,
         pure_pursuit_mode_launch_arg,
         node_rnav2d_launch,
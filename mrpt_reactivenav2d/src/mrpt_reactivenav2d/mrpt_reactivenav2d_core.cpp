@@ -0,0 +1,780 @@
+/* +------------------------------------------------------------------------+
+   |                             mrpt_navigation                            |
+   |                                                                        |
+   | Copyright (c) 2014-2024, Individual contributors, see commit authors   |
+   | See: https://github.com/mrpt-ros-pkg/mrpt_navigation                   |
+   | All rights reserved. Released under BSD 3-Clause license. See LICENSE  |
+   +------------------------------------------------------------------------+ */
+
+#include <mrpt/core/format.h>
+#include <mrpt/core/bits_math.h>
+#include <mrpt/kinematics/CVehicleVelCmd_DiffDriven.h>
+#include <mrpt/poses/CPose2D.h>
+#include <mrpt/system/datetime.h>
+#include <mrpt/system/filesystem.h>
+#include <mrpt_nav_common/ptg_cache_key.hpp>
+#include <mrpt_reactivenav2d/mrpt_reactivenav2d_core.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+using namespace mrpt_reactivenav2d;
+
+namespace
+{
+const char* PTG_CACHE_SECTION = "CReactiveNavigationSystem";
+const char* PTG_CACHE_DONE_FILE = "ptg_cache_complete.txt";
+
+/// Dummy robot, just to let the engine build the PTGs.
+struct NullRobotInterface : public DiffDriveRobotInterface
+{
+	bool getCurrentPoseAndSpeeds(
+		mrpt::math::TPose2D&, mrpt::math::TTwist2D&,
+		mrpt::system::TTimeStamp&, mrpt::math::TPose2D&,
+		std::string&) override
+	{
+		return false;
+	}
+	bool changeSpeeds(const mrpt::kinematics::CVehicleVelCmd&) override
+	{
+		return false;
+	}
+	bool stop(bool) override { return true; }
+	bool senseObstacles(
+		mrpt::maps::CSimplePointsMap&, mrpt::system::TTimeStamp&) override
+	{
+		return false;
+	}
+};
+
+}  // namespace
+
+void ReactiveNavEngine::setPTGCacheDirectory(const std::string& dir)
+{
+	if (dir == ptgCacheDir_) return;
+	ptgCacheDir_ = dir;
+	m_PTGsMustBeReInitialized = true;
+}
+
+void ReactiveNavEngine::changeRobotShape(const RobotShape& shape)
+{
+	if (!shape.polygon.empty())
+		mrpt::nav::CReactiveNavigationSystem::changeRobotShape(shape.polygon);
+	if (shape.circularRadius > 0)
+		changeRobotCircularShapeRadius(shape.circularRadius);
+}
+
+void ReactiveNavEngine::STEP1_InitPTGs()
+{
+	if (ptgCacheDir_.empty())
+	{
+		mrpt::nav::CReactiveNavigationSystem::STEP1_InitPTGs();
+		return;
+	}
+
+	// The base class builds the cache file names from the log files
+	// directory: temporarily replace it by the cache directory.
+	if (!mrpt::system::directoryExists(ptgCacheDir_))
+		mrpt::system::createDirectory(ptgCacheDir_);
+
+	const std::string logDir = m_navlogfiles_dir;
+	m_navlogfiles_dir = ptgCacheDir_;
+	try
+	{
+		mrpt::nav::CReactiveNavigationSystem::STEP1_InitPTGs();
+	}
+	catch (...)
+	{
+		m_navlogfiles_dir = logDir;
+		throw;
+	}
+	m_navlogfiles_dir = logDir;
+}
+
+void ReactiveNavEngine::enableParallelPTGEvaluation(
+	bool enable, size_t numThreads)
+{
+	ptgResults_.clear();
+	if (!enable)
+	{
+		ptgThreadPool_.reset();
+		return;
+	}
+	if (numThreads == 0)
+		numThreads = std::max(1U, std::thread::hardware_concurrency());
+
+	ptgThreadPool_ = std::make_unique<mrpt::WorkerThreadsPool>(
+		numThreads, mrpt::WorkerThreadsPool::POLICY_FIFO, "ptg_eval");
+}
+
+bool ReactiveNavEngine::implementSenseObstacles(
+	mrpt::system::TTimeStamp& obs_timestamp)
+{
+	const bool ret =
+		mrpt::nav::CReactiveNavigationSystem::implementSenseObstacles(
+			obs_timestamp);
+
+	// Former results are not valid anymore:
+	ptgResults_.clear();
+	newObstaclesPending_ = true;
+	return ret;
+}
+
+void ReactiveNavEngine::evaluate_all_ptgs_in_parallel(
+	const mrpt::math::TPose2D& rel_pose_PTG_origin_wrt_sense,
+	const bool eval_clearance)
+{
+	mrpt::system::CTimeLoggerEntry tle(
+		m_timelogger, "navigationStep.STEP3_WSpaceToTPSpace.parallel");
+
+	const size_t nPTGs = getPTG_count();
+	ptgResults_.clear();
+	ptgResults_.resize(nPTGs);
+	ptgResultsRelPose_ = rel_pose_PTG_origin_wrt_sense;
+	ptgResultsEvalClearance_ = eval_clearance;
+
+	// Each task only reads the obstacles and writes to its own PTG result,
+	// hence no locks are needed:
+	std::vector<std::future<void>> tasks;
+	tasks.reserve(nPTGs);
+	for (size_t i = 0; i < nPTGs; i++)
+	{
+		tasks.emplace_back(ptgThreadPool_->enqueue(
+			[this, i, rel_pose_PTG_origin_wrt_sense, eval_clearance]()
+			{
+				const auto* ptg = getPTG(i);
+				auto& r = ptgResults_[i];
+
+				ptg->initTPObstacles(r.TPObstacles);
+				if (eval_clearance) ptg->initClearanceDiagram(r.clearance);
+
+				mrpt::nav::CReactiveNavigationSystem::STEP3_WSpaceToTPSpace(
+					i, r.TPObstacles, r.clearance,
+					rel_pose_PTG_origin_wrt_sense, eval_clearance);
+			}));
+	}
+	// Wait for all, and mark as valid only if all went well (get() rethrows
+	// any exception):
+	for (auto& t : tasks) t.get();
+	for (auto& r : ptgResults_) r.valid = true;
+}
+
+void ReactiveNavEngine::STEP3_WSpaceToTPSpace(
+	const size_t ptg_idx, std::vector<double>& out_TPObstacles,
+	mrpt::nav::ClearanceDiagram& out_clearance,
+	const mrpt::math::TPose2D& rel_pose_PTG_origin_wrt_sense,
+	const bool eval_clearance)
+{
+	if (!ptgThreadPool_ || getPTG_count() < 2)
+	{
+		mrpt::nav::CReactiveNavigationSystem::STEP3_WSpaceToTPSpace(
+			ptg_idx, out_TPObstacles, out_clearance,
+			rel_pose_PTG_origin_wrt_sense, eval_clearance);
+		return;
+	}
+
+	// The first call after sensing comes from the loop over all PTGs, all of
+	// them with the same relative pose: evaluate them all at once.
+	if (newObstaclesPending_)
+	{
+		newObstaclesPending_ = false;
+		evaluate_all_ptgs_in_parallel(
+			rel_pose_PTG_origin_wrt_sense, eval_clearance);
+	}
+
+	// Any other call (e.g. the evaluation of the current motion as a
+	// "NOP" candidate, with a different pose) falls back to serial mode:
+	if (ptg_idx >= ptgResults_.size() || !ptgResults_[ptg_idx].valid ||
+		!(ptgResultsRelPose_ == rel_pose_PTG_origin_wrt_sense) ||
+		ptgResultsEvalClearance_ != eval_clearance)
+	{
+		mrpt::nav::CReactiveNavigationSystem::STEP3_WSpaceToTPSpace(
+			ptg_idx, out_TPObstacles, out_clearance,
+			rel_pose_PTG_origin_wrt_sense, eval_clearance);
+		return;
+	}
+
+	auto& r = ptgResults_[ptg_idx];
+	r.valid = false;  // Each result can be used only once
+
+	// TP-Obstacles are updated by keeping the minimum collision-free
+	// distance, so merging them is equivalent to the serial evaluation:
+	ASSERT_EQUAL_(out_TPObstacles.size(), r.TPObstacles.size());
+	for (size_t k = 0; k < out_TPObstacles.size(); k++)
+		out_TPObstacles[k] = std::min(out_TPObstacles[k], r.TPObstacles[k]);
+
+	// The caller always passes a just-initialized clearance diagram:
+	if (eval_clearance) out_clearance = std::move(r.clearance);
+}
+
+void RobotPoseProvider::add_odometry(
+	const mrpt::math::TPose2D& odometry,
+	const mrpt::math::TTwist2D& velocityLocal,
+	const mrpt::system::TTimeStamp& timestamp)
+{
+	Output o;
+	o.odometry = odometry;
+	o.velocityLocal = velocityLocal;
+	o.timestamp = timestamp;
+
+	std::lock_guard<std::mutex> lck(mtx_);
+	lastOdometry_ = o;
+
+	// Out of order readings are not kept for interpolation:
+	if (!odometryHistory_.empty() &&
+		timestamp <= odometryHistory_.back().timestamp)
+		return;
+	odometryHistory_.push_back(o);
+	while (odometryHistory_.size() > 2 &&
+		   mrpt::system::timeDifference(
+			   odometryHistory_.front().timestamp, timestamp) >
+			   params.odometry_history)
+		odometryHistory_.pop_front();
+}
+
+void RobotPoseProvider::set_reference_to_odom(
+	const mrpt::math::TPose2D& refToOdom)
+{
+	std::lock_guard<std::mutex> lck(mtx_);
+	refToOdom_ = refToOdom;
+}
+
+std::optional<RobotPoseProvider::Output> RobotPoseProvider::latest_odometry()
+	const
+{
+	std::lock_guard<std::mutex> lck(mtx_);
+	return lastOdometry_;
+}
+
+std::optional<mrpt::math::TPose2D> RobotPoseProvider::odometry_at(
+	const mrpt::system::TTimeStamp& queryTime) const
+{
+	std::lock_guard<std::mutex> lck(mtx_);
+	if (odometryHistory_.empty()) return {};
+
+	const auto& last = odometryHistory_.back();
+	if (queryTime >= last.timestamp)
+	{
+		// Constant velocity model, as in get():
+		const double dt =
+			mrpt::system::timeDifference(last.timestamp, queryTime);
+		if (dt > params.max_extrapolation_time) return {};
+
+		const auto& v = last.velocityLocal;
+		const mrpt::poses::CPose2D incr(v.vx * dt, v.vy * dt, v.omega * dt);
+		return (mrpt::poses::CPose2D(last.odometry) + incr).asTPose();
+	}
+	if (queryTime < odometryHistory_.front().timestamp) return {};
+
+	// The first reading after queryTime, and the one before it:
+	const auto itB = std::upper_bound(
+		odometryHistory_.begin(), odometryHistory_.end(), queryTime,
+		[](const mrpt::system::TTimeStamp& t, const Output& o)
+		{ return t < o.timestamp; });
+	const auto& a = *(itB - 1);
+	const auto& b = *itB;
+
+	const double f = mrpt::system::timeDifference(a.timestamp, queryTime) /
+		mrpt::system::timeDifference(a.timestamp, b.timestamp);
+
+	// Interpolate the increment between both, in the frame of the first:
+	const mrpt::poses::CPose2D pa(a.odometry);
+	const mrpt::poses::CPose2D d = mrpt::poses::CPose2D(b.odometry) - pa;
+	return (pa + mrpt::poses::CPose2D(d.x() * f, d.y() * f, d.phi() * f))
+		.asTPose();
+}
+
+std::optional<RobotPoseProvider::Output> RobotPoseProvider::get(
+	const mrpt::system::TTimeStamp& queryTime) const
+{
+	std::optional<Output> odo;
+	mrpt::math::TPose2D refToOdom;
+	{
+		std::lock_guard<std::mutex> lck(mtx_);
+		if (!lastOdometry_ || !refToOdom_) return {};
+		odo = lastOdometry_;
+		refToOdom = *refToOdom_;
+	}
+
+	const double age = mrpt::system::timeDifference(odo->timestamp, queryTime);
+	if (age > params.max_odometry_age) return {};
+
+	Output out = *odo;
+
+	// Latency compensation: constant velocity model.
+	const double dt = std::clamp(age, 0.0, params.max_extrapolation_time);
+	if (dt > 0)
+	{
+		const auto& v = odo->velocityLocal;
+		const mrpt::poses::CPose2D incr(v.vx * dt, v.vy * dt, v.omega * dt);
+		out.odometry = (mrpt::poses::CPose2D(odo->odometry) + incr).asTPose();
+		out.timestamp = mrpt::system::timestampAdd(odo->timestamp, dt);
+	}
+	out.extrapolatedTime = dt;
+
+	out.pose = (mrpt::poses::CPose2D(refToOdom) +
+				mrpt::poses::CPose2D(out.odometry))
+				   .asTPose();
+
+	// From local to global:
+	out.velocityGlobal = out.velocityLocal;
+	out.velocityGlobal.rotate(out.pose.phi);
+
+	return out;
+}
+
+void ObstacleDecimator::reset()
+{
+	inputCount_ = 0;
+	passThrough_.clear();
+	gridCells_.clear();
+	polarBins_.clear();
+	if (params.decimation == Decimation::Polar)
+	{
+		ASSERT_GT_(params.polar_resolution, 0);
+		polarBins_.resize(
+			static_cast<size_t>(std::ceil(2 * M_PI / params.polar_resolution)));
+	}
+	if (params.decimation == Decimation::Grid)
+		ASSERT_GT_(params.grid_resolution, 0);
+}
+
+void ObstacleDecimator::add_point(float x, float y, float z)
+{
+	inputCount_++;
+
+	// Cropping:
+	if (z < params.min_z || z > params.max_z) return;
+
+	const float r2 = x * x + y * y;
+	if (r2 < params.min_range * params.min_range) return;
+	if (params.max_range > 0 && r2 > params.max_range * params.max_range)
+		return;
+
+	// Decimation:
+	Candidate* c = nullptr;
+	switch (params.decimation)
+	{
+		case Decimation::None:
+			passThrough_.insertPointFast(x, y, z);
+			return;
+
+		case Decimation::Polar:
+		{
+			const double ang = std::atan2(y, x) + M_PI;	 // [0,2pi]
+			const auto idx = std::min<size_t>(
+				static_cast<size_t>(ang / params.polar_resolution),
+				polarBins_.size() - 1);
+			c = &polarBins_[idx];
+		}
+		break;
+
+		case Decimation::Grid:
+		{
+			const auto cx = static_cast<int32_t>(
+				std::floor(x / params.grid_resolution));
+			const auto cy = static_cast<int32_t>(
+				std::floor(y / params.grid_resolution));
+			const uint64_t key = (static_cast<uint64_t>(
+									  static_cast<uint32_t>(cx))
+								  << 32) |
+				static_cast<uint32_t>(cy);
+			c = &gridCells_[key];
+		}
+		break;
+	};
+
+	// Keep the nearest one:
+	if (r2 < c->range2) *c = {x, y, z, r2};
+}
+
+void ObstacleDecimator::get_result(mrpt::maps::CSimplePointsMap& out) const
+{
+	switch (params.decimation)
+	{
+		case Decimation::None:
+			out = passThrough_;
+			break;
+
+		case Decimation::Polar:
+			out.clear();
+			out.reserve(polarBins_.size());
+			for (const auto& c : polarBins_)
+				if (c.range2 != std::numeric_limits<float>::max())
+					out.insertPointFast(c.x, c.y, c.z);
+			break;
+
+		case Decimation::Grid:
+			out.clear();
+			out.reserve(gridCells_.size());
+			for (const auto& [key, c] : gridCells_)
+				out.insertPointFast(c.x, c.y, c.z);
+			break;
+	};
+	out.mark_as_modified();
+}
+
+void ObstacleMemory::clear()
+{
+	cells_.clear();
+	lastMergedCount_ = 0;
+}
+
+ObstacleMemory::Cell& ObstacleMemory::cell_for(int32_t ix, int32_t iy)
+{
+	const auto wrap = [this](int32_t i)
+	{
+		const int32_t r = i % sideCells_;
+		return r < 0 ? r + sideCells_ : r;
+	};
+	return cells_[wrap(iy) * sideCells_ + wrap(ix)];
+}
+
+void ObstacleMemory::update_and_merge(
+	mrpt::maps::CSimplePointsMap& obstacles,
+	const mrpt::math::TPose2D& robotPose, double time)
+{
+	lastMergedCount_ = 0;
+	if (!params.enabled()) return;
+
+	ASSERT_GT_(params.resolution, 0.0);
+	ASSERT_GT_(params.radius, params.resolution);
+
+	// (Re)allocate the grid upon first use or parameter changes:
+	if (cells_.empty() || gridResolution_ != params.resolution)
+	{
+		gridResolution_ = params.resolution;
+		sideCells_ = static_cast<int32_t>(
+			std::ceil(2 * params.radius / gridResolution_));
+		cells_.assign(static_cast<size_t>(sideCells_) * sideCells_, Cell());
+	}
+
+	const auto toIdx = [this](double v)
+	{ return static_cast<int32_t>(std::floor(v / gridResolution_)); };
+
+	// Free space: the nearest obstacle of this scan in each direction, with
+	// directions binned so that bins are one cell wide at the memory radius.
+	// Directions without obstacles are unknown (e.g. out of the field of
+	// view), so nothing is cleared along them:
+	const size_t nBins = static_cast<size_t>(
+		std::ceil(2 * M_PI * params.radius / gridResolution_));
+	const auto binOf = [nBins](double x, double y)
+	{
+		const double a = (std::atan2(y, x) + M_PI) / (2 * M_PI);
+		return std::min(nBins - 1, static_cast<size_t>(a * nBins));
+	};
+	std::vector<double> nearest(nBins, std::numeric_limits<double>::max());
+
+	// Store the new obstacles:
+	const mrpt::poses::CPose2D pose(robotPose);
+	const auto& xs = obstacles.getPointsBufferRef_x();
+	const auto& ys = obstacles.getPointsBufferRef_y();
+	const size_t nNew = xs.size();
+	for (size_t i = 0; i < nNew; i++)
+	{
+		auto& n = nearest[binOf(xs[i], ys[i])];
+		n = std::min<double>(n, std::hypot(xs[i], ys[i]));
+
+		const auto g =
+			pose.composePoint(mrpt::math::TPoint2D(xs[i], ys[i]));
+		if (mrpt::square(g.x - robotPose.x) + mrpt::square(g.y - robotPose.y) >
+			mrpt::square(params.radius))
+			continue;
+
+		const int32_t ix = toIdx(g.x), iy = toIdx(g.y);
+		auto& c = cell_for(ix, iy);
+		c.ix = ix;
+		c.iy = iy;
+		c.x = static_cast<float>(g.x);
+		c.y = static_cast<float>(g.y);
+		c.lastSeen = time;
+	}
+
+	// Merge the remembered ones, still around the robot, in the robot frame:
+	const int32_t rx = toIdx(robotPose.x), ry = toIdx(robotPose.y);
+	const int32_t halfSide = sideCells_ / 2;
+	for (auto& c : cells_)
+	{
+		if (c.ix == std::numeric_limits<int32_t>::min()) continue;	// empty
+		if (c.lastSeen >= time) continue;  // already in this scan
+		if (time - c.lastSeen > params.decay_time) continue;  // too old
+		// Stale cells from a region the robot left long ago:
+		if (std::abs(c.ix - rx) > halfSide || std::abs(c.iy - ry) > halfSide)
+			continue;
+
+		const auto l =
+			pose.inverseComposePoint(mrpt::math::TPoint2D(c.x, c.y));
+
+		// Seen through by this scan: forget it.
+		if (l.norm() < nearest[binOf(l.x, l.y)] - gridResolution_)
+		{
+			c = Cell();
+			continue;
+		}
+
+		obstacles.insertPoint(l.x, l.y, 0);
+		lastMergedCount_++;
+	}
+}
+
+LatencyHistogram::LatencyHistogram(double maxValue, size_t numBins)
+	: bins_(numBins, 0), binWidth_(maxValue / numBins)
+{
+	ASSERT_GT_(maxValue, 0);
+	ASSERT_GT_(numBins, 0U);
+}
+
+void LatencyHistogram::add(double value)
+{
+	value = std::max(value, 0.0);
+	const auto idx = std::min<size_t>(
+		static_cast<size_t>(value / binWidth_), bins_.size() - 1);
+	bins_[idx]++;
+	count_++;
+	sum_ += value;
+	max_ = std::max(max_, value);
+}
+
+void LatencyHistogram::clear()
+{
+	std::fill(bins_.begin(), bins_.end(), 0);
+	count_ = 0;
+	sum_ = max_ = 0;
+}
+
+double LatencyHistogram::percentile(double p) const
+{
+	if (!count_) return 0;
+	const auto target = static_cast<size_t>(std::ceil(p * count_));
+	size_t acc = 0;
+	for (size_t i = 0; i < bins_.size(); i++)
+	{
+		acc += bins_[i];
+		if (acc >= target && acc > 0)
+			return std::min(max_, (i + 1) * binWidth_);
+	}
+	return max_;
+}
+
+std::string LatencyHistogram::asString() const
+{
+	return mrpt::format(
+		"n=%zu mean=%.02fms p50=%.02fms p90=%.02fms p99=%.02fms max=%.02fms",
+		count_, 1e3 * mean(), 1e3 * percentile(0.5), 1e3 * percentile(0.9),
+		1e3 * percentile(0.99), 1e3 * max_);
+}
+
+mrpt::math::TTwist2D StaleDataSpeedGate::new_command(
+	const mrpt::math::TTwist2D& cmd, bool staleData)
+{
+	last_ = cmd;
+	return staleData ? cmd * params.speed_factor : cmd;
+}
+
+std::optional<mrpt::math::TTwist2D> StaleDataSpeedGate::keep_command(
+	bool staleData)
+{
+	// The last command sent was already gated, if needed:
+	if (!staleData) return std::nullopt;
+	return last_ * params.speed_factor;
+}
+
+bool DiffDriveRobotInterface::stop([[maybe_unused]] bool isEmergency)
+{
+	mrpt::kinematics::CVehicleVelCmd_DiffDriven vel_cmd;
+	vel_cmd.lin_vel = 0;
+	vel_cmd.ang_vel = 0;
+	return changeSpeeds(vel_cmd);
+}
+
+mrpt::kinematics::CVehicleVelCmd::Ptr DiffDriveRobotInterface::getStopCmd()
+{
+	auto ret = mrpt::kinematics::CVehicleVelCmd_DiffDriven::Create();
+	ret->setToStop();
+	return ret;
+}
+
+void KinematicSimRobot::set_obstacles(
+	const mrpt::maps::CSimplePointsMap& obstacles)
+{
+	world_ = obstacles;
+}
+
+void KinematicSimRobot::reset(const mrpt::math::TPose2D& pose)
+{
+	timeOrigin_ = now();
+	sim_.resetStatus();
+	sim_.resetTime();
+	sim_.setCurrentGTPose(pose);
+	navTimerStart_ = 0;
+	events_ = Events();
+}
+
+void KinematicSimRobot::simulate(double dt) { sim_.simulateOneTimeStep(dt); }
+
+double KinematicSimRobot::nearest_obstacle_distance() const
+{
+	if (world_.empty()) return std::numeric_limits<double>::max();
+
+	const auto p = pose();
+	return std::sqrt(world_.kdTreeClosestPoint2DsqrError(
+		static_cast<float>(p.x), static_cast<float>(p.y)));
+}
+
+double KinematicSimRobot::nearest_obstacle_clearance(
+	const mrpt::nav::CParameterizedTrajectoryGenerator& ptg) const
+{
+	const auto p = pose();
+	const mrpt::poses::CPose2D robotPose(p);
+	const double maxRadius = ptg.getMaxRobotRadius();
+
+	double clearance = std::numeric_limits<double>::max();
+	const auto& xs = world_.getPointsBufferRef_x();
+	const auto& ys = world_.getPointsBufferRef_y();
+	for (size_t i = 0; i < xs.size(); i++)
+	{
+		// Obstacles farther than this cannot be any closer to the shape:
+		const double dx = xs[i] - p.x, dy = ys[i] - p.y;
+		if (std::hypot(dx, dy) - maxRadius >= clearance) continue;
+
+		const auto local = robotPose.inverseComposePoint(
+			mrpt::math::TPoint2D(xs[i], ys[i]));
+		clearance = std::min(
+			clearance, ptg.evalClearanceToRobotShape(local.x, local.y));
+	}
+	return clearance;
+}
+
+bool KinematicSimRobot::getCurrentPoseAndSpeeds(
+	mrpt::math::TPose2D& curPose, mrpt::math::TTwist2D& curVel,
+	mrpt::system::TTimeStamp& timestamp, mrpt::math::TPose2D& curOdometry,
+	std::string& frame_id)
+{
+	curPose = sim_.getCurrentGTPose();
+	curVel = sim_.getCurrentGTVel();
+	curOdometry = sim_.getCurrentOdometricPose();
+	// Data is always up to date wrt the simulation time:
+	timestamp = now();
+	frame_id = "map";
+	return true;
+}
+
+bool KinematicSimRobot::changeSpeeds(
+	const mrpt::kinematics::CVehicleVelCmd& vel_cmd)
+{
+	sim_.sendVelCmd(vel_cmd);
+	return true;
+}
+
+bool KinematicSimRobot::senseObstacles(
+	mrpt::maps::CSimplePointsMap& obstacles,
+	mrpt::system::TTimeStamp& timestamp)
+{
+	obstacles.clear();
+
+	const auto p = pose();
+	const mrpt::poses::CPose2D robotPose(p);
+	const double maxRange2 = mrpt::square(params.sensor_range);
+
+	const auto& xs = world_.getPointsBufferRef_x();
+	const auto& ys = world_.getPointsBufferRef_y();
+	for (size_t i = 0; i < xs.size(); i++)
+	{
+		const double dx = xs[i] - p.x, dy = ys[i] - p.y;
+		if (dx * dx + dy * dy > maxRange2) continue;
+
+		const auto local = robotPose.inverseComposePoint(
+			mrpt::math::TPoint2D(xs[i], ys[i]));
+		obstacles.insertPoint(local.x, local.y, 0);
+	}
+
+	timestamp = now();
+	return true;
+}
+
+void KinematicSimRobot::sendNavigationStartEvent()
+{
+	events_.navigationStarts++;
+	events_.navigationEndedSuccessfully.reset();
+}
+
+void KinematicSimRobot::sendNavigationEndEvent()
+{
+	events_.navigationEndedSuccessfully = true;
+}
+
+void KinematicSimRobot::sendWaypointReachedEvent(
+	[[maybe_unused]] int waypoint_index, bool reached_nSkipped)
+{
+	if (reached_nSkipped) events_.waypointsReached++;
+}
+
+void KinematicSimRobot::sendNavigationEndDueToErrorEvent()
+{
+	events_.navigationEndedSuccessfully = false;
+}
+
+void KinematicSimRobot::sendWaySeemsBlockedEvent()
+{
+	events_.waySeemsBlocked++;
+}
+
+void KinematicSimRobot::sendApparentCollisionEvent()
+{
+	events_.apparentCollisions++;
+}
+
+void KinematicSimRobot::sendCannotGetCloserToBlockedTargetEvent()
+{
+	events_.navigationEndedSuccessfully = false;
+}
+
+std::string mrpt_reactivenav2d::ptg_cache_key(
+	const mrpt::config::CConfigFileBase& cfg, const RobotShape& shape)
+{
+	// The robot shape is not part of the config section:
+	std::string s;
+	for (const auto& pt : shape.polygon)
+		s += mrpt::format("%.17g %.17g\n", pt.x, pt.y);
+	s += mrpt::format("%.17g\n", shape.circularRadius);
+
+	return mrpt_nav_common::ptg_cache_key(cfg, PTG_CACHE_SECTION, s);
+}
+
+bool mrpt_reactivenav2d::build_ptg_cache(
+	const mrpt::config::CConfigFileBase& cfg, const RobotShape& shape,
+	const std::string& dir)
+{
+	try
+	{
+		NullRobotInterface robot;
+		ReactiveNavEngine engine(
+			robot, false /*console output*/, false /*log file*/);
+
+		engine.loadConfigFile(cfg);
+		engine.changeRobotShape(shape);
+		engine.setPTGCacheDirectory(dir);
+		engine.initialize();  // this builds and saves the PTG tables
+
+		std::ofstream f(dir + "/" + PTG_CACHE_DONE_FILE);
+		if (!f.is_open()) return false;
+		f << ptg_cache_key(cfg, shape) << "\n";
+		return true;
+	}
+	catch (const std::exception& e)
+	{
+		std::cerr << "[build_ptg_cache] Error: " << e.what() << std::endl;
+		return false;
+	}
+}
+
+bool mrpt_reactivenav2d::ptg_cache_is_ready(const std::string& dir)
+{
+	return mrpt::system::fileExists(dir + "/" + PTG_CACHE_DONE_FILE);
+}
@@ -7,6 +7,7 @@
    +------------------------------------------------------------------------+ */
 
 #include <chrono>
+#include <mrpt/system/CTicTac.h>
 #include <mrpt_reactivenav2d/mrpt_reactivenav2d_node.hpp>
 #include <rclcpp_components/register_node_macro.hpp>
 
@@ -18,6 +19,22 @@ using namespace mrpt_reactivenav2d;
 
 RCLCPP_COMPONENTS_REGISTER_NODE(mrpt_reactivenav2d::ReactiveNav2DNode)
 
+namespace
+{
+/// Whether the cloud has the float32 "x", "y" and "z" fields we can read
+bool has_float32_xyz(const sensor_msgs::msg::PointCloud2& cloud)
+{
+	size_t found = 0;
+	for (const auto& f : cloud.fields)
+	{
+		if (f.name != "x" && f.name != "y" && f.name != "z") continue;
+		if (f.datatype != sensor_msgs::msg::PointField::FLOAT32) return false;
+		found++;
+	}
+	return found == 3;
+}
+}  // namespace
+
 /**  Constructor: Inits ROS system */
 ReactiveNav2DNode::ReactiveNav2DNode(const rclcpp::NodeOptions& options)
 	: Node("mrpt_reactivenav2d", options)
@@ -47,6 +64,8 @@ ReactiveNav2DNode::ReactiveNav2DNode(const rclcpp::NodeOptions& options)
 	}
 
 	rnavEngine_.enableLogFile(saveNavLog_);
+	rnavEngine_.enableParallelPTGEvaluation(
+		parallelPtgEvaluation_, static_cast<size_t>(parallelPtgThreads_));
 
 	// Load reactive config:
 	// ----------------------------------------------------
@@ -113,29 +132,25 @@ ReactiveNav2DNode::ReactiveNav2DNode(const rclcpp::NodeOptions& options)
 			"must have the same length!");
 		if (!xs.empty())
 		{
-			mrpt::math::CPolygon poly;
+			auto& poly = robotShape_.polygon;
 			poly.resize(xs.size());
 			for (size_t i = 0; i < xs.size(); i++)
 			{
 				poly[i].x = xs[i];
 				poly[i].y = ys[i];
 			}
-
-			std::lock_guard<std::mutex> csl(rnavEngineMtx_);
-			rnavEngine_.changeRobotShape(poly);
 		}
 
 		// Load robot shape: 2/2 circle
 		// ---------------------------------------------
-		if (const double robot_radius = c.read_double(
-				s, "RobotModel_circular_shape_radius", -1.0, false);
-			robot_radius > 0)
-		{
-			std::lock_guard<std::mutex> csl(rnavEngineMtx_);
-			rnavEngine_.changeRobotCircularShapeRadius(robot_radius);
-		}
+		robotShape_.circularRadius =
+			c.read_double(s, "RobotModel_circular_shape_radius", -1.0, false);
 	}
 
+	// Apply the shape, or start building the PTG tables for it if a cache
+	// directory is set. Does nothing if a shape already arrived via topic.
+	update_robot_shape(robotShape_);
+
 	// Init ROS publishers:
 	// -----------------------
 	auto qos = rclcpp::SystemDefaultsQoS();
@@ -150,6 +165,14 @@ ReactiveNav2DNode::ReactiveNav2DNode(const rclcpp::NodeOptions& options)
 	pubNavEvents_ =
 		this->create_publisher<std_msgs::msg::String>(pubTopicEvents_, qos);
 
+	pubNavLatency_ =
+		this->create_publisher<mrpt_nav_interfaces::msg::NavigationLatency>(
+			pubTopicNavLatency_, qos);
+
+	pubNavLatencyStats_ = this->create_publisher<
+		mrpt_nav_interfaces::msg::NavigationLatencyStats>(
+		pubTopicNavLatencyStats_, qos);
+
 	// Init ROS subs:
 	// -----------------------
 	subOdometry_ = this->create_subscription<nav_msgs::msg::Odometry>(
@@ -193,6 +216,8 @@ ReactiveNav2DNode::ReactiveNav2DNode(const rclcpp::NodeOptions& options)
 		std::bind(&ReactiveNav2DNode::handle_cancel_wp, this, _1),
 		std::bind(&ReactiveNav2DNode::handle_accepted_wp, this, _1));
 
+	debugMarkersThread_ = std::thread([this]() { debug_markers_thread(); });
+
 	// Init timer:
 	// ----------------------------------------------------
 	timerRunNav_ = this->create_wall_timer(
@@ -201,6 +226,16 @@ ReactiveNav2DNode::ReactiveNav2DNode(const rclcpp::NodeOptions& options)
 
 }  // end ctor
 
+ReactiveNav2DNode::~ReactiveNav2DNode()
+{
+	{
+		std::lock_guard<std::mutex> lck(debugMarkersMtx_);
+		debugMarkersThreadExit_ = true;
+	}
+	debugMarkersCv_.notify_one();
+	if (debugMarkersThread_.joinable()) debugMarkersThread_.join();
+}
+
 void ReactiveNav2DNode::read_parameters()
 {
 	declare_parameter<std::string>("cfg_file_reactive", cfgFileReactive_);
@@ -253,6 +288,112 @@ void ReactiveNav2DNode::read_parameters()
 	RCLCPP_INFO(
 		this->get_logger(), "pubTopicEvents: %s", pubTopicEvents_.c_str());
 
+	declare_parameter<std::string>(
+		"topic_nav_latency", pubTopicNavLatency_);
+	get_parameter("topic_nav_latency", pubTopicNavLatency_);
+	RCLCPP_INFO(
+		this->get_logger(), "topic_nav_latency: %s",
+		pubTopicNavLatency_.c_str());
+
+	declare_parameter<std::string>(
+		"topic_nav_latency_stats", pubTopicNavLatencyStats_);
+	get_parameter("topic_nav_latency_stats", pubTopicNavLatencyStats_);
+	RCLCPP_INFO(
+		this->get_logger(), "topic_nav_latency_stats: %s",
+		pubTopicNavLatencyStats_.c_str());
+
+	declare_parameter<double>("max_obstacles_age", maxObstaclesAge_);
+	get_parameter("max_obstacles_age", maxObstaclesAge_);
+	RCLCPP_INFO(
+		this->get_logger(), "max_obstacles_age: %f", maxObstaclesAge_);
+
+	declare_parameter<double>("max_pose_age", maxPoseAge_);
+	get_parameter("max_pose_age", maxPoseAge_);
+	RCLCPP_INFO(this->get_logger(), "max_pose_age: %f", maxPoseAge_);
+
+	auto& staleFactor = staleDataGate_.params.speed_factor;
+	declare_parameter<double>("stale_data_speed_factor", staleFactor);
+	get_parameter("stale_data_speed_factor", staleFactor);
+	RCLCPP_INFO(
+		this->get_logger(), "stale_data_speed_factor: %f", staleFactor);
+	ASSERT_GE_(staleFactor, 0.0);
+	ASSERT_LE_(staleFactor, 1.0);
+
+	declare_parameter<double>(
+		"action_watchdog_period", actionWatchdogPeriod_);
+	get_parameter("action_watchdog_period", actionWatchdogPeriod_);
+	RCLCPP_INFO(
+		this->get_logger(), "action_watchdog_period: %f",
+		actionWatchdogPeriod_);
+	ASSERT_GT_(actionWatchdogPeriod_, 0.0);
+
+	declare_parameter<double>("latency_report_period", latencyReportPeriod_);
+	get_parameter("latency_report_period", latencyReportPeriod_);
+	RCLCPP_INFO(
+		this->get_logger(), "latency_report_period: %f",
+		latencyReportPeriod_);
+
+	{
+		auto& dp = obstacleDecimator_.params;
+
+		declare_parameter<double>("obstacles_min_range", dp.min_range);
+		get_parameter("obstacles_min_range", dp.min_range);
+		declare_parameter<double>("obstacles_max_range", dp.max_range);
+		get_parameter("obstacles_max_range", dp.max_range);
+		declare_parameter<double>("obstacles_min_z", dp.min_z);
+		get_parameter("obstacles_min_z", dp.min_z);
+		declare_parameter<double>("obstacles_max_z", dp.max_z);
+		get_parameter("obstacles_max_z", dp.max_z);
+
+		std::string decimation = "none";
+		declare_parameter<std::string>("obstacles_decimation", decimation);
+		get_parameter("obstacles_decimation", decimation);
+		if (decimation == "none")
+			dp.decimation = ObstacleDecimator::Decimation::None;
+		else if (decimation == "polar")
+			dp.decimation = ObstacleDecimator::Decimation::Polar;
+		else if (decimation == "grid")
+			dp.decimation = ObstacleDecimator::Decimation::Grid;
+		else
+			THROW_EXCEPTION_FMT(
+				"Invalid 'obstacles_decimation' value: '%s' (valid: none, "
+				"polar, grid)",
+				decimation.c_str());
+
+		double polarResDeg = mrpt::RAD2DEG(dp.polar_resolution);
+		declare_parameter<double>(
+			"obstacles_polar_resolution_deg", polarResDeg);
+		get_parameter("obstacles_polar_resolution_deg", polarResDeg);
+		dp.polar_resolution = mrpt::DEG2RAD(polarResDeg);
+
+		declare_parameter<double>(
+			"obstacles_grid_resolution", dp.grid_resolution);
+		get_parameter("obstacles_grid_resolution", dp.grid_resolution);
+
+		RCLCPP_INFO(
+			this->get_logger(),
+			"obstacles: range=[%.02f,%.02f] z=[%g,%g] decimation=%s "
+			"polar_resolution_deg=%.02f grid_resolution=%.03f",
+			dp.min_range, dp.max_range, dp.min_z, dp.max_z,
+			decimation.c_str(), polarResDeg, dp.grid_resolution);
+	}
+
+	{
+		auto& mp = obstacleMemory_.params;
+
+		declare_parameter<double>("obstacle_memory_decay_time", mp.decay_time);
+		get_parameter("obstacle_memory_decay_time", mp.decay_time);
+		declare_parameter<double>("obstacle_memory_resolution", mp.resolution);
+		get_parameter("obstacle_memory_resolution", mp.resolution);
+		declare_parameter<double>("obstacle_memory_radius", mp.radius);
+		get_parameter("obstacle_memory_radius", mp.radius);
+
+		RCLCPP_INFO(
+			this->get_logger(),
+			"obstacle_memory: decay_time=%.02f resolution=%.03f radius=%.02f",
+			mp.decay_time, mp.resolution, mp.radius);
+	}
+
 	declare_parameter<std::string>("topic_obstacles", subTopicLocalObstacles_);
 	get_parameter("topic_obstacles", subTopicLocalObstacles_);
 	RCLCPP_INFO(
@@ -270,6 +411,55 @@ void ReactiveNav2DNode::read_parameters()
 	RCLCPP_INFO(
 		this->get_logger(), "save_nav_log: %s", saveNavLog_ ? "yes" : "no");
 
+	declare_parameter<double>(
+		"odometry_max_age", poseProvider_.params.max_odometry_age);
+	get_parameter("odometry_max_age", poseProvider_.params.max_odometry_age);
+	RCLCPP_INFO(
+		this->get_logger(), "odometry_max_age: %f",
+		poseProvider_.params.max_odometry_age);
+
+	declare_parameter<double>(
+		"pose_max_extrapolation_time",
+		poseProvider_.params.max_extrapolation_time);
+	get_parameter(
+		"pose_max_extrapolation_time",
+		poseProvider_.params.max_extrapolation_time);
+	RCLCPP_INFO(
+		this->get_logger(), "pose_max_extrapolation_time: %f",
+		poseProvider_.params.max_extrapolation_time);
+
+	declare_parameter<bool>("parallel_ptg_evaluation", parallelPtgEvaluation_);
+	get_parameter("parallel_ptg_evaluation", parallelPtgEvaluation_);
+	RCLCPP_INFO(
+		this->get_logger(), "parallel_ptg_evaluation: %s",
+		parallelPtgEvaluation_ ? "yes" : "no");
+
+	declare_parameter<int>("parallel_ptg_threads", parallelPtgThreads_);
+	get_parameter("parallel_ptg_threads", parallelPtgThreads_);
+	RCLCPP_INFO(
+		this->get_logger(), "parallel_ptg_threads: %i", parallelPtgThreads_);
+	ASSERT_GE_(parallelPtgThreads_, 0);
+
+	declare_parameter<std::string>("ptg_cache_dir", ptgCacheDir_);
+	get_parameter("ptg_cache_dir", ptgCacheDir_);
+	RCLCPP_INFO(
+		this->get_logger(), "ptg_cache_dir: %s",
+		ptgCacheDir_.empty() ? "(none)" : ptgCacheDir_.c_str());
+
+	declare_parameter<bool>("publish_debug_markers", publishDebugMarkers_);
+	get_parameter("publish_debug_markers", publishDebugMarkers_);
+	RCLCPP_INFO(
+		this->get_logger(), "publish_debug_markers: %s",
+		publishDebugMarkers_ ? "yes" : "no");
+
+	declare_parameter<int>(
+		"debug_markers_decimation", debugMarkersDecimation_);
+	get_parameter("debug_markers_decimation", debugMarkersDecimation_);
+	RCLCPP_INFO(
+		this->get_logger(), "debug_markers_decimation: %i",
+		debugMarkersDecimation_);
+	ASSERT_GE_(debugMarkersDecimation_, 1);
+
 	declare_parameter<bool>("pure_pursuit_mode", pure_pursuit_mode_);
 	get_parameter("pure_pursuit_mode", pure_pursuit_mode_);
 	RCLCPP_INFO(
@@ -344,10 +534,25 @@ void ReactiveNav2DNode::navigate_to(const mrpt::math::TPose2D& target)
 /** Callback: On run navigation */
 void ReactiveNav2DNode::on_do_navigation()
 {
+	check_ptg_cache_build();
+
 	// 1st time init:
 	// ----------------------------------------------------
 	if (!initialized_)
 	{
+		if (!ptgCacheDir_.empty())
+		{
+			std::lock_guard<std::mutex> lck(ptgCacheMtx_);
+			if (ptgCacheKey_.empty())
+			{
+				RCLCPP_INFO_THROTTLE(
+					this->get_logger(), *this->get_clock(), 5000,
+					"[ReactiveNav2DNode] Waiting for the PTG tables to be "
+					"built...");
+				return;
+			}
+		}
+
 		initialized_ = true;
 		RCLCPP_INFO(
 			this->get_logger(),
@@ -362,38 +567,154 @@ void ReactiveNav2DNode::on_do_navigation()
 			"[ReactiveNav2DNode] Reactive navigation engine init done!");
 	}
 
-	rnavEngine_.enableKeepLogRecords();
+	// Log records are only needed for the debug markers:
+	const bool wantDebugMarkers = debug_markers_wanted();
+	rnavEngine_.enableKeepLogRecords(wantDebugMarkers);
+
+	currentStep_ = StepTiming();
+	currentStep_.stepStart = ros_now();
 
+	mrpt::system::CTicTac stepTimer;
 	CTimeLoggerEntry tle(profiler_, "on_do_navigation");
 	// Main nav loop (in whatever state nav is: IDLE, NAVIGATING, etc.)
 	rnavEngine_.navigationStep();
 
 	tle.stop();
+	const double stepTime = stepTimer.Tac();
+
+	report_step_latency(stepTime);
+
+	if (wantDebugMarkers)
+	{
+		// get last decision and publish it to the ROS system for debugging:
+		mrpt::nav::CLogFileRecord lr;
+		rnavEngine_.getLastLogRecord(lr);
+
+		publish_last_log_record_to_ros(lr);
+	}
+}
+
+bool ReactiveNav2DNode::debug_markers_wanted()
+{
+	if (!publishDebugMarkers_ || pubSelectedPtg_->get_subscription_count() == 0)
+		return false;
+
+	return (debugMarkersStepCounter_++ % debugMarkersDecimation_) == 0;
+}
+
+void ReactiveNav2DNode::report_step_latency(double stepTime)
+{
+	const auto& st = currentStep_;
+
+	// Nothing to report if not navigating:
+	if (!st.poseAge) return;
+
+	histStepTime_.add(stepTime);
+	if (st.obstaclesAge) histObstaclesAge_.add(*st.obstaclesAge);
+	histPoseAge_.add(*st.poseAge);
+	if (st.cmdPublishDelay) histCmdPublishDelay_.add(*st.cmdPublishDelay);
+
+	if (pubNavLatency_->get_subscription_count() > 0)
+	{
+		mrpt_nav_interfaces::msg::NavigationLatency msg;
+		msg.header.stamp = mrpt::ros2bridge::toROS(st.stepStart);
+		msg.header.frame_id = frameidRobot_;
+		msg.obstacles_age = st.obstaclesAge.value_or(0);
+		msg.pose_age = *st.poseAge;
+		msg.step_time = stepTime;
+		msg.cmd_publish_delay = st.cmdPublishDelay.value_or(-1);
+		msg.stale_data = st.staleData;
+		pubNavLatency_->publish(msg);
+	}
 
-	// get last decision and publish it to the ROS system for debugging:
-	mrpt::nav::CLogFileRecord lr;
-	rnavEngine_.getLastLogRecord(lr);
+	if (latencyReportPeriod_ <= 0) return;
+
+	const auto now = ros_now();
+	if (lastLatencyReport_ == INVALID_TIMESTAMP) lastLatencyReport_ = now;
+	if (mrpt::system::timeDifference(lastLatencyReport_, now) <
+		latencyReportPeriod_)
+		return;
+	lastLatencyReport_ = now;
+
+	RCLCPP_INFO_STREAM(
+		this->get_logger(),
+		"[ReactiveNav2DNode] Latency stats:"
+			<< "\n obstacles age     : " << histObstaclesAge_.asString()
+			<< "\n pose age          : " << histPoseAge_.asString()
+			<< "\n step time         : " << histStepTime_.asString()
+			<< "\n cmd publish delay : " << histCmdPublishDelay_.asString());
+
+	if (pubNavLatencyStats_->get_subscription_count() > 0)
+	{
+		auto toMsg = [](const LatencyHistogram& h)
+		{
+			mrpt_nav_interfaces::msg::LatencyStats m;
+			m.count = static_cast<uint32_t>(h.count());
+			m.mean = h.mean();
+			m.p50 = h.percentile(0.50);
+			m.p90 = h.percentile(0.90);
+			m.p99 = h.percentile(0.99);
+			m.max = h.max();
+			return m;
+		};
+
+		mrpt_nav_interfaces::msg::NavigationLatencyStats msg;
+		msg.header.stamp = mrpt::ros2bridge::toROS(now);
+		msg.header.frame_id = frameidRobot_;
+		msg.obstacles_age = toMsg(histObstaclesAge_);
+		msg.pose_age = toMsg(histPoseAge_);
+		msg.step_time = toMsg(histStepTime_);
+		msg.cmd_publish_delay = toMsg(histCmdPublishDelay_);
+		pubNavLatencyStats_->publish(msg);
+	}
 
-	publish_last_log_record_to_ros(lr);
+	histObstaclesAge_.clear();
+	histPoseAge_.clear();
+	histStepTime_.clear();
+	histCmdPublishDelay_.clear();
 }
 
 void ReactiveNav2DNode::on_odometry_received(
 	const nav_msgs::msg::Odometry::SharedPtr& msg)
 {
-	std::lock_guard<std::mutex> csl(odometryMtx_);
 	tf2::Quaternion quat(
 		msg->pose.pose.orientation.x, msg->pose.pose.orientation.y,
 		msg->pose.pose.orientation.z, msg->pose.pose.orientation.w);
 	tf2::Matrix3x3 mat(quat);
 	double roll, pitch, yaw;
 	mat.getRPY(roll, pitch, yaw);
-	odometry_.odometry = mrpt::poses::CPose2D(
-		msg->pose.pose.position.x, msg->pose.pose.position.y, yaw);
 
-	odometry_.velocityLocal.vx = msg->twist.twist.linear.x;
-	odometry_.velocityLocal.vy = msg->twist.twist.linear.y;
-	odometry_.velocityLocal.omega = msg->twist.twist.angular.z;
-	odometry_.hasVelocities = true;
+	poseProvider_.add_odometry(
+		{msg->pose.pose.position.x, msg->pose.pose.position.y, yaw},
+		{msg->twist.twist.linear.x, msg->twist.twist.linear.y,
+		 msg->twist.twist.angular.z},
+		mrpt::ros2bridge::fromROS(msg->header.stamp));
+
+	// Keep the latest reference-to-odom transform, if available, without
+	// blocking:
+	const std::string& odomFrame = msg->header.frame_id;
+	if (odomFrame == frameidReference_)
+	{
+		poseProvider_.set_reference_to_odom(mrpt::math::TPose2D::Identity());
+	}
+	else if (tfBuffer_->canTransform(
+				 frameidReference_, odomFrame, tf2::TimePointZero))
+	{
+		try
+		{
+			const auto tfGeom = tfBuffer_->lookupTransform(
+				frameidReference_, odomFrame, tf2::TimePointZero);
+
+			tf2::Transform tf;
+			tf2::fromMsg(tfGeom.transform, tf);
+			poseProvider_.set_reference_to_odom(
+				mrpt::poses::CPose2D(mrpt::ros2bridge::fromROS(tf)).asTPose());
+		}
+		catch (const tf2::TransformException& ex)
+		{
+			RCLCPP_DEBUG(this->get_logger(), "%s", ex.what());
+		}
+	}
 
 	RCLCPP_DEBUG_STREAM(this->get_logger(), "Odometry updated");
 }
@@ -469,11 +790,122 @@ void ReactiveNav2DNode::on_goal_received(
 void ReactiveNav2DNode::on_local_obstacles(
 	const sensor_msgs::msg::PointCloud2::SharedPtr& obs)
 {
-	std::lock_guard<std::mutex> csl(lastObstaclesMtx_);
-	mrpt::ros2bridge::fromROS(*obs, lastObstacles_);
+	if (!has_float32_xyz(*obs))
+	{
+		RCLCPP_WARN_THROTTLE(
+			this->get_logger(), *this->get_clock(), 5000,
+			"Ignoring local obstacles: the point cloud must have float32 "
+			"'x', 'y' and 'z' fields.");
+		return;
+	}
+
+	// Obstacles are used in the robot frame. Clouds in other frames are
+	// transformed with the latest TF:
+	std::optional<mrpt::poses::CPose3D> cloudPose;
+	if (!obs->header.frame_id.empty() && obs->header.frame_id != frameidRobot_)
+	{
+		try
+		{
+			tf2::Transform tf;
+			tf2::fromMsg(
+				tfBuffer_
+					->lookupTransform(
+						frameidRobot_, obs->header.frame_id,
+						tf2::TimePointZero)
+					.transform,
+				tf);
+			cloudPose = mrpt::ros2bridge::fromROS(tf);
+		}
+		catch (const tf2::TransformException& ex)
+		{
+			RCLCPP_WARN_THROTTLE(
+				this->get_logger(), *this->get_clock(), 5000,
+				"Ignoring local obstacles in frame '%s': no transform to the "
+				"robot frame '%s', handling obstacles as stale data: %s",
+				obs->header.frame_id.c_str(), frameidRobot_.c_str(),
+				ex.what());
+
+			// Do not keep on navigating with the former obstacles as if they
+			// were up to date (see input_data_is_stale()):
+			const auto former = std::atomic_load(&lastObstacles_);
+			if (!former->outdated)
+			{
+				auto outdated = std::make_shared<ObstaclesSnapshot>(*former);
+				outdated->outdated = true;
+				std::atomic_store(
+					&lastObstacles_, std::shared_ptr<const ObstaclesSnapshot>(
+										 std::move(outdated)));
+			}
+			return;
+		}
+	}
+
+	// Convert into a new buffer without holding any lock, then publish it:
+	auto newObstacles = std::make_shared<ObstaclesSnapshot>();
+	newObstacles->timestamp = mrpt::ros2bridge::fromROS(obs->header.stamp);
+
+	auto& decim = obstacleDecimator_;
+	if (!decim.params.enabled())
+	{
+		mrpt::ros2bridge::fromROS(*obs, newObstacles->points);
+		if (cloudPose)
+			newObstacles->points.changeCoordinatesReference(*cloudPose);
+	}
+	else
+	{
+		// Crop and decimate while reading the message (in the robot frame):
+		decim.reset();
+		sensor_msgs::PointCloud2ConstIterator<float> itX(*obs, "x");
+		sensor_msgs::PointCloud2ConstIterator<float> itY(*obs, "y");
+		sensor_msgs::PointCloud2ConstIterator<float> itZ(*obs, "z");
+		for (; itX != itX.end(); ++itX, ++itY, ++itZ)
+		{
+			if (!cloudPose)
+			{
+				decim.add_point(*itX, *itY, *itZ);
+				continue;
+			}
+			double x, y, z;
+			cloudPose->composePoint(*itX, *itY, *itZ, x, y, z);
+			decim.add_point(
+				static_cast<float>(x), static_cast<float>(y),
+				static_cast<float>(z));
+		}
+
+		decim.get_result(newObstacles->points);
+	}
+
+	// Remember obstacles out of the sensors view for a while. Odometry, at
+	// the time of the scan, is used to keep track of their position relative
+	// to the robot:
+	if (obstacleMemory_.params.enabled())
+	{
+		if (const auto odo = poseProvider_.odometry_at(newObstacles->timestamp);
+			odo)
+		{
+			obstacleMemory_.update_and_merge(
+				newObstacles->points, *odo,
+				mrpt::Clock::toDouble(newObstacles->timestamp));
+		}
+		else
+		{
+			RCLCPP_WARN_THROTTLE(
+				this->get_logger(), *this->get_clock(), 5000,
+				"Obstacle memory is enabled, but there is no odometry at the "
+				"time of the obstacles: not using the memory for them.");
+		}
+	}
+
 	RCLCPP_DEBUG(
-		this->get_logger(), "Local obstacles received: %u points",
-		static_cast<unsigned int>(lastObstacles_.size()));
+		this->get_logger(),
+		"Local obstacles received: %u points (%u input, %u from memory)",
+		static_cast<unsigned int>(newObstacles->points.size()),
+		static_cast<unsigned int>(obs->width * obs->height),
+		static_cast<unsigned int>(obstacleMemory_.last_merged_count()));
+
+	std::atomic_store(
+		&lastObstacles_,
+		std::shared_ptr<const ObstaclesSnapshot>(std::move(newObstacles)));
 }
 
 void ReactiveNav2DNode::on_set_robot_shape(
@@ -489,7 +921,8 @@ void ReactiveNav2DNode::on_set_robot_shape(
 											  << ", z: " << point.z);
 	}
 
-	mrpt::math::CPolygon poly;
+	RobotShape shape;
+	auto& poly = shape.polygon;
 	poly.resize(newShape->points.size());
 	for (size_t i = 0; i < newShape->points.size(); i++)
 	{
@@ -497,10 +930,106 @@ void ReactiveNav2DNode::on_set_robot_shape(
 		poly[i].y = newShape->points[i].y;
 	}
 
+	update_robot_shape(shape);
+}
+
+void ReactiveNav2DNode::update_robot_shape(const RobotShape& shape)
+{
+	std::lock_guard<std::mutex> lck(ptgCacheMtx_);
+	robotShape_ = shape;
+
+	if (ptgCacheDir_.empty())
+	{
+		// No cache: the engine will rebuild the PTGs in its next step.
+		std::lock_guard<std::mutex> csl(rnavEngineMtx_);
+		rnavEngine_.changeRobotShape(shape);
+		return;
+	}
+
+	const std::string key =
+		ptg_cache_key(CConfigFile(cfgFileReactive_), robotShape_);
+
+	if (ptgCacheBuild_.valid())
+	{
+		// Wait for the ongoing build to end before starting a new one:
+		if (key != ptgCacheBuildKey_)
+			ptgCacheQueuedShape_ = shape;
+		else
+			ptgCacheQueuedShape_.reset();
+		return;
+	}
+	if (key == ptgCacheKey_)
+	{
+		RCLCPP_DEBUG(
+			this->get_logger(), "PTG tables '%s' already in use.", key.c_str());
+		return;
+	}
+
+	const std::string dir = ptg_cache_dir_for_key(key);
+	if (ptg_cache_is_ready(dir))
 	{
+		RCLCPP_INFO(
+			this->get_logger(), "Using cached PTG tables from: %s",
+			dir.c_str());
+
 		std::lock_guard<std::mutex> csl(rnavEngineMtx_);
-		rnavEngine_.changeRobotShape(poly);
+		rnavEngine_.setPTGCacheDirectory(dir);
+		rnavEngine_.changeRobotShape(shape);
+		ptgCacheKey_ = key;
+		return;
+	}
+
+	RCLCPP_INFO(
+		this->get_logger(),
+		"Building PTG tables in the background into: %s", dir.c_str());
+
+	ptgCacheBuildKey_ = key;
+	ptgCacheBuildShape_ = shape;
+	// Not std::async(), whose future would block the node destructor until
+	// the build ends:
+	std::packaged_task<bool()> build(
+		[cfgFile = cfgFileReactive_, shape, dir]()
+		{ return build_ptg_cache(CConfigFile(cfgFile), shape, dir); });
+	ptgCacheBuild_ = build.get_future();
+	std::thread(std::move(build)).detach();
+}
+
+void ReactiveNav2DNode::check_ptg_cache_build()
+{
+	std::optional<RobotShape> queuedShape;
+	{
+		std::lock_guard<std::mutex> lck(ptgCacheMtx_);
+		if (!ptgCacheBuild_.valid() ||
+			ptgCacheBuild_.wait_for(std::chrono::seconds(0)) !=
+				std::future_status::ready)
+			return;
+
+		const std::string dir = ptg_cache_dir_for_key(ptgCacheBuildKey_);
+		if (ptgCacheBuild_.get())
+		{
+			RCLCPP_INFO(
+				this->get_logger(), "PTG tables built OK into: %s",
+				dir.c_str());
+		}
+		else
+		{
+			RCLCPP_WARN(
+				this->get_logger(),
+				"Error building PTG tables into '%s': the navigation engine "
+				"will build them instead.",
+				dir.c_str());
+		}
+
+		{
+			std::lock_guard<std::mutex> csl(rnavEngineMtx_);
+			rnavEngine_.setPTGCacheDirectory(dir);
+			rnavEngine_.changeRobotShape(ptgCacheBuildShape_);
+		}
+		ptgCacheKey_ = ptgCacheBuildKey_;
+		queuedShape.swap(ptgCacheQueuedShape_);
 	}
+
+	if (queuedShape) update_robot_shape(*queuedShape);
 }
 
 bool ReactiveNav2DNode::waitForTransform(
@@ -535,17 +1064,46 @@ bool ReactiveNav2DNode::waitForTransform(
 void ReactiveNav2DNode::publish_last_log_record_to_ros(
 	const mrpt::nav::CLogFileRecord& lr)
 {
-	pubSelectedPtg_->publish(log_to_margers(lr));
+	DebugMarkersJob job;
+	job.stamp = this->get_clock()->now();
+	job.path = selected_ptg_path(lr);
+
+	// Hand it over to the publisher thread. Former pending jobs, if any, are
+	// outdated and just dropped:
+	{
+		std::lock_guard<std::mutex> lck(debugMarkersMtx_);
+		debugMarkersJob_ = std::move(job);
+	}
+	debugMarkersCv_.notify_one();
+}
+
+void ReactiveNav2DNode::debug_markers_thread()
+{
+	for (;;)
+	{
+		DebugMarkersJob job;
+		{
+			std::unique_lock<std::mutex> lck(debugMarkersMtx_);
+			debugMarkersCv_.wait(
+				lck,
+				[this]()
+				{ return debugMarkersThreadExit_ || debugMarkersJob_; });
+			if (debugMarkersThreadExit_) return;
+
+			job = std::move(*debugMarkersJob_);
+			debugMarkersJob_.reset();
+		}
+
+		pubSelectedPtg_->publish(path_to_markers(job.path, job.stamp));
+	}
 }
 
-visualization_msgs::msg::MarkerArray ReactiveNav2DNode::log_to_margers(
+std::vector<mrpt::math::TPose2D> ReactiveNav2DNode::selected_ptg_path(
 	const mrpt::nav::CLogFileRecord& lr)
 {
 	if (!lr.nPTGs || lr.nSelectedPTG < 0 ||
 		lr.nSelectedPTG >= static_cast<int32_t>(lr.nPTGs))
-		return visualization_msgs::msg::MarkerArray();
-
-	visualization_msgs::msg::MarkerArray msg;
+		return {};
 
 	const auto* ptg = rnavEngine_.getPTG(lr.nSelectedPTG);
 	const auto& ipp = lr.infoPerPTG.at(lr.nSelectedPTG);
@@ -558,11 +1116,25 @@ visualization_msgs::msg::MarkerArray ReactiveNav2DNode::log_to_margers(
 	const auto nStepsToDraw =
 		std::min<size_t>(nSteps - 1, timeToDraw / ptg->getPathStepDuration());
 
+	std::vector<mrpt::math::TPose2D> path(nStepsToDraw);
+	for (size_t i = 0; i < nStepsToDraw; i++) path[i] = ptg->getPathPose(k, i);
+
+	return path;
+}
+
+visualization_msgs::msg::MarkerArray ReactiveNav2DNode::path_to_markers(
+	const std::vector<mrpt::math::TPose2D>& path,
+	const rclcpp::Time& stamp) const
+{
+	if (path.empty()) return visualization_msgs::msg::MarkerArray();
+
+	visualization_msgs::msg::MarkerArray msg;
+
 	msg.markers.resize(1);
 	auto& m = msg.markers[0];
 
 	m.header.frame_id = frameidRobot_;
-	m.header.stamp = this->get_clock()->now();
+	m.header.stamp = stamp;
 	m.frame_locked = true;
 
 	m.pose = mrpt::ros2bridge::toROS_Pose(mrpt::poses::CPose3D::Identity());
@@ -575,18 +1147,16 @@ visualization_msgs::msg::MarkerArray ReactiveNav2DNode::log_to_margers(
 	m.scale.y = 0.02;
 	m.scale.z = 0.01;
 
-	m.points.resize(nStepsToDraw);
+	m.points.resize(path.size());
 	m.color.a = 0.8;
 	m.color.r = 1.0;
 	m.color.g = 0.0;
 	m.color.b = 0.0;
 
-	for (size_t i = 0; i < nStepsToDraw; i++)
+	for (size_t i = 0; i < path.size(); i++)
 	{
-		const auto p = ptg->getPathPose(k, i);
-
-		m.points[i].x = p.x;
-		m.points[i].y = p.y;
+		m.points[i].x = path[i].x;
+		m.points[i].y = path[i].y;
 		m.points[i].z = 0;
 	}
 
@@ -600,6 +1170,53 @@ void ReactiveNav2DNode::publish_event_message(const std::string& text)
 	pubNavEvents_->publish(msg);
 }
 
+void ReactiveNav2DNode::signal_nav_event(
+	const std::optional<bool>& navEndedSuccessfully)
+{
+	{
+		auto lck = mrpt::lockHelper(currentNavEndedSuccessfullyMtx_);
+		if (navEndedSuccessfully.has_value())
+			currentNavEndedSuccessfully_ = navEndedSuccessfully;
+		navEventCounters_.events++;
+	}
+	navEventsCv_.notify_all();
+}
+
+void ReactiveNav2DNode::signal_cancel_request()
+{
+	// The action server moves the goal into the CANCELING state right after
+	// handle_cancel() returns. The executor runs this timer only after that,
+	// so the woken up action threads always see is_canceling().
+	cancelSignalTimer_ = this->create_wall_timer(
+		std::chrono::milliseconds(0),
+		[this]()
+		{
+			cancelSignalTimer_->cancel();
+			{
+				auto lck = mrpt::lockHelper(currentNavEndedSuccessfullyMtx_);
+				navEventCounters_.cancelRequests++;
+			}
+			navEventsCv_.notify_all();
+		});
+}
+
+bool ReactiveNav2DNode::wait_for_nav_event(NavEventCounters& lastSeen)
+{
+	std::unique_lock<std::mutex> lck(currentNavEndedSuccessfullyMtx_);
+	navEventsCv_.wait_for(
+		lck, std::chrono::duration<double>(actionWatchdogPeriod_),
+		[&]()
+		{
+			return navEventCounters_.events != lastSeen.events ||
+				navEventCounters_.cancelRequests != lastSeen.cancelRequests;
+		});
+
+	const bool newCancelRequest =
+		navEventCounters_.cancelRequests != lastSeen.cancelRequests;
+	lastSeen = navEventCounters_;
+	return newCancelRequest;
+}
+
 // ACTION INTERFACE: NavigateGoal
 // --------------------------------------
 rclcpp_action::GoalResponse ReactiveNav2DNode::handle_goal(
@@ -623,6 +1240,7 @@ rclcpp_action::CancelResponse ReactiveNav2DNode::handle_cancel(
 		std::lock_guard<std::mutex> csl(rnavEngineMtx_);
 		rnavEngine_.cancel();
 	}
+	signal_cancel_request();
 	return rclcpp_action::CancelResponse::ACCEPT;
 }
 
@@ -655,7 +1273,6 @@ void ReactiveNav2DNode::execute_action_goal(
 
 	this->navigate_to(trgPose2D);
 
-	rclcpp::Rate loop_rate(1);
 	auto feedback = std::make_shared<NavigateGoal::Feedback>();
 	auto result = std::make_shared<NavigateGoal::Result>();
 
@@ -665,6 +1282,13 @@ void ReactiveNav2DNode::execute_action_goal(
 		return rnavEngine_.getCurrentState();
 	};
 
+	NavEventCounters seenEvents;
+	{
+		auto lck = mrpt::lockHelper(currentNavEndedSuccessfullyMtx_);
+		seenEvents = navEventCounters_;
+	}
+	bool feedbackPublished = false;
+
 	while (rclcpp::ok())
 	{
 		// Check if there is a cancel request
@@ -691,17 +1315,22 @@ void ReactiveNav2DNode::execute_action_goal(
 			return;
 		}
 
-		// Publish feedback
-		feedback->state.total_waypoints = 1;  // this is a single WP action
-		feedback->state.reached_waypoints = 0;
+		// Publish feedback (it never changes for a single WP action)
+		if (!feedbackPublished)
+		{
+			feedback->state.total_waypoints = 1;
+			feedback->state.reached_waypoints = 0;
 
-		goal_handle->publish_feedback(feedback);
+			goal_handle->publish_feedback(feedback);
+			feedbackPublished = true;
+		}
 
 		// end of nav?
 		if (curNavEnded.has_value() && *curNavEnded == true) break;	 // success
 
-		// wait and repeat
-		loop_rate.sleep();
+		// wait for the next navigation event and repeat
+		if (wait_for_nav_event(seenEvents) && !goal_handle->is_canceling())
+			RCLCPP_DEBUG(get_logger(), "Cancel request was for another goal");
 	}
 
 	// Check if goal is done
@@ -738,6 +1367,7 @@ rclcpp_action::CancelResponse ReactiveNav2DNode::handle_cancel_wp(
 		std::lock_guard<std::mutex> csl(rnavEngineMtx_);
 		rnavEngine_.cancel();
 	}
+	signal_cancel_request();
 	return rclcpp_action::CancelResponse::ACCEPT;
 }
 
@@ -761,7 +1391,6 @@ void ReactiveNav2DNode::execute_action_wp(
 
 	update_waypoint_sequence(goal_handle->get_goal()->waypoints);
 
-	rclcpp::Rate loop_rate(1);
 	auto feedback = std::make_shared<NavigateWaypoints::Feedback>();
 	auto result = std::make_shared<NavigateWaypoints::Result>();
 
@@ -776,6 +1405,13 @@ void ReactiveNav2DNode::execute_action_wp(
 		return rnavEngine_.getWaypointNavStatus();
 	};
 
+	NavEventCounters seenEvents;
+	{
+		auto lck = mrpt::lockHelper(currentNavEndedSuccessfullyMtx_);
+		seenEvents = navEventCounters_;
+	}
+	std::optional<std::pair<size_t, int>> lastFeedback;
+
 	while (rclcpp::ok())
 	{
 		// Check if there is a cancel request
@@ -802,18 +1438,25 @@ void ReactiveNav2DNode::execute_action_wp(
 			return;
 		}
 
-		// Publish feedback
+		// Publish feedback, only if it changed:
 		const auto wps = getWpStatus();
-		feedback->state.total_waypoints = wps.waypoints.size();
-		feedback->state.reached_waypoints = wps.waypoint_index_current_goal;
+		const auto curFeedback = std::make_pair(
+			wps.waypoints.size(), wps.waypoint_index_current_goal);
+		if (curFeedback != lastFeedback)
+		{
+			feedback->state.total_waypoints = curFeedback.first;
+			feedback->state.reached_waypoints = curFeedback.second;
 
-		goal_handle->publish_feedback(feedback);
+			goal_handle->publish_feedback(feedback);
+			lastFeedback = curFeedback;
+		}
 
 		// end of nav?
 		if (wps.final_goal_reached) break;	// successful
 
-		// wait and repeat
-		loop_rate.sleep();
+		// wait for the next navigation event and repeat
+		if (wait_for_nav_event(seenEvents) && !goal_handle->is_canceling())
+			RCLCPP_DEBUG(get_logger(), "Cancel request was for another goal");
 	}
 
 	// Check if goal is done
@@ -832,13 +1475,35 @@ bool ReactiveNav2DNode::MyReactiveInterface::getCurrentPoseAndSpeeds(
 	std::string& frame_id)
 {
 	using mrpt::system::CTimeLoggerEntry;
-	double curV, curW;
 
 	CTimeLoggerEntry tle(parent_.profiler_, "getCurrentPoseAndSpeeds");
 
-	// rclcpp::Duration timeout(0.1);
-	rclcpp::Duration timeout(std::chrono::milliseconds(100));
+	// 1st option: odometry + latest reference-to-odom transform, predicted
+	// up to "now":
+	const auto queryTime =
+		mrpt::ros2bridge::fromROS(parent_.get_clock()->now());
+	if (const auto p = parent_.poseProvider_.get(queryTime); p)
+	{
+		curPose = p->pose;
+		curVel = p->velocityGlobal;
+		curOdometry = p->odometry;
+		timestamp = p->timestamp;
+
+		// Age of the actual odometry reading, not of the prediction:
+		parent_.currentStep_.poseAge =
+			p->extrapolatedTime - parent_.time_since_step_start(timestamp);
+
+		RCLCPP_DEBUG(
+			parent_.get_logger(),
+			"[getCurrentPoseAndSpeeds] Predicted pose: %s vel: %s "
+			"(extrapolated %.03f s)",
+			curPose.asString().c_str(), p->velocityLocal.asString().c_str(),
+			p->extrapolatedTime);
+		return true;
+	}
 
+	// 2nd option: latest robot pose from /tf, without waiting for it.
+	// Speeds are unknown.
 	geometry_msgs::msg::TransformStamped tfGeom;
 	try
 	{
@@ -848,7 +1513,7 @@ bool ReactiveNav2DNode::MyReactiveInterface::getCurrentPoseAndSpeeds(
 
 		tfGeom = parent_.tfBuffer_->lookupTransform(
 			parent_.frameidReference_, parent_.frameidRobot_,
-			tf2::TimePointZero, tf2::durationFromSec(timeout.seconds()));
+			tf2::TimePointZero);
 	}
 	catch (const tf2::TransformException& ex)
 	{
@@ -856,6 +1521,12 @@ bool ReactiveNav2DNode::MyReactiveInterface::getCurrentPoseAndSpeeds(
 		return false;
 	}
 
+	RCLCPP_WARN_THROTTLE(
+		parent_.get_logger(), *parent_.get_clock(), 5000,
+		"[getCurrentPoseAndSpeeds] No recent odometry on '%s': using /tf "
+		"robot pose and zero velocity.",
+		parent_.subTopicOdometry_.c_str());
+
 	tf2::Transform txRobotPose;
 	tf2::fromMsg(tfGeom.transform, txRobotPose);
 
@@ -863,20 +1534,17 @@ bool ReactiveNav2DNode::MyReactiveInterface::getCurrentPoseAndSpeeds(
 		mrpt::ros2bridge::fromROS(txRobotPose);
 
 	timestamp = mrpt::ros2bridge::fromROS(tfGeom.header.stamp);
+	parent_.currentStep_.poseAge = -parent_.time_since_step_start(timestamp);
 
 	// Explicit 3d->2d to confirm we know we're losing information
 	curPose = mrpt::poses::CPose2D(curRobotPose).asTPose();
 	curOdometry = curPose;
+	curVel = mrpt::math::TTwist2D(0, 0, 0);
 
-	curV = curW = 0;
-	MRPT_TODO("Retrieve current speeds from /odom topic?");
 	RCLCPP_DEBUG(
 		parent_.get_logger(), "[getCurrentPoseAndSpeeds] Latest pose: %s",
 		curPose.asString().c_str());
 
-	// From local to global:
-	curVel = mrpt::math::TTwist2D(curV, .0, curW).rotated(curPose.phi);
-
 	return true;
 }
 
@@ -888,31 +1556,82 @@ bool ReactiveNav2DNode::MyReactiveInterface::changeSpeeds(
 		dynamic_cast<const CVehicleVelCmd_DiffDriven*>(&vel_cmd);
 	ASSERT_(vel_cmd_diff_driven);
 
-	const double v = vel_cmd_diff_driven->lin_vel;
-	const double w = vel_cmd_diff_driven->ang_vel;
+	const mrpt::math::TTwist2D cmd(
+		vel_cmd_diff_driven->lin_vel, 0, vel_cmd_diff_driven->ang_vel);
+
+	// Stale data gating:
+	const bool stale =
+		(cmd.vx != 0 || cmd.omega != 0) && input_data_is_stale();
+	if (stale) warn_stale_data("changeSpeeds");
+
+	publish_cmd_vel(parent_.staleDataGate_.new_command(cmd, stale));
+	return true;
+}
+
+bool ReactiveNav2DNode::MyReactiveInterface::changeSpeedsNOP()
+{
+	// Keeping the last command must not bypass the stale data gating:
+	const bool stale = input_data_is_stale();
+	const auto cmd = parent_.staleDataGate_.keep_command(stale);
+	if (!cmd) return true;
+
+	warn_stale_data("changeSpeedsNOP");
+	publish_cmd_vel(*cmd);
+	return true;
+}
+
+void ReactiveNav2DNode::MyReactiveInterface::warn_stale_data(
+	const char* caller)
+{
+	const auto& st = parent_.currentStep_;
+	RCLCPP_WARN_THROTTLE(
+		parent_.get_logger(), *parent_.get_clock(), 2000,
+		"%s: stale input data (obstacles age=%s%s, pose age=%s): scaling "
+		"velocity command by %.02f",
+		caller,
+		st.obstaclesAge ? std::to_string(*st.obstaclesAge).c_str() : "?",
+		st.obstaclesOutdated ? ", outdated" : "",
+		st.poseAge ? std::to_string(*st.poseAge).c_str() : "?",
+		parent_.staleDataGate_.params.speed_factor);
+}
+
+void ReactiveNav2DNode::MyReactiveInterface::publish_cmd_vel(
+	const mrpt::math::TTwist2D& vel)
+{
 	RCLCPP_DEBUG(
-		parent_.get_logger(), "changeSpeeds: v=%7.4f m/s  w=%8.3f deg/s", v,
-		w * 180.0f / M_PI);
+		parent_.get_logger(), "changeSpeeds: v=%7.4f m/s  w=%8.3f deg/s",
+		vel.vx, vel.omega * 180.0f / M_PI);
 	geometry_msgs::msg::Twist cmd;
-	cmd.linear.x = v;
-	cmd.angular.z = w;
+	cmd.linear.x = vel.vx;
+	cmd.angular.z = vel.omega;
 	parent_.pubCmdVel_->publish(cmd);
-	return true;
+
+	auto& st = parent_.currentStep_;
+	if (st.stepStart != INVALID_TIMESTAMP)
+		st.cmdPublishDelay = parent_.time_since_step_start(parent_.ros_now());
 }
 
-bool ReactiveNav2DNode::MyReactiveInterface::stop(bool isEmergency)
+bool ReactiveNav2DNode::MyReactiveInterface::input_data_is_stale()
 {
-	mrpt::kinematics::CVehicleVelCmd_DiffDriven vel_cmd;
-	vel_cmd.lin_vel = 0;
-	vel_cmd.ang_vel = 0;
-	return changeSpeeds(vel_cmd);
+	auto& st = parent_.currentStep_;
+	const bool noObstacles = !st.obstaclesAge && !parent_.pure_pursuit_mode_;
+	// Outdated obstacles are stale even without max_obstacles_age:
+	const bool staleObstacles = st.obstaclesOutdated ||
+		(parent_.maxObstaclesAge_ > 0 &&
+		 (noObstacles ||
+		  (st.obstaclesAge && *st.obstaclesAge > parent_.maxObstaclesAge_)));
+	const bool stalePose = parent_.maxPoseAge_ > 0 &&
+		(!st.poseAge || *st.poseAge > parent_.maxPoseAge_);
+
+	if (staleObstacles || stalePose) st.staleData = true;
+	return staleObstacles || stalePose;
 }
 
 bool ReactiveNav2DNode::MyReactiveInterface::senseObstacles(
 	mrpt::maps::CSimplePointsMap& obstacles,
 	mrpt::system::TTimeStamp& timestamp)
 {
-	timestamp = mrpt::Clock::now();
+	timestamp = parent_.ros_now();
 
 	if (parent_.pure_pursuit_mode_)
 	{
@@ -922,10 +1641,19 @@ bool ReactiveNav2DNode::MyReactiveInterface::senseObstacles(
 	}
 	else
 	{
-		std::lock_guard<std::mutex> csl(parent_.lastObstaclesMtx_);
-		obstacles = parent_.lastObstacles_;
-
-		MRPT_TODO("Check age of obstacles!");
+		// Grab a reference to the latest snapshot: it will not be modified
+		// while we use it, since new data always comes in a new object.
+		const auto snapshot = std::atomic_load(&parent_.lastObstacles_);
+		obstacles = snapshot->points;
+		parent_.currentStep_.obstaclesOutdated = snapshot->outdated;
+
+		// The age of obstacles is checked in changeSpeeds():
+		if (snapshot->timestamp != INVALID_TIMESTAMP)
+		{
+			timestamp = snapshot->timestamp;
+			parent_.currentStep_.obstaclesAge =
+				-parent_.time_since_step_start(timestamp);
+		}
 	}
 	return true;
 }
@@ -933,14 +1661,13 @@ bool ReactiveNav2DNode::MyReactiveInterface::senseObstacles(
 void ReactiveNav2DNode::MyReactiveInterface::sendNavigationStartEvent()
 {
 	parent_.publish_event_message("START");
+	parent_.signal_nav_event();
 }
 
 void ReactiveNav2DNode::MyReactiveInterface::sendNavigationEndEvent()
 {
 	parent_.publish_event_message("END");
-
-	auto lck = mrpt::lockHelper(parent_.currentNavEndedSuccessfullyMtx_);
-	parent_.currentNavEndedSuccessfully_ = true;
+	parent_.signal_nav_event(true);
 }
 
 void ReactiveNav2DNode::MyReactiveInterface::sendWaypointReachedEvent(
@@ -950,6 +1677,7 @@ void ReactiveNav2DNode::MyReactiveInterface::sendWaypointReachedEvent(
 	parent_.publish_event_message(
 		"WP_REACHED "s + std::to_string(waypoint_index) + " "s +
 		(reached_nSkipped ? "REACHED" : "SKIPPED"));
+	parent_.signal_nav_event();
 }
 
 void ReactiveNav2DNode::MyReactiveInterface::sendNewWaypointTargetEvent(
@@ -957,33 +1685,32 @@ void ReactiveNav2DNode::MyReactiveInterface::sendNewWaypointTargetEvent(
 {
 	using namespace std::string_literals;
 	parent_.publish_event_message("WP_NEW "s + std::to_string(waypoint_index));
+	parent_.signal_nav_event();
 }
 
 void ReactiveNav2DNode::MyReactiveInterface::sendNavigationEndDueToErrorEvent()
 {
 	parent_.publish_event_message("ERROR");
-
-	auto lck = mrpt::lockHelper(parent_.currentNavEndedSuccessfullyMtx_);
-	parent_.currentNavEndedSuccessfully_ = false;
+	parent_.signal_nav_event(false);
 }
 
 void ReactiveNav2DNode::MyReactiveInterface::sendWaySeemsBlockedEvent()
 {
 	parent_.publish_event_message("WAY_SEEMS_BLOCKED");
+	parent_.signal_nav_event();
 }
 
 void ReactiveNav2DNode::MyReactiveInterface::sendApparentCollisionEvent()
 {
 	parent_.publish_event_message("APPARENT_COLLISION");
+	parent_.signal_nav_event();
 }
 
 void ReactiveNav2DNode::MyReactiveInterface::
 	sendCannotGetCloserToBlockedTargetEvent()
 {
 	parent_.publish_event_message("CANNOT_GET_CLOSER");
-
-	auto lck = mrpt::lockHelper(parent_.currentNavEndedSuccessfullyMtx_);
-	parent_.currentNavEndedSuccessfully_ = false;
+	parent_.signal_nav_event(false);
 }
 
 int main(int argc, char** argv)
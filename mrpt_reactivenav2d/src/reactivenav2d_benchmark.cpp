@@ -0,0 +1,406 @@
+/* +------------------------------------------------------------------------+
+   |                             mrpt_navigation                            |
+   |                                                                        |
+   | Copyright (c) 2014-2024, Individual contributors, see commit authors   |
+   | See: https://github.com/mrpt-ros-pkg/mrpt_navigation                   |
+   | All rights reserved. Released under BSD 3-Clause license. See LICENSE  |
+   +------------------------------------------------------------------------+ */
+
+/* Offline closed-loop benchmark for the reactive navigator.
+ *
+ * Runs a batch of navigation scenarios (start pose, goal) with the same
+ * navigation engine than the ROS 2 node, driving an in-process kinematic
+ * robot in a world of point obstacles built from an occupancy grid map.
+ * Time is simulated, so it runs faster than real time.
+ *
+ * It reports the navigation step time percentiles, success rate,
+ * time-to-goal and minimum clearance to obstacles.
+ *
+ * Example:
+ *  reactivenav2d_benchmark \
+ *    -c mrpt_reactivenav2d/params/reactive2d_default.ini \
+ *    -m mrpt_tutorials/maps/demo_world2.yaml --random 50
+ */
+
+#include <mrpt/3rdparty/tclap/CmdLine.h>
+#include <mrpt/config/CConfigFile.h>
+#include <mrpt/core/Clock.h>
+#include <mrpt/core/exceptions.h>
+#include <mrpt/core/format.h>
+#include <mrpt/maps/COccupancyGridMap2D.h>
+#include <mrpt/maps/CSimplePointsMap.h>
+#include <mrpt/system/CTicTac.h>
+#include <mrpt_nav_common/benchmark_report.hpp>
+#include <mrpt_reactivenav2d/mrpt_reactivenav2d_core.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <vector>
+
+using namespace mrpt_reactivenav2d;
+using namespace mrpt_nav_common::benchmark;
+
+// CLI flags:
+static TCLAP::CmdLine cmd(
+	"reactivenav2d_benchmark", ' ', MRPT_getVersion().c_str());
+
+static TCLAP::ValueArg<std::string> arg_config(
+	"c", "config", "Reactive navigation config file (*.ini)", true, "",
+	"reactive2d.ini", cmd);
+
+static TCLAP::ValueArg<std::string> arg_map(
+	"m", "map",
+	"World map, as a ROS map_server YAML file. Its occupied cells become "
+	"the obstacles.",
+	true, "", "map.yaml", cmd);
+
+static TCLAP::ValueArg<std::string> arg_scenarios(
+	"s", "scenarios",
+	"Text file with one scenario per line: 'x0 y0 phi0_deg x_goal y_goal'. "
+	"If not given, random scenarios are generated (see --random).",
+	false, "", "scenarios.txt", cmd);
+
+static TCLAP::ValueArg<unsigned int> arg_random(
+	"", "random", "Number of random scenarios to generate (Default: 20)",
+	false, 20, "20", cmd);
+
+static TCLAP::ValueArg<unsigned int> arg_seed(
+	"", "seed", "Random scenarios generator seed (Default: 1)", false, 1,
+	"1", cmd);
+
+static TCLAP::ValueArg<double> arg_min_goal_distance(
+	"", "min-goal-distance",
+	"Minimum distance [m] between start and goal of random scenarios "
+	"(Default: 3.0)",
+	false, 3.0, "3.0", cmd);
+
+static TCLAP::ValueArg<double> arg_period(
+	"", "period", "Navigation period [s], in simulated time (Default: 0.10)",
+	false, 0.10, "0.10", cmd);
+
+static TCLAP::ValueArg<double> arg_timeout(
+	"", "timeout",
+	"Maximum simulated time [s] per scenario before declaring it failed "
+	"(Default: 120)",
+	false, 120.0, "120.0", cmd);
+
+static TCLAP::ValueArg<double> arg_target_allowed_distance(
+	"", "target-allowed-distance",
+	"Distance [m] to the goal to consider it reached (Default: 0.40)", false,
+	0.40, "0.40", cmd);
+
+static TCLAP::ValueArg<double> arg_sensor_range(
+	"", "sensor-range", "Obstacle sensor range [m] (Default: 6.0)", false,
+	6.0, "6.0", cmd);
+
+static TCLAP::ValueArg<std::string> arg_ptg_cache_dir(
+	"", "ptg-cache-dir", "Directory to save/load the PTG tables", false, "",
+	"/tmp/ptgs", cmd);
+
+static TCLAP::SwitchArg arg_parallel_ptgs(
+	"", "parallel-ptg-evaluation", "Evaluate the PTGs in parallel", cmd,
+	false);
+
+static TCLAP::ValueArg<std::string> arg_json(
+	"", "json", "Optional output file to save the results as JSON", false, "",
+	"results.json", cmd);
+
+static TCLAP::ValueArg<double> arg_max_p99(
+	"", "max-p99-ms",
+	"Maximum 99% percentile [ms] of the navigationStep() execution time. "
+	"If given, exit with code 2 when it is exceeded.",
+	false, 0.0, "0.0", cmd);
+
+static TCLAP::ValueArg<double> arg_min_success_rate(
+	"", "min-success-rate",
+	"Minimum ratio [0,1] of scenarios that must reach their goal. If given, "
+	"exit with code 2 when fewer do.",
+	false, 0.0, "0.0", cmd);
+
+static TCLAP::SwitchArg arg_verbose(
+	"v", "verbose", "Enable console output of the navigation engine", cmd,
+	false);
+
+namespace
+{
+struct Scenario
+{
+	mrpt::math::TPose2D start;
+	mrpt::math::TPoint2D goal;
+};
+
+struct ScenarioResult
+{
+	bool success = false;
+	double time = 0;  //!< [s] simulated time until the end of navigation
+	double minClearance = 0;  //!< [m] between the robot shape and obstacles
+	size_t apparentCollisions = 0;  //!< Events reported by the navigator
+};
+
+mrpt::maps::CSimplePointsMap obstacles_from_grid(
+	const mrpt::maps::COccupancyGridMap2D& grid)
+{
+	mrpt::maps::CSimplePointsMap pts;
+	for (unsigned int cy = 0; cy < grid.getSizeY(); cy++)
+		for (unsigned int cx = 0; cx < grid.getSizeX(); cx++)
+		{
+			// Grid cells store the probability of being free:
+			if (grid.getCell(cx, cy) >= 0.5f) continue;
+			pts.insertPoint(grid.idx2x(cx), grid.idx2y(cy), 0);
+		}
+	return pts;
+}
+
+std::vector<Scenario> load_scenarios(const std::string& file)
+{
+	std::ifstream f(file);
+	ASSERTMSG_(f.is_open(), "Cannot open scenarios file: " + file);
+
+	std::vector<Scenario> scenarios;
+	std::string line;
+	while (std::getline(f, line))
+	{
+		if (line.empty() || line[0] == '#') continue;
+		std::istringstream ss(line);
+		Scenario s;
+		double phiDeg = 0;
+		if (!(ss >> s.start.x >> s.start.y >> phiDeg >> s.goal.x >> s.goal.y))
+			THROW_EXCEPTION_FMT("Malformed scenario line: '%s'", line.c_str());
+		s.start.phi = mrpt::DEG2RAD(phiDeg);
+		scenarios.push_back(s);
+	}
+	return scenarios;
+}
+
+std::vector<Scenario> random_scenarios(
+	const mrpt::maps::COccupancyGridMap2D& grid, KinematicSimRobot& robot,
+	double minClearance, size_t count, unsigned int seed)
+{
+	std::mt19937 rng(seed);
+	std::uniform_real_distribution<double> rx(grid.getXMin(), grid.getXMax()),
+		ry(grid.getYMin(), grid.getYMax()), rphi(-M_PI, M_PI);
+
+	auto isFree = [&](double x, double y)
+	{
+		if (grid.getPos(x, y) <= 0.5f) return false;
+		robot.reset({x, y, 0});
+		return robot.nearest_obstacle_distance() > minClearance;
+	};
+	auto randomFreePoint = [&]()
+	{
+		for (int i = 0; i < 100000; i++)
+		{
+			const mrpt::math::TPoint2D p(rx(rng), ry(rng));
+			if (isFree(p.x, p.y)) return p;
+		}
+		THROW_EXCEPTION("Could not find free space in the map");
+	};
+
+	std::vector<Scenario> scenarios;
+	while (scenarios.size() < count)
+	{
+		Scenario s;
+		const auto p0 = randomFreePoint();
+		s.start = {p0.x, p0.y, rphi(rng)};
+		s.goal = randomFreePoint();
+		if ((s.goal - p0).norm() < arg_min_goal_distance.getValue()) continue;
+		scenarios.push_back(s);
+	}
+	return scenarios;
+}
+
+ScenarioResult run_scenario(
+	const Scenario& s, ReactiveNavEngine& nav, KinematicSimRobot& robot,
+	std::vector<double>& stepTimes)
+{
+	using mrpt::nav::CAbstractNavigator;
+
+	robot.reset(s.start);
+	mrpt::Clock::setSimulatedTime(robot.now());
+
+	mrpt::nav::CAbstractPTGBasedReactive::TNavigationParamsPTG navParams;
+	navParams.target.target_coords = {s.goal.x, s.goal.y, 0};
+	navParams.target.targetAllowedDistance =
+		arg_target_allowed_distance.getValue();
+	navParams.target.targetIsRelative = false;
+
+	nav.navigate(&navParams);
+
+	// All PTGs share the robot shape:
+	const auto& shape = *nav.getPTG(0);
+
+	ScenarioResult r;
+	r.minClearance = robot.nearest_obstacle_clearance(shape);
+
+	const double dt = arg_period.getValue();
+	while (robot.time() < arg_timeout.getValue())
+	{
+		mrpt::Clock::setSimulatedTime(robot.now());
+
+		mrpt::system::CTicTac tictac;
+		nav.navigationStep();
+		stepTimes.push_back(tictac.Tac());
+
+		robot.simulate(dt);
+
+		r.minClearance =
+			std::min(r.minClearance, robot.nearest_obstacle_clearance(shape));
+
+		if (robot.events().navigationEndedSuccessfully.has_value() ||
+			nav.getCurrentState() == CAbstractNavigator::NAV_ERROR)
+			break;
+	}
+	// Leave the navigator idle for the next scenario:
+	nav.cancel();
+
+	r.success = robot.events().navigationEndedSuccessfully.value_or(false);
+	r.time = robot.time();
+	r.apparentCollisions = robot.events().apparentCollisions;
+	return r;
+}
+
+}  // namespace
+
+int main(int argc, char** argv)
+{
+	try
+	{
+		if (!cmd.parse(argc, argv)) return 1;
+
+		ASSERT_GT_(arg_period.getValue(), 0.0);
+
+		// World:
+		mrpt::maps::COccupancyGridMap2D grid;
+		if (!grid.loadFromROSMapServerYAML(arg_map.getValue()))
+		{
+			std::cerr << "Error loading map: " << arg_map.getValue() << "\n";
+			return 1;
+		}
+
+		KinematicSimRobot robot;
+		robot.params.sensor_range = arg_sensor_range.getValue();
+
+		// The navigator measures data ages and delays with mrpt::Clock: make
+		// it follow the simulated time, see run_scenario().
+		mrpt::Clock::setSimulatedTime(robot.now());
+		mrpt::Clock::setActiveClock(mrpt::Clock::Source::Simulated);
+		robot.set_obstacles(obstacles_from_grid(grid));
+		std::cout << "World obstacles: " << robot.obstacles().size()
+				  << " points.\n";
+
+		// Navigator:
+		ReactiveNavEngine nav(robot, arg_verbose.isSet(), false /*log*/);
+		nav.loadConfigFile(mrpt::config::CConfigFile(arg_config.getValue()));
+		nav.setPTGCacheDirectory(arg_ptg_cache_dir.getValue());
+		nav.enableParallelPTGEvaluation(arg_parallel_ptgs.isSet());
+
+		std::cout << "Initializing navigation engine (PTGs)...\n";
+		nav.initialize();
+		ASSERT_GT_(nav.getPTG_count(), 0U);
+
+		double robotRadius = 0;
+		for (size_t i = 0; i < nav.getPTG_count(); i++)
+			robotRadius =
+				std::max(robotRadius, nav.getPTG(i)->getMaxRobotRadius());
+
+		// Scenarios:
+		const auto scenarios = arg_scenarios.isSet()
+			? load_scenarios(arg_scenarios.getValue())
+			: random_scenarios(
+				  grid, robot, robotRadius + 0.2, arg_random.getValue(),
+				  arg_seed.getValue());
+		ASSERT_(!scenarios.empty());
+
+		// Run them all:
+		std::vector<double> stepTimes;  // [s]
+		std::vector<ScenarioResult> results;
+		mrpt::system::CTicTac wallClock;
+
+		for (size_t i = 0; i < scenarios.size(); i++)
+		{
+			const auto& s = scenarios[i];
+			const auto r = run_scenario(s, nav, robot, stepTimes);
+			results.push_back(r);
+
+			std::cout << mrpt::format(
+				"[%3zu/%3zu] %s -> %s: %s time=%.02fs min_clearance=%.03fm\n",
+				i + 1, scenarios.size(), s.start.asString().c_str(),
+				s.goal.asString().c_str(), r.success ? "OK  " : "FAIL",
+				r.time, r.minClearance);
+		}
+		const double wallTime = wallClock.Tac();
+
+		// Report:
+		// -----------------------------------------------
+		size_t successes = 0, collisions = 0, apparentCollisions = 0;
+		double sumSimTime = 0;
+		double minClearance = std::numeric_limits<double>::max();
+		std::vector<double> timesToGoal;
+		for (const auto& r : results)
+		{
+			sumSimTime += r.time;
+			minClearance = std::min(minClearance, r.minClearance);
+			if (r.minClearance <= 0) collisions++;
+			apparentCollisions += r.apparentCollisions;
+			if (!r.success) continue;
+			successes++;
+			timesToGoal.push_back(r.time);
+		}
+
+		const double successRate =
+			static_cast<double>(successes) / results.size();
+		const Summary timeToGoal(timesToGoal), stepTime(stepTimes);
+
+		std::cout << mrpt::format(
+			"\nScenarios: %zu  Success rate: %.01f%%  Collisions: %zu "
+			"(apparent collision events: %zu)\n"
+			"Time to goal [s]: %s\n"
+			"Min clearance [m]: %.03f\n"
+			"Step time [ms]: %s\n"
+			"Simulated time: %.01fs in %.01fs wall clock (x%.01f)\n",
+			results.size(), 100.0 * successRate, collisions,
+			apparentCollisions, timeToGoal.asString(1.0, 2).c_str(),
+			minClearance, stepTime.asString(1e3).c_str(), sumSimTime,
+			wallTime, sumSimTime / wallTime);
+
+		if (arg_json.isSet())
+		{
+			JSONObject report;
+			report.add("config", arg_config.getValue())
+				.add("map", arg_map.getValue())
+				.add("scenarios", results.size())
+				.add("success_rate", successRate)
+				.add("collisions", collisions)
+				.add("time_to_goal_s", timeToGoal.asJSON())
+				.add("min_clearance_m", minClearance)
+				.add("step_time_ms", stepTime.asJSON(1e3))
+				.add("simulated_time_s", sumSimTime)
+				.add("wall_time_s", wallTime);
+
+			if (!report.saveToFile(arg_json.getValue()))
+			{
+				std::cerr << "Error writing to: " << arg_json.getValue()
+						  << "\n";
+				return 1;
+			}
+		}
+
+		RegressionGates gates;
+		gates.checkAtMost(
+			"p99 step time", 1e3 * stepTime.p99, arg_max_p99.getValue(), "ms");
+		gates.checkAtLeast(
+			"success rate", successRate, arg_min_success_rate.getValue());
+		return gates.exitCode();
+	}
+	catch (const std::exception& e)
+	{
+		std::cerr << "Exit due to exception:\n"
+				  << mrpt::exception_to_str(e) << std::endl;
+		return 1;
+	}
+}
@@ -0,0 +1,388 @@
+/* +------------------------------------------------------------------------+
+   |                             mrpt_navigation                            |
+   |                                                                        |
+   | Copyright (c) 2014-2024, Individual contributors, see commit authors   |
+   | See: https://github.com/mrpt-ros-pkg/mrpt_navigation                   |
+   | All rights reserved. Released under BSD 3-Clause license. See LICENSE  |
+   +------------------------------------------------------------------------+ */
+
+#include <gtest/gtest.h>
+#include <mrpt/config/CConfigFile.h>
+#include <mrpt/kinematics/CVehicleVelCmd_DiffDriven.h>
+#include <mrpt/system/datetime.h>
+#include <mrpt_reactivenav2d/mrpt_reactivenav2d_core.hpp>
+
+#include <cmath>
+#include <vector>
+
+using mrpt_reactivenav2d::RobotPoseProvider;
+
+TEST(RobotPoseProvider, NoDataYet)
+{
+	RobotPoseProvider pp;
+	EXPECT_FALSE(pp.get(mrpt::Clock::now()).has_value());
+
+	// Odometry alone is not enough:
+	const auto t0 = mrpt::Clock::now();
+	pp.add_odometry({1.0, 0.0, 0.0}, {0.0, 0.0, 0.0}, t0);
+	EXPECT_FALSE(pp.get(t0).has_value());
+}
+
+TEST(RobotPoseProvider, ExtrapolateAndTransform)
+{
+	RobotPoseProvider pp;
+	pp.params.max_odometry_age = 0.5;
+	pp.params.max_extrapolation_time = 0.2;
+
+	const auto t0 = mrpt::Clock::now();
+	pp.set_reference_to_odom({10.0, 0.0, M_PI / 2});
+	pp.add_odometry({1.0, 0.0, 0.0}, {1.0, 0.0, 0.0}, t0);
+
+	// No extrapolation:
+	{
+		const auto p = pp.get(t0);
+		ASSERT_TRUE(p.has_value());
+		EXPECT_NEAR(p->pose.x, 10.0, 1e-6);
+		EXPECT_NEAR(p->pose.y, 1.0, 1e-6);
+		EXPECT_NEAR(p->pose.phi, M_PI / 2, 1e-6);
+		EXPECT_NEAR(p->velocityGlobal.vx, 0.0, 1e-6);
+		EXPECT_NEAR(p->velocityGlobal.vy, 1.0, 1e-6);
+	}
+
+	// 0.1 s later, at 1 m/s:
+	{
+		const auto p = pp.get(mrpt::system::timestampAdd(t0, 0.1));
+		ASSERT_TRUE(p.has_value());
+		EXPECT_NEAR(p->odometry.x, 1.1, 1e-6);
+		EXPECT_NEAR(p->pose.y, 1.1, 1e-6);
+		EXPECT_NEAR(p->extrapolatedTime, 0.1, 1e-3);
+	}
+
+	// Extrapolation is saturated:
+	{
+		const auto p = pp.get(mrpt::system::timestampAdd(t0, 0.4));
+		ASSERT_TRUE(p.has_value());
+		EXPECT_NEAR(p->odometry.x, 1.2, 1e-6);
+	}
+
+	// Too old:
+	EXPECT_FALSE(pp.get(mrpt::system::timestampAdd(t0, 0.6)).has_value());
+}
+
+TEST(RobotPoseProvider, OdometryAtPastTimes)
+{
+	RobotPoseProvider pp;
+	pp.params.max_extrapolation_time = 0.2;
+
+	const auto t0 = mrpt::Clock::now();
+	const auto at = [t0](double dt)
+	{ return mrpt::system::timestampAdd(t0, dt); };
+	pp.add_odometry({0.0, 0.0, 0.0}, {1.0, 0.0, 0.0}, t0);
+	pp.add_odometry({0.1, 0.0, 0.0}, {1.0, 0.0, 0.0}, at(0.1));
+	pp.add_odometry({0.2, 0.0, M_PI / 2}, {1.0, 0.0, 0.0}, at(0.2));
+
+	// Interpolated:
+	auto p = pp.odometry_at(at(0.05));
+	ASSERT_TRUE(p.has_value());
+	EXPECT_NEAR(p->x, 0.05, 1e-6);
+	EXPECT_NEAR(p->phi, 0.0, 1e-6);
+
+	p = pp.odometry_at(at(0.15));
+	ASSERT_TRUE(p.has_value());
+	EXPECT_NEAR(p->x, 0.15, 1e-6);
+	EXPECT_NEAR(p->phi, M_PI / 4, 1e-6);
+
+	// Extrapolated after the last reading, heading +Y:
+	p = pp.odometry_at(at(0.3));
+	ASSERT_TRUE(p.has_value());
+	EXPECT_NEAR(p->x, 0.2, 1e-6);
+	EXPECT_NEAR(p->y, 0.1, 1e-6);
+
+	// Out of the readings and the extrapolation limit:
+	EXPECT_FALSE(pp.odometry_at(at(-0.1)).has_value());
+	EXPECT_FALSE(pp.odometry_at(at(0.5)).has_value());
+}
+
+TEST(LatencyHistogram, Percentiles)
+{
+	mrpt_reactivenav2d::LatencyHistogram h(1.0, 1000);
+	EXPECT_EQ(h.count(), 0U);
+	EXPECT_EQ(h.percentile(0.5), 0.0);
+
+	for (int i = 1; i <= 100; i++) h.add(i * 1e-3);  // 1..100 ms
+
+	EXPECT_EQ(h.count(), 100U);
+	EXPECT_NEAR(h.percentile(0.50), 50e-3, 1.5e-3);
+	EXPECT_NEAR(h.percentile(0.99), 99e-3, 1.5e-3);
+	EXPECT_NEAR(h.max(), 100e-3, 1e-9);
+	EXPECT_NEAR(h.mean(), 50.5e-3, 1e-9);
+
+	// Out of range values are saturated:
+	h.add(5.0);
+	EXPECT_NEAR(h.percentile(1.0), 5.0, 1e-9);
+
+	h.clear();
+	EXPECT_EQ(h.count(), 0U);
+}
+
+TEST(ObstacleDecimator, CropAndDecimate)
+{
+	using mrpt_reactivenav2d::ObstacleDecimator;
+
+	ObstacleDecimator d;
+	d.params.max_range = 5.0;
+	d.params.min_z = 0.0;
+	d.params.max_z = 1.0;
+
+	// A wall at x=2, with 1 cm spacing, plus out of range points:
+	auto feed = [&]()
+	{
+		d.reset();
+		for (int i = -100; i <= 100; i++) d.add_point(2.0f, i * 0.01f, 0.5f);
+		d.add_point(10.0f, 0.0f, 0.5f);	 // too far
+		d.add_point(1.0f, 0.0f, 2.0f);	// too high
+	};
+
+	mrpt::maps::CSimplePointsMap out;
+
+	feed();
+	d.get_result(out);
+	EXPECT_EQ(d.input_count(), 203U);
+	EXPECT_EQ(out.size(), 201U);
+
+	d.params.decimation = ObstacleDecimator::Decimation::Grid;
+	d.params.grid_resolution = 0.10;
+	feed();
+	d.get_result(out);
+	EXPECT_GE(out.size(), 20U);
+	EXPECT_LE(out.size(), 22U);
+
+	d.params.decimation = ObstacleDecimator::Decimation::Polar;
+	d.params.polar_resolution = mrpt::DEG2RAD(5.0);
+	feed();
+	d.get_result(out);
+	// The wall spans +-26.6 deg:
+	EXPECT_GE(out.size(), 10U);
+	EXPECT_LE(out.size(), 13U);
+
+	// The nearest point must be kept:
+	bool foundNearest = false;
+	for (size_t i = 0; i < out.size(); i++)
+	{
+		float x, y, z;
+		out.getPoint(i, x, y, z);
+		if (std::abs(y) < 1e-4f) foundNearest = true;
+	}
+	EXPECT_TRUE(foundNearest);
+}
+
+TEST(KinematicSimRobot, MoveAndSense)
+{
+	using mrpt_reactivenav2d::KinematicSimRobot;
+
+	mrpt::maps::CSimplePointsMap world;
+	world.insertPoint(3.0f, 0.0f, 0.0f);
+	world.insertPoint(20.0f, 0.0f, 0.0f);  // out of sensor range
+
+	KinematicSimRobot robot;
+	robot.params.sensor_range = 6.0;
+	robot.set_obstacles(world);
+	robot.reset({0.0, 0.0, M_PI / 2});
+
+	mrpt::maps::CSimplePointsMap obs;
+	mrpt::system::TTimeStamp stamp;
+	ASSERT_TRUE(robot.senseObstacles(obs, stamp));
+	ASSERT_EQ(obs.size(), 1U);
+	{
+		// Obstacles are given in the robot frame:
+		float x, y, z;
+		obs.getPoint(0, x, y, z);
+		EXPECT_NEAR(x, 0.0f, 1e-4f);
+		EXPECT_NEAR(y, -3.0f, 1e-4f);
+	}
+	EXPECT_NEAR(robot.nearest_obstacle_distance(), 3.0, 1e-4);
+
+	// 1 m/s forward, during 2 s of simulated time:
+	mrpt::kinematics::CVehicleVelCmd_DiffDriven cmd;
+	cmd.lin_vel = 1.0;
+	cmd.ang_vel = 0.0;
+	ASSERT_TRUE(robot.changeSpeeds(cmd));
+	robot.resetNavigationTimer();
+	for (int i = 0; i < 20; i++) robot.simulate(0.1);
+
+	EXPECT_NEAR(robot.pose().x, 0.0, 1e-3);
+	EXPECT_NEAR(robot.pose().y, 2.0, 1e-3);
+	EXPECT_NEAR(robot.getNavigationTime(), 2.0, 1e-6);
+
+	// Data is stamped with the simulated time:
+	mrpt::system::TTimeStamp stamp2;
+	ASSERT_TRUE(robot.senseObstacles(obs, stamp2));
+	EXPECT_NEAR(mrpt::system::timeDifference(stamp, stamp2), 2.0, 1e-3);
+
+	ASSERT_TRUE(robot.stop(false));
+	robot.simulate(1.0);
+	EXPECT_NEAR(robot.pose().y, 2.0, 1e-3);
+
+	robot.sendNavigationStartEvent();
+	EXPECT_FALSE(robot.events().navigationEndedSuccessfully.has_value());
+	robot.sendNavigationEndEvent();
+	EXPECT_TRUE(robot.events().navigationEndedSuccessfully.value_or(false));
+}
+
+TEST(StaleDataSpeedGate, NewAndKeptCommands)
+{
+	mrpt_reactivenav2d::StaleDataSpeedGate gate;
+	gate.params.speed_factor = 0.5;
+
+	// Fresh data: commands are sent as they are, and kept as they are:
+	auto c = gate.new_command({1.0, 0.0, 0.2}, false);
+	EXPECT_NEAR(c.vx, 1.0, 1e-9);
+	EXPECT_NEAR(c.omega, 0.2, 1e-9);
+	EXPECT_FALSE(gate.keep_command(false).has_value());
+
+	// Stale data while keeping the last command: it is scaled, not stopped.
+	auto k = gate.keep_command(true);
+	ASSERT_TRUE(k.has_value());
+	EXPECT_NEAR(k->vx, 0.5, 1e-9);
+	EXPECT_NEAR(k->omega, 0.1, 1e-9);
+
+	// ...and never compounded:
+	k = gate.keep_command(true);
+	ASSERT_TRUE(k.has_value());
+	EXPECT_NEAR(k->vx, 0.5, 1e-9);
+
+	// Stale data in a new command:
+	c = gate.new_command({0.8, 0.0, 0.0}, true);
+	EXPECT_NEAR(c.vx, 0.4, 1e-9);
+
+	// A zero factor stops the robot:
+	gate.params.speed_factor = 0;
+	k = gate.keep_command(true);
+	ASSERT_TRUE(k.has_value());
+	EXPECT_EQ(k->vx, 0.0);
+	EXPECT_EQ(k->omega, 0.0);
+}
+
+TEST(ObstacleMemory, RememberShiftAndDecay)
+{
+	mrpt_reactivenav2d::ObstacleMemory mem;
+	mem.params.decay_time = 2.0;
+	mem.params.resolution = 0.10;
+	mem.params.radius = 4.0;
+
+	// An obstacle 1 m ahead of the robot:
+	mrpt::maps::CSimplePointsMap scan;
+	scan.insertPoint(1.0f, 0.0f, 0.0f);
+	mem.update_and_merge(scan, {0.0, 0.0, 0.0}, 0.0);
+	EXPECT_EQ(scan.size(), 1U);
+	EXPECT_EQ(mem.last_merged_count(), 0U);
+
+	// The robot moves 2 m forward and does not see it anymore: it must be
+	// remembered 1 m behind the robot:
+	scan.clear();
+	mem.update_and_merge(scan, {2.0, 0.0, 0.0}, 1.0);
+	ASSERT_EQ(scan.size(), 1U);
+	EXPECT_EQ(mem.last_merged_count(), 1U);
+	float x, y, z;
+	scan.getPoint(0, x, y, z);
+	EXPECT_NEAR(x, -1.0f, 0.01f);
+	EXPECT_NEAR(y, 0.0f, 0.01f);
+
+	// ...until it decays:
+	scan.clear();
+	mem.update_and_merge(scan, {2.0, 0.0, 0.0}, 2.5);
+	EXPECT_EQ(scan.size(), 0U);
+}
+
+TEST(ObstacleMemory, ForgetObstaclesSeenThrough)
+{
+	mrpt_reactivenav2d::ObstacleMemory mem;
+	mem.params.decay_time = 10.0;
+
+	// Obstacles 1 m ahead and 1 m to the left:
+	mrpt::maps::CSimplePointsMap scan;
+	scan.insertPoint(1.0f, 0.0f, 0.0f);
+	scan.insertPoint(0.0f, 1.0f, 0.0f);
+	mem.update_and_merge(scan, {0.0, 0.0, 0.0}, 0.0);
+
+	// The one ahead moved away, to 3 m. Nothing is seen to the left:
+	scan.clear();
+	scan.insertPoint(3.0f, 0.0f, 0.0f);
+	mem.update_and_merge(scan, {0.0, 0.0, 0.0}, 1.0);
+
+	// Only the one to the left must be remembered:
+	ASSERT_EQ(scan.size(), 2U);
+	EXPECT_EQ(mem.last_merged_count(), 1U);
+	float x, y, z;
+	scan.getPoint(1, x, y, z);
+	EXPECT_NEAR(x, 0.0f, 0.01f);
+	EXPECT_NEAR(y, 1.0f, 0.01f);
+
+	// ...also later on:
+	scan.clear();
+	mem.update_and_merge(scan, {0.0, 0.0, 0.0}, 2.0);
+	EXPECT_EQ(scan.size(), 1U);
+}
+
+namespace
+{
+// Runs the navigator in closed loop with a simulated robot in a corridor,
+// and returns the robot poses after each step:
+std::vector<mrpt::math::TPose2D> run_corridor(bool parallelPTGs)
+{
+	using namespace mrpt_reactivenav2d;
+
+	mrpt::maps::CSimplePointsMap world;
+	for (int i = -20; i <= 100; i++)
+	{
+		world.insertPoint(i * 0.1f, -1.5f, 0.0f);
+		world.insertPoint(i * 0.1f, 1.5f, 0.0f);
+	}
+	world.insertPoint(4.0f, 0.2f, 0.0f);  // something to avoid
+
+	KinematicSimRobot robot;
+	robot.set_obstacles(world);
+	robot.reset({0.0, 0.0, 0.0});
+	mrpt::Clock::setSimulatedTime(robot.now());
+
+	ReactiveNavEngine nav(robot, false /*verbose*/, false /*log*/);
+	nav.loadConfigFile(mrpt::config::CConfigFile(
+		MRPT_REACTIVENAV2D_SOURCE_DIR "/params/reactive2d_default.ini"));
+	nav.enableParallelPTGEvaluation(parallelPTGs, 4);
+	nav.initialize();
+
+	mrpt::nav::CAbstractPTGBasedReactive::TNavigationParamsPTG navParams;
+	navParams.target.target_coords = {8.0, 0.0, 0};
+	navParams.target.targetAllowedDistance = 0.4;
+	navParams.target.targetIsRelative = false;
+	nav.navigate(&navParams);
+
+	std::vector<mrpt::math::TPose2D> poses;
+	for (int step = 0; step < 50; step++)
+	{
+		mrpt::Clock::setSimulatedTime(robot.now());
+		nav.navigationStep();
+		robot.simulate(0.1);
+		poses.push_back(robot.pose());
+	}
+	return poses;
+}
+}  // namespace
+
+TEST(ReactiveNavEngine, ParallelPTGsGiveSerialResults)
+{
+	mrpt::Clock::setActiveClock(mrpt::Clock::Source::Simulated);
+	const auto serial = run_corridor(false);
+	const auto parallel = run_corridor(true);
+	mrpt::Clock::setActiveClock(mrpt::Clock::Source::Realtime);
+
+	// The robot must have moved, the same way in both modes:
+	ASSERT_EQ(serial.size(), parallel.size());
+	EXPECT_GT(serial.back().x, 1.0);
+	for (size_t i = 0; i < serial.size(); i++)
+	{
+		EXPECT_NEAR(serial[i].x, parallel[i].x, 1e-6) << "step " << i;
+		EXPECT_NEAR(serial[i].y, parallel[i].y, 1e-6) << "step " << i;
+		EXPECT_NEAR(serial[i].phi, parallel[i].phi, 1e-6) << "step " << i;
+	}
+}
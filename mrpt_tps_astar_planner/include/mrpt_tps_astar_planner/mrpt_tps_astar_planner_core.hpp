@@ -0,0 +1,469 @@
+/* +------------------------------------------------------------------------+
+   |                             mrpt_navigation                            |
+   |                                                                        |
+   | Copyright (c) 2014-2024, Individual contributors, see commit authors   |
+   | See: https://github.com/mrpt-ros-pkg/mrpt_navigation                   |
+   | All rights reserved. Released under BSD 3-Clause license. See LICENSE  |
+   +------------------------------------------------------------------------+ */
+
+#pragma once
+
+#include <mpp/algos/CostEvaluatorCostMap.h>
+#include <mpp/data/TrajectoriesAndRobotShape.h>
+#include <mpp/interfaces/ObstacleSource.h>
+#include <mrpt/core/bits_math.h>
+#include <mrpt/maps/CPointsMap.h>
+#include <mrpt/maps/CSimplePointsMap.h>
+#include <mrpt/math/TBoundingBox.h>
+#include <mrpt/math/TPoint2D.h>
+#include <mrpt/math/TPose2D.h>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <future>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+/* The core C++ non-ROS parts of the TPS-A* planner node. */
+
+namespace mrpt_tps_astar_planner
+{
+/** Everything the planner needs from one obstacle source (a gridmap or a
+ * point cloud topic), built once per source data version.
+ * Immutable once built, so it can be shared by any number of plans.
+ */
+struct ObstacleSourceData
+{
+	std::string sourceName;
+	uint64_t version = 0;
+
+	/// Obstacle points, in the map frame. Its KD-tree is already built.
+	mrpt::maps::CPointsMap::Ptr points;
+
+	mpp::ObstacleSource::Ptr obstacleSource;
+
+	mrpt::math::TBoundingBoxf bbox;
+
+	/// Costmap, built around `costmapRobotPose` (see
+	/// mpp::CostEvaluatorCostMap::Parameters::maxRadiusFromRobot)
+	mpp::CostEvaluatorCostMap::Ptr costmap;
+	mrpt::math::TPose2D costmapRobotPose;
+
+	using Ptr = std::shared_ptr<const ObstacleSourceData>;
+};
+
+/** A versioned cache of the per-source planner inputs (obstacle sources,
+ * KD-trees and costmaps), so they are not rebuilt on each plan request but
+ * only when their source data changes, optionally in a background thread.
+ *
+ * All methods are multi-thread safe.
+ */
+class ObstacleSourceCache
+{
+   public:
+	ObstacleSourceCache() = default;
+
+	struct Parameters
+	{
+		Parameters() = default;
+
+		/** A cached costmap is reused while the planning start pose is
+		 * closer than this [m] to the pose it was built for. */
+		double costmap_reuse_distance = 1.0;
+
+		/// Build the data of updated sources in a background thread.
+		bool background_build = true;
+
+		/// If false, no costmaps are built, and ObstacleSourceData::costmap
+		/// is always empty.
+		bool build_costmaps = true;
+	};
+
+	Parameters params;
+
+	void set_costmap_parameters(const mpp::CostEvaluatorCostMap::Parameters& p);
+
+	/** Sets new obstacle points (in the map frame) for the given source,
+	 * replacing the former ones, if any. The data is built right away, in
+	 * the background if so configured. If `robotPoseHint` is given, the
+	 * costmap is also built for it.
+	 *
+	 * If `changedArea` is given, it must contain all the points that were
+	 * added or removed w.r.t. the former version; then, the former costmap
+	 * is kept if the change is too far away to modify any of its cells.
+	 *
+	 * \return The new version number of the source data.
+	 */
+	uint64_t update_source(
+		const std::string& sourceName,
+		const mrpt::maps::CPointsMap::Ptr& points,
+		const std::optional<mrpt::math::TPose2D>& robotPoseHint = std::nullopt,
+		const std::optional<mrpt::math::TBoundingBoxf>& changedArea =
+			std::nullopt);
+
+	/** Returns the data of all sources, sorted by name, with costmaps valid
+	 * for planning from `startPose`. Waits for pending background builds,
+	 * and (re)builds costmaps only if needed. */
+	std::vector<ObstacleSourceData::Ptr> get_all(
+		const mrpt::math::TPose2D& startPose);
+
+	/** Like get_all(), but without building any costmap, for callers that
+	 * only need the obstacle points: costmaps may be missing or built for
+	 * other poses. */
+	std::vector<ObstacleSourceData::Ptr> get_all_points();
+
+	/// Current version of each source.
+	std::map<std::string, uint64_t> versions() const;
+
+	struct Stats
+	{
+		size_t sourceBuilds = 0;  //!< Obstacle sources + KD-trees built
+		size_t costmapBuilds = 0;
+		size_t costmapHits = 0;	 //!< Costmaps reused by get_all()
+		size_t costmapsKept = 0;  //!< Kept by update_source(), see changedArea
+	};
+
+	Stats stats() const;
+
+   private:
+	mutable std::mutex mtx_;
+	mpp::CostEvaluatorCostMap::Parameters costmapParams_;
+
+	struct Entry
+	{
+		uint64_t version = 0;
+		std::shared_future<ObstacleSourceData::Ptr> data;
+		/// The most recent data already built (maybe of an older version)
+		ObstacleSourceData::Ptr latest;
+	};
+	std::map<std::string, Entry> entries_;
+	Stats stats_;
+
+	ObstacleSourceData::Ptr build(
+		const std::string& sourceName, uint64_t version,
+		const mrpt::maps::CPointsMap::Ptr& points,
+		const std::optional<mrpt::math::TPose2D>& robotPose,
+		const ObstacleSourceData::Ptr& previous,
+		const std::optional<mrpt::math::TBoundingBoxf>& changedArea);
+
+	/// Whether a change within `area` modifies the costmap in `d`.
+	bool costmap_affected_by(
+		const ObstacleSourceData& d, const mrpt::math::TBoundingBoxf& area);
+
+	void set_latest(const std::string& sourceName, ObstacleSourceData::Ptr d);
+
+	mpp::CostEvaluatorCostMap::Ptr build_costmap(
+		const mrpt::maps::CPointsMap& points,
+		const mrpt::math::TPose2D& robotPose);
+};
+
+/** Incremental conversion of occupancy grids, with the layout of
+ * `nav_msgs/OccupancyGrid` (row-major cells, values in [0,100] or -1 for
+ * unknown), into obstacle points at the center of occupied cells.
+ *
+ * The output is the same as converting the grid into a
+ * mrpt::maps::COccupancyGridMap2D and calling getAsPointCloud(), but when a
+ * grid with the same geometry as the former one arrives, only the cells
+ * whose occupancy changed are processed.
+ *
+ * Not multi-thread safe: use one object per grid source.
+ */
+class OccupancyGridObstacles
+{
+   public:
+	OccupancyGridObstacles() = default;
+
+	struct GridInfo
+	{
+		uint32_t width = 0, height = 0;
+		float resolution = 0;
+		float origin_x = 0, origin_y = 0;
+
+		bool operator==(const GridInfo& o) const
+		{
+			return width == o.width && height == o.height &&
+				resolution == o.resolution && origin_x == o.origin_x &&
+				origin_y == o.origin_y;
+		}
+	};
+
+	struct Result
+	{
+		/// false if the obstacles are the same as in the former grid.
+		bool changed = false;
+
+		/// The obstacle points. A new object if `changed`, the former one
+		/// otherwise. Never modified afterwards.
+		mrpt::maps::CSimplePointsMap::Ptr points;
+
+		/// Bounding box of the added or removed points, or nullopt if the
+		/// whole grid was converted from scratch.
+		std::optional<mrpt::math::TBoundingBoxf> changedArea;
+
+		size_t changedCells = 0;
+	};
+
+	/** Updates the obstacle points from a new grid. `cells` must have
+	 * `width*height` elements. */
+	Result update(const GridInfo& info, const std::vector<int8_t>& cells);
+
+	/// Cells with a value above this are obstacles.
+	static constexpr int8_t OCCUPIED_THRESHOLD = 50;
+
+   private:
+	GridInfo info_;
+	std::vector<int8_t> cells_;
+	mrpt::maps::CSimplePointsMap::Ptr points_;
+
+	/// Point index of each occupied cell, and cell of each point:
+	static constexpr uint32_t NO_POINT = static_cast<uint32_t>(-1);
+	std::vector<uint32_t> pointOfCell_;
+	std::vector<uint32_t> cellOfPoint_;
+
+	static bool is_occupied(int8_t v) { return v > OCCUPIED_THRESHOLD; }
+	mrpt::math::TPoint2Df cell_center(size_t idx) const;
+};
+
+/** The planning domain for a request: an ellipse with foci at the start and
+ * goal positions, holding the points whose distances to both foci add up to
+ * at most the start-goal distance plus twice the margin.
+ * The A* lattice is a box, so searches use bounding_box() as their domain,
+ * and obstacles must be cropped to that box too (see crop_points()).
+ */
+struct PlanningCorridor
+{
+	PlanningCorridor() = default;
+	PlanningCorridor(
+		const mrpt::math::TPoint2D& start, const mrpt::math::TPoint2D& goal,
+		double margin_)
+		: focus1(start), focus2(goal), margin(margin_)
+	{
+	}
+
+	mrpt::math::TPoint2D focus1, focus2;
+	double margin = 0;	//!< [m]
+
+	/// Whether `p` is within the corridor, widened by `extraMargin` [m].
+	bool contains(const mrpt::math::TPoint2D& p, double extraMargin = 0) const;
+
+	/// Axis-aligned bounding box of the corridor, widened by `extraMargin`.
+	mrpt::math::TBoundingBoxf bounding_box(double extraMargin = 0) const;
+};
+
+/** Returns the points of `in` within the XY box `bbox` widened by
+ * `extraMargin` [m], with their KD-tree already built. */
+mrpt::maps::CSimplePointsMap::Ptr crop_points(
+	const mrpt::maps::CPointsMap& in, const mrpt::math::TBoundingBoxf& bbox,
+	double extraMargin = 0);
+
+/** \name Checks of already planned paths against new obstacles
+ * Paths are sequences of poses in the map frame, assumed to be joined by
+ * straight segments.
+ * @{ */
+
+/** Index of the path pose closest (in translation) to `p`.
+ * The path must not be empty. */
+size_t closest_path_pose(
+	const std::vector<mrpt::math::TPose2D>& path,
+	const mrpt::math::TPose2D& p);
+
+/** Length of the path between the poses at indices `from` and `to`. */
+double path_length(
+	const std::vector<mrpt::math::TPose2D>& path, size_t from, size_t to);
+
+/** Returns the index of the first path pose whose segment to the next pose
+ * (or the last pose itself) passes closer than `clearance` to any obstacle
+ * point, or nullopt if the whole path is clear. The KD-trees of the
+ * obstacle maps are used, so they should be already built if this is
+ * called from several threads. */
+std::optional<size_t> first_path_collision(
+	const std::vector<mrpt::math::TPose2D>& path,
+	const std::vector<mrpt::maps::CPointsMap::Ptr>& obstacles,
+	double clearance);
+
+/** @} */
+
+/** A bounded cache of planned paths, keyed by the start and goal poses
+ * quantized to a grid, for robots that repeatedly drive the same routes.
+ *
+ * Each path is stored together with the versions of the obstacle sources it
+ * was planned with. A cached path is returned as it is while those versions
+ * do not change; otherwise, it is first checked for collisions against the
+ * obstacle sources that changed, and dropped if it is blocked.
+ * The least recently used paths are evicted beyond `max_entries`.
+ *
+ * All methods are multi-thread safe.
+ */
+class PlanCache
+{
+   public:
+	PlanCache() = default;
+
+	struct Parameters
+	{
+		Parameters() = default;
+
+		double position_resolution = 0.25;	//!< [m]
+		double heading_resolution = mrpt::DEG2RAD(10.0);  //!< [rad]
+
+		/// Maximum number of cached paths (0: disabled)
+		size_t max_entries = 0;
+	};
+
+	Parameters params;
+
+	/** Returns the cached path for the quantized start and goal, if any and
+	 * still collision-free (see first_path_collision()) against the current
+	 * `sources`, with the given robot `clearance` [m]. Its first pose is
+	 * replaced with `start`, and the segment from it to the next pose is
+	 * checked against all sources: if it is blocked, this is a miss, but
+	 * the path is kept for other start poses. Costmaps are not used. */
+	std::optional<std::vector<mrpt::math::TPose2D>> lookup(
+		const mrpt::math::TPose2D& start, const mrpt::math::TPose2D& goal,
+		const std::vector<ObstacleSourceData::Ptr>& sources, double clearance);
+
+	/** Stores a path planned from `start` to `goal` with the given obstacle
+	 * source versions, replacing the former one for the same key, if any. */
+	void insert(
+		const mrpt::math::TPose2D& start, const mrpt::math::TPose2D& goal,
+		const std::vector<mrpt::math::TPose2D>& path,
+		const std::map<std::string, uint64_t>& obstacleVersions);
+
+	void clear();
+
+	struct Stats
+	{
+		size_t lookups = 0;
+		size_t hits = 0;  //!< Including `revalidated`
+		size_t revalidated = 0;	 //!< Hits after a collision check
+		size_t invalidated = 0;	 //!< Paths dropped as blocked
+		size_t evictions = 0;
+		size_t entries = 0;
+		size_t memoryBytes = 0;	 //!< Approximate size of the cached paths
+		double totalLookupTime = 0;	 //!< [s]
+
+		double hit_rate() const
+		{
+			return lookups ? static_cast<double>(hits) / lookups : 0;
+		}
+	};
+
+	Stats stats() const;
+
+   private:
+	using Key = std::array<int64_t, 6>;
+
+	struct Entry
+	{
+		std::vector<mrpt::math::TPose2D> path;
+		std::map<std::string, uint64_t> obstacleVersions;
+		std::list<Key>::iterator lruIt;
+	};
+
+	mutable std::mutex mtx_;
+	std::map<Key, Entry> entries_;
+	std::list<Key> lru_;  //!< Most recently used first
+	Stats stats_;
+
+	Key make_key(
+		const mrpt::math::TPose2D& start,
+		const mrpt::math::TPose2D& goal) const;
+
+	static size_t entry_memory(const Entry& e);
+	void erase(std::map<Key, Entry>::iterator it);
+};
+
+/** One progress event of a planner search. */
+struct PlanProgressSample
+{
+	double elapsedTime = 0;	 //!< Since the search started [s]
+	size_t treeNodes = 0;
+	double bestCostFromStart = 0;
+	double bestCostToGoal = 0;
+	size_t bestPathNodes = 0;
+
+	/// Average tree growth [nodes/s] since the search started.
+	double expansions_per_second() const
+	{
+		return elapsedTime > 0 ? treeNodes / elapsedTime : 0;
+	}
+};
+
+/** A lock-free single-producer, single-consumer slot with the newest
+ * progress sample, so the planner thread can report its progress without
+ * locks nor I/O, and another thread publish it at its own rate. Each new
+ * sample replaces the former one, so the consumer never gets a stale one.
+ *
+ * It is a triple buffer: the producer writes into its back slot and swaps
+ * it with the middle one, which the consumer swaps with its front slot.
+ */
+class PlanProgressBuffer
+{
+   public:
+	PlanProgressBuffer() = default;
+
+	/// Producer side.
+	void push(const PlanProgressSample& s);
+
+	/// Consumer side: the newest sample, if any was pushed since the last
+	/// call.
+	std::optional<PlanProgressSample> pop_latest();
+
+   private:
+	std::array<PlanProgressSample, 3> slots_;
+	size_t back_ = 0;  //!< Producer slot
+	size_t front_ = 1;	//!< Consumer slot
+
+	/// Middle slot index, plus FRESH if it was not read yet
+	static constexpr size_t FRESH = 4;
+	std::atomic<size_t> middle_{2};
+};
+
+/** The progress samples of one search, with bounded memory: once
+ * `max_samples` are stored, every other one is discarded, and from then on
+ * only one of every two (four, ...) new samples is kept. The first and the
+ * last samples are always available.
+ */
+class PlanProgressHistory
+{
+   public:
+	explicit PlanProgressHistory(size_t maxSamples = 128);
+
+	void add(const PlanProgressSample& s);
+
+	/// Stored samples, oldest first, plus the last one added.
+	std::vector<PlanProgressSample> samples() const;
+
+	const std::optional<PlanProgressSample>& last() const { return last_; }
+
+   private:
+	size_t maxSamples_;
+	size_t stride_ = 1, count_ = 0;
+	std::vector<PlanProgressSample> samples_;
+	std::optional<PlanProgressSample> last_;
+};
+
+/** @name PTG tables on-disk cache
+ *  @{ */
+
+/** Like mpp::TrajectoriesAndRobotShape::initFromConfigFile(), but if
+ * `cacheDir` is not empty, the initialized PTGs are deserialized from a
+ * cache file in it, if there is one for the current
+ * mrpt_nav_common::ptg_cache_key() of the section, or saved into it after
+ * building them otherwise.
+ *
+ * \return true if the PTGs were loaded from the cache.
+ */
+bool init_ptgs_with_cache(
+	mpp::TrajectoriesAndRobotShape& out, const std::string& ptgIniFile,
+	const std::string& section, const std::string& cacheDir);
+
+/** @} */
+
+}  // namespace mrpt_tps_astar_planner
@@ -67,14 +67,50 @@ def generate_launch_description():
         'final_waypoint_ignore_heading', default_value='false',
         description='ignore_heading field of final waypoint of the interpolated path')
 
+    plan_queue_policy = DeclareLaunchArgument(
+        'plan_queue_policy', default_value='latest_goal_wins',
+        description='How plan requests are queued: "latest_goal_wins" (new requests preempt former ones) or "fifo"')
+
+    anytime_publish_period = DeclareLaunchArgument(
+        'anytime_publish_period', default_value='0.0',
+        description='Anytime mode: minimum period [s] between publications of improved partial paths while planning. 0 disables it.')
+
+    anytime_refinement_time_budget = DeclareLaunchArgument(
+        'anytime_refinement_time_budget', default_value='0.0',
+        description='Time [s] to improve, with finer searches, the path found for a goal topic request after publishing it. 0 disables it.')
+
+    planning_time_budget = DeclareLaunchArgument(
+        'planning_time_budget', default_value='0.0',
+        description='Default maximum planning time [s]. 0 means using maximumComputationTime from the planner parameters file.')
+
+    replan_reuse_previous_path = DeclareLaunchArgument(
+        'replan_reuse_previous_path', default_value='false',
+        description='For new requests to the same goal, reuse the last path and only replan its stretches blocked by new obstacles')
+
+    planning_corridor_margin = DeclareLaunchArgument(
+        'planning_corridor_margin', default_value='0.0',
+        description='Margin [m] of the ellipse around start and goal that limits each search. 0 disables it.')
+
+    plan_cache_max_entries = DeclareLaunchArgument(
+        'plan_cache_max_entries', default_value='0',
+        description='Maximum number of paths to cache for repeated start/goal pairs. 0 disables the cache.')
+
     planner_parameters_arg = DeclareLaunchArgument(
         'planner_parameters', default_value=os.path.join(myDir, 'configs', 'params', 'planner-params.yaml'),
         description='Path to planner-params.yaml configuration file')
 
+    parallel_planner_parameters_arg = DeclareLaunchArgument(
+        'parallel_planner_parameters', default_value='',
+        description='Path(s) (comma-separated) to planner parameter files for additional planners to run in parallel, e.g. ' + os.path.join(myDir, 'configs', 'params', 'planner-params-coarse.yaml'))
+
     ptg_ini_arg = DeclareLaunchArgument(
         'ptg_ini', default_value=os.path.join(myDir, 'configs', 'ini', 'ptgs_jackal.ini'),
         description='Path to PTG .ini configuration file defining the families of trajectories to use')
 
+    ptg_cache_dir_arg = DeclareLaunchArgument(
+        'ptg_cache_dir', default_value='',
+        description='Directory to save/load the initialized PTGs, for faster startup. Empty disables it.')
+
     global_costmap_parameters_arg = DeclareLaunchArgument(
         'global_costmap_parameters', default_value=os.path.join(myDir, 'configs', 'params', 'costmap-obstacles.yaml'),
         description='Path to global_costmap_parameters.yaml configuration file')
@@ -106,13 +142,23 @@ def generate_launch_description():
             {'final_waypoint_allow_skip' : LaunchConfiguration('final_waypoint_allow_skip')},
             {'mid_waypoints_ignore_heading' : LaunchConfiguration('mid_waypoints_ignore_heading')},
             {'final_waypoint_ignore_heading' : LaunchConfiguration('final_waypoint_ignore_heading')},
+            {'plan_queue_policy': LaunchConfiguration('plan_queue_policy')},
+            {'anytime_publish_period': LaunchConfiguration('anytime_publish_period')},
+            {'anytime_refinement_time_budget': LaunchConfiguration('anytime_refinement_time_budget')},
+            {'planning_time_budget': LaunchConfiguration('planning_time_budget')},
+            {'replan_reuse_previous_path': LaunchConfiguration('replan_reuse_previous_path')},
+            {'planning_corridor_margin': LaunchConfiguration('planning_corridor_margin')},
+            {'plan_cache_max_entries': LaunchConfiguration('plan_cache_max_entries')},
             # Param files:
             {'planner_parameters': LaunchConfiguration('planner_parameters')},
+            {'parallel_planner_parameters': LaunchConfiguration(
+                'parallel_planner_parameters')},
             {'global_costmap_parameters': LaunchConfiguration(
                 'global_costmap_parameters')},
             {'prefer_waypoints_parameters': LaunchConfiguration(
                 'prefer_waypoints_parameters')},
             {'ptg_ini': LaunchConfiguration('ptg_ini')},
+            {'ptg_cache_dir': LaunchConfiguration('ptg_cache_dir')},
         ]
     )
 
@@ -132,8 +178,17 @@ def generate_launch_description():
         final_waypoint_allow_skip,     
         mid_waypoints_ignore_heading,     
         final_waypoint_ignore_heading,
+        plan_queue_policy,
+        anytime_publish_period,
+        anytime_refinement_time_budget,
+        planning_time_budget,
+        replan_reuse_previous_path,
+        planning_corridor_margin,
+        plan_cache_max_entries,
         planner_parameters_arg,
+        parallel_planner_parameters_arg,
         ptg_ini_arg,
+        ptg_cache_dir_arg,
         global_costmap_parameters_arg,
         prefer_waypoints_parameters_arg,
         tps_astar_nav_node
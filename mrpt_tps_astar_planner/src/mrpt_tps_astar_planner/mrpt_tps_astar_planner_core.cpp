@@ -0,0 +1,769 @@
+/* +------------------------------------------------------------------------+
+   |                             mrpt_navigation                            |
+   |                                                                        |
+   | Copyright (c) 2014-2024, Individual contributors, see commit authors   |
+   | See: https://github.com/mrpt-ros-pkg/mrpt_navigation                   |
+   | All rights reserved. Released under BSD 3-Clause license. See LICENSE  |
+   +------------------------------------------------------------------------+ */
+
+#include <mrpt/config/CConfigFile.h>
+#include <mrpt/config/CConfigFileMemory.h>
+#include <mrpt/core/bits_math.h>
+#include <mrpt/core/Clock.h>
+#include <mrpt/core/format.h>
+#include <mrpt/core/lock_helper.h>
+#include <mrpt/io/CFileInputStream.h>
+#include <mrpt/io/CFileOutputStream.h>
+#include <mrpt/io/vector_loadsave.h>
+#include <mrpt/math/wrap2pi.h>
+#include <mrpt/serialization/CArchive.h>
+#include <mrpt/system/datetime.h>
+#include <mrpt/system/filesystem.h>
+#include <mrpt_nav_common/ptg_cache_key.hpp>
+#include <mrpt_tps_astar_planner/mrpt_tps_astar_planner_core.hpp>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <limits>
+
+using namespace mrpt_tps_astar_planner;
+
+namespace
+{
+const uint32_t PTG_CACHE_MAGIC = 0x50544743;  // "PTGC"
+
+std::string ptg_cache_file(const std::string& cacheDir, const std::string& key)
+{
+	return cacheDir + "/tps_astar_ptgs_" + key + ".bin";
+}
+
+/// Loads the PTGs from a cache file. Throws on any error.
+std::vector<mrpt::nav::CParameterizedTrajectoryGenerator::Ptr> load_ptgs(
+	const std::string& file, const std::string& key)
+{
+	mrpt::io::CFileInputStream f;
+	ASSERTMSG_(f.open(file), "Cannot open file: " + file);
+	auto arch = mrpt::serialization::archiveFrom(f);
+
+	uint32_t magic = 0, n = 0;
+	std::string fileKey;
+	arch >> magic >> fileKey >> n;
+	ASSERT_EQUAL_(magic, PTG_CACHE_MAGIC);
+	ASSERT_EQUAL_(fileKey, key);
+
+	std::vector<mrpt::nav::CParameterizedTrajectoryGenerator::Ptr> ptgs;
+	for (uint32_t i = 0; i < n; i++)
+	{
+		auto ptg = std::dynamic_pointer_cast<
+			mrpt::nav::CParameterizedTrajectoryGenerator>(arch.ReadObject());
+		ASSERT_(ptg);
+		// Just in case the PTG class does not serialize its tables:
+		if (!ptg->isInitialized()) ptg->initialize();
+		ptgs.push_back(ptg);
+	}
+	return ptgs;
+}
+
+/// Saves the PTGs into a cache file, atomically. \return false on errors.
+bool save_ptgs(
+	const std::vector<mrpt::nav::CParameterizedTrajectoryGenerator::Ptr>& ptgs,
+	const std::string& file, const std::string& key)
+{
+	// Write to a temporary file first, so concurrent readers never see a
+	// partial file:
+	const std::string tmpFile = file + mrpt::format(".%i.tmp", ::getpid());
+	{
+		mrpt::io::CFileOutputStream f;
+		if (!f.open(tmpFile)) return false;
+		auto arch = mrpt::serialization::archiveFrom(f);
+		arch << PTG_CACHE_MAGIC << key << static_cast<uint32_t>(ptgs.size());
+		for (const auto& ptg : ptgs) arch << *ptg;
+	}
+	return std::rename(tmpFile.c_str(), file.c_str()) == 0;
+}
+}  // namespace
+
+void ObstacleSourceCache::set_costmap_parameters(
+	const mpp::CostEvaluatorCostMap::Parameters& p)
+{
+	auto lck = mrpt::lockHelper(mtx_);
+	costmapParams_ = p;
+}
+
+uint64_t ObstacleSourceCache::update_source(
+	const std::string& sourceName, const mrpt::maps::CPointsMap::Ptr& points,
+	const std::optional<mrpt::math::TPose2D>& robotPoseHint,
+	const std::optional<mrpt::math::TBoundingBoxf>& changedArea)
+{
+	ASSERT_(points);
+
+	// The former build, if still running, is waited for by the destructor of
+	// the last reference to its future, and it takes mtx_: destroy it after
+	// releasing the lock (declaration order matters here).
+	std::shared_future<ObstacleSourceData::Ptr> formerData;
+
+	auto lck = mrpt::lockHelper(mtx_);
+	auto& e = entries_[sourceName];
+	const uint64_t version = ++e.version;
+
+	// changedArea is relative to the immediately former version only:
+	ObstacleSourceData::Ptr previous;
+	if (changedArea && e.latest && e.latest->version + 1 == version)
+		previous = e.latest;
+
+	const auto launchPolicy = params.background_build
+		? std::launch::async
+		: std::launch::deferred;
+
+	formerData = std::move(e.data);
+	e.data = std::async(
+				 launchPolicy,
+				 [this, sourceName, version, points, robotPoseHint, previous,
+				  changedArea]()
+				 {
+					 return build(
+						 sourceName, version, points, robotPoseHint, previous,
+						 changedArea);
+				 })
+				 .share();
+
+	return version;
+}
+
+ObstacleSourceData::Ptr ObstacleSourceCache::build(
+	const std::string& sourceName, uint64_t version,
+	const mrpt::maps::CPointsMap::Ptr& points,
+	const std::optional<mrpt::math::TPose2D>& robotPose,
+	const ObstacleSourceData::Ptr& previous,
+	const std::optional<mrpt::math::TBoundingBoxf>& changedArea)
+{
+	auto d = std::make_shared<ObstacleSourceData>();
+	d->sourceName = sourceName;
+	d->version = version;
+	d->points = points;
+	d->bbox = points->boundingBox();
+
+	// Build the KD-tree now, instead of lazily during the first plan, which
+	// would be also unsafe if several threads use it at once:
+	if (!points->empty())
+	{
+		float x, y, dist2;
+		points->kdTreeClosestPoint2D(0.0f, 0.0f, x, y, dist2);
+	}
+	d->obstacleSource = mpp::ObstacleSource::FromStaticPointcloud(points);
+
+	if (previous && previous->costmap && changedArea &&
+		!costmap_affected_by(*previous, *changedArea))
+	{
+		d->costmap = previous->costmap;
+		d->costmapRobotPose = previous->costmapRobotPose;
+
+		auto lck = mrpt::lockHelper(mtx_);
+		stats_.costmapsKept++;
+	}
+	else if (robotPose && params.build_costmaps)
+	{
+		d->costmap = build_costmap(*points, *robotPose);
+		d->costmapRobotPose = *robotPose;
+	}
+
+	auto lck = mrpt::lockHelper(mtx_);
+	stats_.sourceBuilds++;
+	lck.unlock();
+
+	set_latest(sourceName, d);
+
+	return d;
+}
+
+bool ObstacleSourceCache::costmap_affected_by(
+	const ObstacleSourceData& d, const mrpt::math::TBoundingBoxf& area)
+{
+	auto lck = mrpt::lockHelper(mtx_);
+	const double maxDist = costmapParams_.maxRadiusFromRobot +
+		costmapParams_.preferredClearanceDistance;
+	lck.unlock();
+
+	// Distance from the costmap center to the closest point of the area:
+	const auto& p = d.costmapRobotPose;
+	const double dx =
+		std::max({area.min.x - p.x, 0.0, p.x - area.max.x});
+	const double dy =
+		std::max({area.min.y - p.y, 0.0, p.y - area.max.y});
+
+	return dx * dx + dy * dy < maxDist * maxDist;
+}
+
+void ObstacleSourceCache::set_latest(
+	const std::string& sourceName, ObstacleSourceData::Ptr d)
+{
+	auto lck = mrpt::lockHelper(mtx_);
+	auto& latest = entries_[sourceName].latest;
+	if (!latest || latest->version <= d->version) latest = std::move(d);
+}
+
+mpp::CostEvaluatorCostMap::Ptr ObstacleSourceCache::build_costmap(
+	const mrpt::maps::CPointsMap& points, const mrpt::math::TPose2D& robotPose)
+{
+	auto lck = mrpt::lockHelper(mtx_);
+	const auto p = costmapParams_;
+	stats_.costmapBuilds++;
+	lck.unlock();
+
+	return mpp::CostEvaluatorCostMap::FromStaticPointObstacles(
+		points, p, robotPose);
+}
+
+std::vector<ObstacleSourceData::Ptr> ObstacleSourceCache::get_all(
+	const mrpt::math::TPose2D& startPose)
+{
+	// Take the futures, then wait for them without holding the lock:
+	std::vector<std::pair<std::string, Entry>> entries;
+	{
+		auto lck = mrpt::lockHelper(mtx_);
+		entries.assign(entries_.begin(), entries_.end());
+	}
+
+	std::vector<ObstacleSourceData::Ptr> out;
+	out.reserve(entries.size());
+
+	for (auto& [name, e] : entries)
+	{
+		ObstacleSourceData::Ptr d = e.data.get();
+
+		if (!params.build_costmaps)
+		{
+			out.push_back(d);
+			continue;
+		}
+
+		const bool costmapOk = d->costmap &&
+			(d->costmapRobotPose.translation() - startPose.translation())
+					.norm() <= params.costmap_reuse_distance;
+
+		if (costmapOk)
+		{
+			auto lck = mrpt::lockHelper(mtx_);
+			stats_.costmapHits++;
+		}
+		else
+		{
+			// Rebuild the costmap only, and keep it for the next plans:
+			auto nd = std::make_shared<ObstacleSourceData>(*d);
+			nd->costmap = build_costmap(*d->points, startPose);
+			nd->costmapRobotPose = startPose;
+			d = nd;
+
+			std::promise<ObstacleSourceData::Ptr> p;
+			p.set_value(d);
+
+			auto lck = mrpt::lockHelper(mtx_);
+			// Only if the source was not updated in the meantime:
+			if (auto it = entries_.find(name);
+				it != entries_.end() && it->second.version == d->version)
+			{
+				it->second.data = p.get_future().share();
+				it->second.latest = d;
+			}
+		}
+		out.push_back(d);
+	}
+	return out;
+}
+
+std::vector<ObstacleSourceData::Ptr> ObstacleSourceCache::get_all_points()
+{
+	std::vector<std::shared_future<ObstacleSourceData::Ptr>> futures;
+	{
+		auto lck = mrpt::lockHelper(mtx_);
+		for (const auto& [name, e] : entries_) futures.push_back(e.data);
+	}
+
+	std::vector<ObstacleSourceData::Ptr> out;
+	out.reserve(futures.size());
+	for (const auto& f : futures) out.push_back(f.get());
+	return out;
+}
+
+std::map<std::string, uint64_t> ObstacleSourceCache::versions() const
+{
+	auto lck = mrpt::lockHelper(mtx_);
+	std::map<std::string, uint64_t> ret;
+	for (const auto& [name, e] : entries_) ret[name] = e.version;
+	return ret;
+}
+
+ObstacleSourceCache::Stats ObstacleSourceCache::stats() const
+{
+	auto lck = mrpt::lockHelper(mtx_);
+	return stats_;
+}
+
+mrpt::math::TPoint2Df OccupancyGridObstacles::cell_center(size_t idx) const
+{
+	const size_t cx = idx % info_.width, cy = idx / info_.width;
+	return {
+		info_.origin_x + (cx + 0.5f) * info_.resolution,
+		info_.origin_y + (cy + 0.5f) * info_.resolution};
+}
+
+OccupancyGridObstacles::Result OccupancyGridObstacles::update(
+	const GridInfo& info, const std::vector<int8_t>& cells)
+{
+	ASSERT_EQUAL_(cells.size(), size_t(info.width) * info.height);
+
+	Result r;
+
+	if (!points_ || !(info == info_))
+	{
+		// New geometry: convert from scratch.
+		info_ = info;
+		cells_ = cells;
+		pointOfCell_.assign(cells.size(), NO_POINT);
+		cellOfPoint_.clear();
+
+		auto pts = mrpt::maps::CSimplePointsMap::Create();
+		for (size_t i = 0; i < cells.size(); i++)
+		{
+			if (!is_occupied(cells[i])) continue;
+			const auto pt = cell_center(i);
+			pointOfCell_[i] = cellOfPoint_.size();
+			cellOfPoint_.push_back(i);
+			pts->insertPoint(pt.x, pt.y, 0);
+		}
+		points_ = pts;
+
+		r.changed = true;
+		r.points = points_;
+		r.changedCells = cells.size();
+		return r;
+	}
+
+	// Same geometry: only process cells that switched between free and
+	// occupied. Copy-on-write, since the former points may be in use:
+	mrpt::maps::CSimplePointsMap::Ptr pts;
+	auto bbox = mrpt::math::TBoundingBoxf::PlusMinusInfinity();
+
+	for (size_t i = 0; i < cells.size(); i++)
+	{
+		if (cells[i] == cells_[i]) continue;
+		const bool wasOcc = is_occupied(cells_[i]);
+		cells_[i] = cells[i];
+		if (wasOcc == is_occupied(cells[i])) continue;
+
+		if (!pts) pts = mrpt::maps::CSimplePointsMap::Create(*points_);
+
+		const auto pt = cell_center(i);
+		bbox.updateWithPoint({pt.x, pt.y, 0.0f});
+		r.changedCells++;
+
+		if (!wasOcc)
+		{
+			pointOfCell_[i] = cellOfPoint_.size();
+			cellOfPoint_.push_back(i);
+			pts->insertPoint(pt.x, pt.y, 0);
+			continue;
+		}
+
+		// Remove: move the last point into the slot of the removed one.
+		const uint32_t idx = pointOfCell_[i];
+		const uint32_t lastIdx = cellOfPoint_.size() - 1;
+		if (idx != lastIdx)
+		{
+			float x, y, z;
+			pts->getPoint(lastIdx, x, y, z);
+			pts->setPoint(idx, x, y, z);
+			cellOfPoint_[idx] = cellOfPoint_[lastIdx];
+			pointOfCell_[cellOfPoint_[idx]] = idx;
+		}
+		cellOfPoint_.pop_back();
+		pts->resize(lastIdx);
+		pointOfCell_[i] = NO_POINT;
+	}
+
+	if (pts)
+	{
+		points_ = pts;
+		r.changed = true;
+		// Grow by half a cell, so the box contains the whole changed cells:
+		const float h = 0.5f * info_.resolution;
+		bbox.min.x -= h;
+		bbox.min.y -= h;
+		bbox.max.x += h;
+		bbox.max.y += h;
+		r.changedArea = bbox;
+	}
+	r.points = points_;
+	return r;
+}
+
+bool PlanningCorridor::contains(
+	const mrpt::math::TPoint2D& p, double extraMargin) const
+{
+	const double d = (focus2 - focus1).norm();
+	return (p - focus1).norm() + (p - focus2).norm() <=
+		d + 2 * (margin + extraMargin);
+}
+
+mrpt::math::TBoundingBoxf PlanningCorridor::bounding_box(
+	double extraMargin) const
+{
+	const auto delta = focus2 - focus1;
+	const double d = delta.norm();
+	const double a = 0.5 * d + margin + extraMargin;  // semi-major axis
+	const double b = std::sqrt(std::max(0.0, a * a - 0.25 * d * d));
+	const double th = std::atan2(delta.y, delta.x);
+	const double c = std::cos(th), s = std::sin(th);
+
+	const double hx = std::sqrt(a * a * c * c + b * b * s * s);
+	const double hy = std::sqrt(a * a * s * s + b * b * c * c);
+	const auto center = (focus1 + focus2) * 0.5;
+
+	return mrpt::math::TBoundingBoxf(
+		{static_cast<float>(center.x - hx), static_cast<float>(center.y - hy),
+		 0.0f},
+		{static_cast<float>(center.x + hx), static_cast<float>(center.y + hy),
+		 0.0f});
+}
+
+mrpt::maps::CSimplePointsMap::Ptr mrpt_tps_astar_planner::crop_points(
+	const mrpt::maps::CPointsMap& in, const mrpt::math::TBoundingBoxf& bbox,
+	double extraMargin)
+{
+	auto out = mrpt::maps::CSimplePointsMap::Create();
+
+	const float m = static_cast<float>(extraMargin);
+	const auto& xs = in.getPointsBufferRef_x();
+	const auto& ys = in.getPointsBufferRef_y();
+	const auto& zs = in.getPointsBufferRef_z();
+	for (size_t i = 0; i < xs.size(); i++)
+	{
+		if (xs[i] < bbox.min.x - m || xs[i] > bbox.max.x + m ||
+			ys[i] < bbox.min.y - m || ys[i] > bbox.max.y + m)
+			continue;
+		out->insertPoint(xs[i], ys[i], zs[i]);
+	}
+
+	// Build the KD-tree now (see ObstacleSourceCache::build()):
+	if (!out->empty())
+	{
+		float x, y, dist2;
+		out->kdTreeClosestPoint2D(0.0f, 0.0f, x, y, dist2);
+	}
+	return out;
+}
+
+size_t mrpt_tps_astar_planner::closest_path_pose(
+	const std::vector<mrpt::math::TPose2D>& path,
+	const mrpt::math::TPose2D& p)
+{
+	ASSERT_(!path.empty());
+
+	size_t best = 0;
+	double bestDist2 = std::numeric_limits<double>::max();
+	for (size_t i = 0; i < path.size(); i++)
+	{
+		const double d2 = (path[i].translation() - p.translation()).sqrNorm();
+		if (d2 < bestDist2)
+		{
+			bestDist2 = d2;
+			best = i;
+		}
+	}
+	return best;
+}
+
+double mrpt_tps_astar_planner::path_length(
+	const std::vector<mrpt::math::TPose2D>& path, size_t from, size_t to)
+{
+	double len = 0;
+	for (size_t i = from; i < to && i + 1 < path.size(); i++)
+		len += (path[i + 1].translation() - path[i].translation()).norm();
+	return len;
+}
+
+std::optional<size_t> mrpt_tps_astar_planner::first_path_collision(
+	const std::vector<mrpt::math::TPose2D>& path,
+	const std::vector<mrpt::maps::CPointsMap::Ptr>& obstacles,
+	double clearance)
+{
+	ASSERT_GT_(clearance, 0);
+
+	const float clearance2 = mrpt::square(clearance);
+	const double step = 0.5 * clearance;
+
+	auto collides = [&](const mrpt::math::TPoint2D& pt)
+	{
+		for (const auto& obs : obstacles)
+		{
+			if (!obs || obs->empty()) continue;
+			if (obs->kdTreeClosestPoint2DsqrError(pt.x, pt.y) < clearance2)
+				return true;
+		}
+		return false;
+	};
+
+	for (size_t i = 0; i < path.size(); i++)
+	{
+		const auto p0 = path[i].translation();
+		if (i + 1 == path.size())
+		{
+			if (collides(p0)) return i;
+			break;
+		}
+
+		// Sample the segment to the next pose:
+		const auto delta = path[i + 1].translation() - p0;
+		const size_t nSteps = 1 + static_cast<size_t>(delta.norm() / step);
+		for (size_t k = 0; k < nSteps; k++)
+			if (collides(p0 + delta * (static_cast<double>(k) / nSteps)))
+				return i;
+	}
+	return std::nullopt;
+}
+
+PlanCache::Key PlanCache::make_key(
+	const mrpt::math::TPose2D& start, const mrpt::math::TPose2D& goal) const
+{
+	ASSERT_GT_(params.position_resolution, 0);
+	ASSERT_GT_(params.heading_resolution, 0);
+
+	const auto nHeadings =
+		static_cast<int64_t>(std::ceil(2 * M_PI / params.heading_resolution));
+	const double res = params.position_resolution;
+	auto q = [res](double x)
+	{ return static_cast<int64_t>(std::round(x / res)); };
+	auto qPhi = [&](double phi)
+	{
+		return static_cast<int64_t>(std::round(
+				   mrpt::math::wrapTo2Pi(phi) / params.heading_resolution)) %
+			nHeadings;
+	};
+
+	return {q(start.x), q(start.y), qPhi(start.phi),
+			q(goal.x),	q(goal.y),	qPhi(goal.phi)};
+}
+
+size_t PlanCache::entry_memory(const Entry& e)
+{
+	size_t n = sizeof(Entry) + sizeof(Key) * 2 +
+		e.path.capacity() * sizeof(mrpt::math::TPose2D);
+	for (const auto& [name, version] : e.obstacleVersions)
+		n += name.capacity() + sizeof(version) + sizeof(name);
+	return n;
+}
+
+void PlanCache::erase(std::map<Key, Entry>::iterator it)
+{
+	stats_.memoryBytes -= entry_memory(it->second);
+	lru_.erase(it->second.lruIt);
+	entries_.erase(it);
+}
+
+std::optional<std::vector<mrpt::math::TPose2D>> PlanCache::lookup(
+	const mrpt::math::TPose2D& start, const mrpt::math::TPose2D& goal,
+	const std::vector<ObstacleSourceData::Ptr>& sources, double clearance)
+{
+	const auto tStart = mrpt::Clock::now();
+	auto lck = mrpt::lockHelper(mtx_);
+
+	if (params.max_entries == 0) return {};
+
+	stats_.lookups++;
+	std::optional<std::vector<mrpt::math::TPose2D>> ret;
+
+	if (auto it = entries_.find(make_key(start, goal)); it != entries_.end())
+	{
+		auto& e = it->second;
+
+		// Only obstacle sources that changed since the path was planned (or
+		// last checked) can block it:
+		std::vector<mrpt::maps::CPointsMap::Ptr> changedObstacles,
+			allObstacles;
+		std::map<std::string, uint64_t> versions;
+		for (const auto& d : sources)
+		{
+			allObstacles.push_back(d->points);
+			versions[d->sourceName] = d->version;
+			const auto itV = e.obstacleVersions.find(d->sourceName);
+			if (itV == e.obstacleVersions.end() || itV->second != d->version)
+				changedObstacles.push_back(d->points);
+		}
+
+		// The path was planned from another start pose in the same cell, so
+		// the segment from the actual one was never checked:
+		std::vector<mrpt::math::TPose2D> firstSegment = {start};
+		if (e.path.size() > 1) firstSegment.push_back(e.path[1]);
+
+		if (!changedObstacles.empty() &&
+			first_path_collision(e.path, changedObstacles, clearance))
+		{
+			stats_.invalidated++;
+			erase(it);
+		}
+		else if (first_path_collision(firstSegment, allObstacles, clearance))
+		{
+			// A miss for this start pose only
+		}
+		else
+		{
+			stats_.hits++;
+			if (!changedObstacles.empty()) stats_.revalidated++;
+
+			stats_.memoryBytes -= entry_memory(e);
+			e.obstacleVersions = std::move(versions);
+			stats_.memoryBytes += entry_memory(e);
+
+			lru_.splice(lru_.begin(), lru_, e.lruIt);
+			ret = e.path;
+			ret->front() = start;
+		}
+	}
+
+	stats_.totalLookupTime +=
+		mrpt::system::timeDifference(tStart, mrpt::Clock::now());
+	return ret;
+}
+
+void PlanCache::insert(
+	const mrpt::math::TPose2D& start, const mrpt::math::TPose2D& goal,
+	const std::vector<mrpt::math::TPose2D>& path,
+	const std::map<std::string, uint64_t>& obstacleVersions)
+{
+	auto lck = mrpt::lockHelper(mtx_);
+
+	if (params.max_entries == 0) return;
+
+	const auto key = make_key(start, goal);
+	if (auto it = entries_.find(key); it != entries_.end()) erase(it);
+
+	while (entries_.size() >= params.max_entries)
+	{
+		erase(entries_.find(lru_.back()));
+		stats_.evictions++;
+	}
+
+	lru_.push_front(key);
+	auto& e = entries_[key];
+	e.path = path;
+	e.obstacleVersions = obstacleVersions;
+	e.lruIt = lru_.begin();
+	stats_.memoryBytes += entry_memory(e);
+}
+
+void PlanCache::clear()
+{
+	auto lck = mrpt::lockHelper(mtx_);
+	entries_.clear();
+	lru_.clear();
+	stats_.memoryBytes = 0;
+}
+
+PlanCache::Stats PlanCache::stats() const
+{
+	auto lck = mrpt::lockHelper(mtx_);
+	Stats s = stats_;
+	s.entries = entries_.size();
+	return s;
+}
+
+void PlanProgressBuffer::push(const PlanProgressSample& s)
+{
+	slots_[back_] = s;
+	back_ = middle_.exchange(back_ | FRESH, std::memory_order_acq_rel) &
+		~FRESH;
+}
+
+std::optional<PlanProgressSample> PlanProgressBuffer::pop_latest()
+{
+	// Only the producer may change the middle slot meanwhile, and it always
+	// leaves a fresh one:
+	if (!(middle_.load(std::memory_order_relaxed) & FRESH))
+		return std::nullopt;
+
+	front_ = middle_.exchange(front_, std::memory_order_acq_rel) & ~FRESH;
+	return slots_[front_];
+}
+
+PlanProgressHistory::PlanProgressHistory(size_t maxSamples)
+	: maxSamples_(maxSamples)
+{
+	ASSERT_GE_(maxSamples_, 2U);
+}
+
+void PlanProgressHistory::add(const PlanProgressSample& s)
+{
+	last_ = s;
+	if (count_++ % stride_ != 0) return;
+
+	if (samples_.size() >= maxSamples_)
+	{
+		// Keep samples 0, 2, 4...
+		for (size_t i = 1; 2 * i < samples_.size(); i++)
+			samples_[i] = samples_[2 * i];
+		samples_.resize((samples_.size() + 1) / 2);
+		stride_ *= 2;
+		// The stride now starts at the first discarded sample:
+		if ((count_ - 1) % stride_ != 0) return;
+	}
+	samples_.push_back(s);
+}
+
+std::vector<PlanProgressSample> PlanProgressHistory::samples() const
+{
+	auto ret = samples_;
+	if (last_ && count_ > 0 && (count_ - 1) % stride_ != 0)
+		ret.push_back(*last_);
+	return ret;
+}
+
+bool mrpt_tps_astar_planner::init_ptgs_with_cache(
+	mpp::TrajectoriesAndRobotShape& out, const std::string& ptgIniFile,
+	const std::string& section, const std::string& cacheDir)
+{
+	mrpt::config::CConfigFile cfg(ptgIniFile);
+	if (cacheDir.empty())
+	{
+		out.initFromConfigFile(cfg, section);
+		return false;
+	}
+
+	// Robot shape parameters are also in this section:
+	const std::string key = mrpt_nav_common::ptg_cache_key(cfg, section);
+	const std::string file = ptg_cache_file(cacheDir, key);
+
+	if (mrpt::system::fileExists(file))
+	{
+		try
+		{
+			auto ptgs = load_ptgs(file, key);
+
+			// Everything else (robot shape), without building the PTGs:
+			mrpt::config::CConfigFileMemory cfgNoPTGs;
+			cfgNoPTGs.setContent(mrpt::io::file_get_contents(ptgIniFile));
+			cfgNoPTGs.write(section, "PTG_COUNT", 0);
+			out.initFromConfigFile(cfgNoPTGs, section);
+
+			out.ptgs = std::move(ptgs);
+			return true;
+		}
+		catch (const std::exception& e)
+		{
+			std::cerr << "[init_ptgs_with_cache] Ignoring cache file '"
+					  << file << "': " << e.what() << std::endl;
+		}
+	}
+
+	out.initFromConfigFile(cfg, section);
+
+	if (!mrpt::system::directoryExists(cacheDir))
+		mrpt::system::createDirectory(cacheDir);
+	if (!save_ptgs(out.ptgs, file, key))
+		std::cerr << "[init_ptgs_with_cache] Error saving: " << file
+				  << std::endl;
+
+	return false;
+}
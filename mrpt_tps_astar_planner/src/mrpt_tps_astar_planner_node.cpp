@@ -25,6 +25,7 @@
 #include <mrpt/maps/CPointsMap.h>
 #include <mrpt/maps/CSimplePointsMap.h>
 #include <mrpt/math/TPose2D.h>
+#include <mrpt/math/wrap2pi.h>
 #include <mrpt/math/TTwist2D.h>
 #include <mrpt/obs/CObservationOdometry.h>
 #include <mrpt/poses/CPose3D.h>
@@ -36,30 +37,44 @@
 #include <mrpt/system/datetime.h>
 #include <mrpt/system/filesystem.h>
 #include <mrpt/system/string_utils.h>
+#include <mrpt_tps_astar_planner/mrpt_tps_astar_planner_core.hpp>
 #include <tf2/LinearMath/Matrix3x3.h>
 #include <tf2/LinearMath/Quaternion.h>
 #include <tf2_ros/buffer.h>
 #include <tf2_ros/transform_listener.h>
 
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
 #include <geometry_msgs/msg/pose_array.hpp>
 #include <geometry_msgs/msg/pose_stamped.hpp>
 #include <geometry_msgs/msg/pose_with_covariance_stamped.hpp>
 #include <geometry_msgs/msg/transform_stamped.hpp>
 #include <geometry_msgs/msg/twist.hpp>
+#include <future>
+#include <limits>
+#include <map>
 #include <memory>
 #include <mrpt_msgs/msg/waypoint.hpp>
 #include <mrpt_msgs/msg/waypoint_sequence.hpp>
+#include <mrpt_nav_interfaces/action/make_plan.hpp>
+#include <mrpt_nav_interfaces/msg/planner_metrics.hpp>
 #include <mrpt_nav_interfaces/srv/make_plan_from_to.hpp>
 #include <mrpt_nav_interfaces/srv/make_plan_to.hpp>
+#include <mrpt_nav_interfaces/srv/make_plans_from_to.hpp>
 #include <mutex>
 #include <nav_msgs/msg/occupancy_grid.hpp>
 #include <nav_msgs/msg/odometry.hpp>
+#include <numeric>
 #include <optional>
 #include <rclcpp/rclcpp.hpp>
+#include <rclcpp_action/rclcpp_action.hpp>
 #include <sensor_msgs/msg/point_cloud2.hpp>
 #include <std_msgs/msg/bool.hpp>
 #include <string>
 #include <tf2_geometry_msgs/tf2_geometry_msgs.hpp>
+#include <thread>
 
 // for debugging
 #include <mrpt/gui/CDisplayWindow3D.h>
@@ -69,6 +84,25 @@
 
 const char* NODE_NAME = "mrpt_tps_astar_planner_node";
 
+namespace
+{
+/// Thrown from the planner progress callbacks to abort a canceled search
+struct PlanCanceled : public std::runtime_error
+{
+	PlanCanceled() : std::runtime_error("Plan request canceled") {}
+};
+
+/// Thrown from the planner progress callbacks to stop the planners whose
+/// paths cannot be used, once one of higher priority found a path
+struct PlannerPreempted : public std::runtime_error
+{
+	PlannerPreempted()
+		: std::runtime_error("A higher priority planner found a path")
+	{
+	}
+};
+}  // namespace
+
 /**
  * The main ROS2 node class.
  */
@@ -76,7 +110,7 @@ class TPS_Astar_Planner_Node : public rclcpp::Node
 {
    public:
 	TPS_Astar_Planner_Node();
-	virtual ~TPS_Astar_Planner_Node() = default;
+	virtual ~TPS_Astar_Planner_Node();
 
    private:
 	/// CTimeLogger instance for profiling
@@ -92,8 +126,11 @@ class TPS_Astar_Planner_Node : public rclcpp::Node
 	struct InfoPerGridMapSource
 	{
 		rclcpp::Subscription<nav_msgs::msg::OccupancyGrid>::SharedPtr sub;
-		mrpt::maps::COccupancyGridMap2D::Ptr grid;
+		mrpt::maps::COccupancyGridMap2D::Ptr grid;	 //!< Only if gui_mrpt_
 		mrpt::maps::CSimplePointsMap::Ptr grid_obstacles;
+
+		/// Only used from the subscription callback (no need to lock)
+		mrpt_tps_astar_planner::OccupancyGridObstacles converter;
 	};
 	std::deque<InfoPerGridMapSource> gridmaps_;
 
@@ -102,13 +139,45 @@ class TPS_Astar_Planner_Node : public rclcpp::Node
 	{
 		rclcpp::Subscription<sensor_msgs::msg::PointCloud2>::SharedPtr sub;
 		mrpt::maps::CPointsMap::Ptr obstacle_points;
+		/// Stamp of the cloud in `obstacle_points`
+		std::optional<rclcpp::Time> obstacle_points_stamp;
+
+		/// Clouds waiting for their TF to become available, oldest first
+		/// (Protected by pendingCloudsMtx_)
+		struct PendingCloud
+		{
+			sensor_msgs::msg::PointCloud2::SharedPtr msg;
+			mrpt::Clock::time_point received;
+		};
+		std::deque<PendingCloud> pending;
 	};
 
 	std::deque<InfoPerPointMapSource> obstacle_points_;
 
+	/// Mutex for the `pending` queues of obstacle_points_
+	std::mutex pendingCloudsMtx_;
+
+	/// Retries the transform of clouds waiting for their TF
+	rclcpp::TimerBase::SharedPtr timerPendingClouds_;
+
+	/// Clouds waiting longer than this [s] for their TF are dropped
+	double obstacles_tf_timeout_ = 5.0;
+
+	/// Maximum number of clouds per topic waiting for their TF
+	int obstacles_tf_queue_size_ = 5;
+
 	/// Publisher for waypoint sequence
 	rclcpp::Publisher<mrpt_msgs::msg::WaypointSequence>::SharedPtr pub_wp_seq_;
 
+	/// Publisher for planner metrics: search progress, and final statistics
+	rclcpp::Publisher<mrpt_nav_interfaces::msg::PlannerMetrics>::SharedPtr
+		pub_planner_metrics_;
+
+	/// Newest search progress sample, from the planner thread to
+	/// timerPlannerMetrics_
+	mrpt_tps_astar_planner::PlanProgressBuffer progressBuffer_;
+	rclcpp::TimerBase::SharedPtr timerPlannerMetrics_;
+
 	// tf2 buffer and listener
 	std::shared_ptr<tf2_ros::Buffer> tf_buffer_;
 	std::shared_ptr<tf2_ros::TransformListener> tf_listener_;
@@ -139,9 +208,18 @@ class TPS_Astar_Planner_Node : public rclcpp::Node
 	/// waypoint sequence topic publisher name
 	std::string topic_wp_seq_pub_;
 
+	std::string topic_planner_metrics_pub_ = "planner_metrics";
+
+	/// Period [s] to publish the search progress while planning (0: only
+	/// the final metrics of each plan are published)
+	double planner_metrics_period_ = 0.5;
+
 	/// Parameter file for PTGs
 	std::string ptg_ini_file_ = "ptgs.ini";
 
+	/// Directory to save and load the initialized PTGs (empty: disabled)
+	std::string ptg_cache_dir_;
+
 	/// Parameters file for Costmap evaluator
 	std::string costmap_params_file_ = "global-costmap-params.yaml";
 
@@ -161,6 +239,67 @@ class TPS_Astar_Planner_Node : public rclcpp::Node
 	bool mid_waypoints_ignore_heading_ = false;
 	bool final_waypoint_ignore_heading_ = false;
 
+	/// Anytime mode: minimum period [s] between publications of improved
+	/// partial paths while planning for a goal topic request (0=disabled)
+	double anytime_publish_period_ = 0;
+
+	/// Time [s] to improve the path found for a goal topic request, with
+	/// searches at finer lattice resolutions, after publishing it (0=disabled)
+	double anytime_refinement_time_budget_ = 0;
+
+	/// Max number of those searches with finer lattice resolutions
+	int anytime_max_refinements_ = 2;
+
+	/// Default planning time budget [s] (0: use the planner parameters file)
+	double planning_time_budget_ = 0;
+
+	/// maximumComputationTime from the planner parameters file
+	double planner_max_computation_time_ = 0;
+
+	/// Replanning: for new requests to the same goal, reuse the last path,
+	/// and only replan the stretches blocked by obstacles that changed since
+	bool replan_reuse_previous_path_ = false;
+
+	/// Max distance [m] from the robot to the last path to reuse it
+	double replan_max_path_deviation_ = 1.0;
+
+	/// Path length [m] kept clear before and after a blocked path stretch
+	/// when replanning it
+	double replan_repair_margin_ = 1.5;
+
+	/// Time budget [s] for replanning each blocked path stretch
+	double replan_repair_time_budget_ = 2.0;
+
+	/// Robot radius, from the PTGs robot shape [m]
+	double robot_radius_ = 0;
+
+	/// Planning corridor: margin [m] of the ellipse around start and goal
+	/// that limits the planning domain (0=disabled, plan over all obstacles)
+	double planning_corridor_margin_ = 0;
+
+	/// Planning corridor: obstacles are kept up to this distance [m] plus
+	/// the robot radius outside of the corridor
+	double planning_corridor_obstacle_border_ = 1.0;
+
+	/// Planning corridor: times the margin is multiplied by if no path is
+	/// found, before the last attempt without corridor
+	int planning_corridor_max_widenings_ = 2;
+
+	/// Batch planning: a goal is reached by a search tree node closer than
+	/// these distance [m] and heading [rad] tolerances
+	double batch_goal_tolerance_xy_ = 0.25;
+	double batch_goal_tolerance_phi_ = mrpt::DEG2RAD(10.0);
+
+	/// The last successful plan, for replanning
+	struct ActivePlan
+	{
+		mrpt::math::TPose2D goal;
+		std::vector<mrpt::math::TPose2D> path;
+		/// Version of each obstacle source the path was checked against
+		std::map<std::string, uint64_t> obstacleVersions;
+	};
+	std::optional<ActivePlan> activePlan_;
+
 	/// Pointer to MRPT 3D display window
 	mrpt::gui::CDisplayWindow3D::Ptr win_3d_;
 
@@ -169,9 +308,35 @@ class TPS_Astar_Planner_Node : public rclcpp::Node
 
 	mpp::TrajectoriesAndRobotShape ptgs_;
 
+	/// Planner parameter files (multiple if separated by ',') for additional
+	/// planners to run in parallel with the main one. The first path found
+	/// by any of them is used, and the others are stopped.
+	std::string parallel_planner_parameters_;
+
+	/// Additional planners, each with its own PTGs, since these keep
+	/// internal state while planning
+	struct PlannerVariant
+	{
+		std::string params_file;
+		mpp::Planner::Ptr planner;
+		mpp::TrajectoriesAndRobotShape ptgs;
+		double max_computation_time = 0;
+	};
+	std::vector<PlannerVariant> planner_variants_;
+
 	/// Parameters for the cost evaluator
 	mpp::CostEvaluatorCostMap::Parameters costMapParams_;
 
+	/// Obstacle sources and costmaps, rebuilt only when their data changes
+	mrpt_tps_astar_planner::ObstacleSourceCache obstacleSourceCache_;
+
+	/// Paths for repeated start/goal pairs
+	mrpt_tps_astar_planner::PlanCache planCache_;
+
+	/// Start pose of the last plan, used to prebuild costmaps (Protected by
+	/// obstacles_cs_)
+	std::optional<mrpt::math::TPose2D> lastPlanStartPose_;
+
    private:
 	/**
 	 * @brief wait for transform between map frame and the robot frame
@@ -187,6 +352,17 @@ class TPS_Astar_Planner_Node : public rclcpp::Node
 		mrpt::poses::CPose3D& des, const std::string& target_frame,
 		const std::string& source_frame, const int timeout_milliseconds = 50);
 
+	/**
+	 * @brief Non-blocking lookup of the transform between two frames at a
+	 * given time (see wait_for_transform() for the arguments)
+	 *
+	 * @return false if it is not available (yet)
+	 */
+	[[nodiscard]] bool lookup_transform_at(
+		mrpt::poses::CPose3D& des, const std::string& target_frame,
+		const std::string& source_frame,
+		const builtin_interfaces::msg::Time& stamp);
+
 	/**
 	 * @brief Reads a parameter from the node's parameter server.
 	 *
@@ -239,48 +415,249 @@ class TPS_Astar_Planner_Node : public rclcpp::Node
 		InfoPerGridMapSource& e);
 
 	/**
-	 * @brief Mutex locked method to update local obstacle map
+	 * @brief Queues a new obstacles point cloud until its TF is available,
+	 * see process_pending_obstacles()
 	 * @param _pc PointCloud2 object
 	 */
 	void update_obstacles(
 		const sensor_msgs::msg::PointCloud2::SharedPtr& _pc,
 		InfoPerPointMapSource& e);
 
+	/**
+	 * @brief Transforms into the map frame the newest queued cloud whose TF
+	 * at its stamp is already available, and replaces the source obstacle
+	 * points with it. Older clouds are dropped. Never waits for TF.
+	 */
+	void process_pending_obstacles(InfoPerPointMapSource& e);
+
 	struct PlanResult
 	{
 		PlanResult() = default;
 
 		bool valid = false;
+
+		/// In anytime mode, true if the deadline was reached before finding
+		/// a path to the goal, and `wps` holds the best partial path
+		bool partial = false;
+
 		mpp::PlannerOutput plan_output;
 		mrpt_msgs::msg::WaypointSequence wps{};
+
+		/// Path poses in the map frame, excluding the goal
+		std::vector<mrpt::math::TPose2D> path;
+
+		/// Version of each obstacle source used for this plan
+		std::map<std::string, uint64_t> obstacleVersions;
+
+		/// Search progress and statistics
+		mrpt_nav_interfaces::msg::PlannerMetrics metrics;
+
+		/// The path in `wps` was already published while planning
+		bool published = false;
 	};
 
 	/**
 	 * @brief Method to perform the path plan
 	 * @param start robot initial pose
 	 * @param goal  robot goal pose
+	 * @param timeBudget maximum planning time [s] (0: use the node default)
+	 * @param publishProgress publish improved partial paths while planning
+	 * (only in anytime mode), and publish the path found right away to
+	 * refine it afterwards (see refine_path()). Only for goal topic requests.
 	 * @return the plan results
 	 */
 	PlanResult do_path_plan(
+		const mrpt::math::TPose2D& start, const mrpt::math::TPose2D& goal,
+		double timeBudget = 0, bool publishProgress = false);
+
+	/**
+	 * @brief Searches again with finer lattice resolutions, within
+	 * anytime_refinement_time_budget_, and replaces the path in `res` with
+	 * any cheaper one found, publishing it.
+	 */
+	void refine_path(PlanResult& res, const mrpt::math::TPose2D& goal);
+
+	struct BatchGoalResult
+	{
+		bool valid = false;
+		double cost = 0;
+		mrpt_msgs::msg::WaypointSequence wps{};
+
+		/// Path poses in the map frame, excluding the goal
+		std::vector<mrpt::math::TPose2D> path;
+	};
+
+	struct BatchPlanResult
+	{
+		/// One entry per goal, in the request order
+		std::vector<BatchGoalResult> goals;
+
+		/// Number of A* searches run
+		size_t searches = 0;
+	};
+
+	/**
+	 * @brief Plans from one start to several goals, sharing the search
+	 * trees: each search is run for the farthest goal not reached yet, and
+	 * its tree is reused for all the other goals it reaches.
+	 * @param timeBudget maximum planning time [s] for all goals (0: use the
+	 * node default, or the planner maximum time per goal)
+	 */
+	BatchPlanResult do_batch_plan(
+		const mrpt::math::TPose2D& start,
+		const std::vector<mrpt::math::TPose2D>& goals, double timeBudget = 0);
+
+	/// A path planning request, from the goal topic, services or action
+	struct PlanRequest
+	{
+		/// Planning start. nullopt: the robot pose when planning starts
+		std::optional<mrpt::math::TPose2D> start;
+		mrpt::math::TPose2D goal;
+		double timeBudget = 0;
+		bool publishProgress = false;
+
+		/// Called with the result, or with nullptr if the request was
+		/// canceled, preempted by a newer one, or failed
+		std::function<void(const PlanResult*)> onDone;
+
+		/// Batch requests: if not empty, plan to all these goals instead of
+		/// `goal`, and report to onBatchDone instead of onDone
+		std::vector<mrpt::math::TPose2D> batchGoals;
+		std::function<void(const BatchPlanResult*)> onBatchDone;
+
+		/// Optional: called with the planner progress
+		std::function<void(const mpp::ProgressCallbackData&)> onProgress;
+
+		/// Optional: polled while planning or queued, to cancel the request
+		std::function<bool()> isCanceled;
+
+		/// The interface the request came from (e.g. "goal topic"), for the
+		/// queue policy and the logs
+		std::string description;
+	};
+	using PlanRequestPtr = std::shared_ptr<PlanRequest>;
+
+	/// Queue policy: "latest_goal_wins" (new requests preempt pending and
+	/// in-progress ones from the same interface) or "fifo"
+	std::string plan_queue_policy_ = "latest_goal_wins";
+
+	/// Mutex for planQueue_ & currentPlanRequest_
+	std::mutex planQueueMtx_;
+	std::condition_variable planQueueCv_;
+	std::deque<PlanRequestPtr> planQueue_;
+	PlanRequestPtr currentPlanRequest_;
+	bool planWorkerExit_ = false;
+
+	/// Set to cancel the search for currentPlanRequest_
+	std::atomic_bool cancelCurrentPlan_{false};
+
+	/// Runs all path searches, off the executor threads
+	std::thread planWorker_;
+
+	void enqueue_plan_request(const PlanRequestPtr& req);
+
+	void plan_worker();
+
+	/// Answers a request that will not be planned (preempted, canceled while
+	/// queued, or node shutting down)
+	void drop_plan_request(const PlanRequestPtr& req, const char* reason);
+
+	/// Removes from the queue, and answers, the requests canceled by their
+	/// clients while waiting to be planned
+	void drop_canceled_plan_requests();
+
+	/**
+	 * @brief Called from the planner progress callbacks
+	 * @throw PlanCanceled if the request being planned was canceled
+	 */
+	void check_plan_canceled();
+
+	/**
+	 * @brief Runs the A* search (see do_path_plan() for the arguments)
+	 */
+	PlanResult search_path(
+		const mrpt::math::TPose2D& start, const mrpt::math::TPose2D& goal,
+		double timeBudget, bool publishProgress, double corridorMargin);
+
+	/**
+	 * @brief Returns the path for the same (quantized) start and goal from
+	 * the plan cache, if any and still valid for the current obstacles.
+	 */
+	std::optional<PlanResult> cached_plan(
+		const mrpt::math::TPose2D& start, const mrpt::math::TPose2D& goal);
+
+	/**
+	 * @brief Replanning: reuses the last plan if it was for the same goal
+	 * and the robot is still close to it, replanning only the stretches
+	 * blocked by obstacles that changed since then, and the segment from
+	 * the robot to the path if blocked by any obstacle. Paths are checked
+	 * as straight segments between their poses, which are sampled along the
+	 * PTG trajectories every 0.25 s of motion (see path_to_poses()), with
+	 * the largest robot radius: a conservative check, whose false
+	 * collisions just cause needless repairs.
+	 * Repairs are never refined (see refine_path()).
+	 * @return nullopt if a full search is needed instead
+	 */
+	std::optional<PlanResult> repair_active_plan(
 		const mrpt::math::TPose2D& start, const mrpt::math::TPose2D& goal);
 
+	/**
+	 * @brief Interpolated poses (map frame) along the path from the tree
+	 * root to a node
+	 */
+	std::vector<mrpt::math::TPose2D> path_to_poses(
+		const mpp::MotionPrimitivesTreeSE2& tree, mrpt::graphs::TNodeID node,
+		const mpp::PlannerInput& pi);
+
+	/**
+	 * @brief Builds the waypoints for a sequence of path poses
+	 * @param goal If given, the final waypoint (for complete paths)
+	 */
+	mrpt_msgs::msg::WaypointSequence poses_to_waypoints(
+		const std::vector<mrpt::math::TPose2D>& poses,
+		const std::optional<mrpt::math::TPose2D>& goal);
+
+	// Services reply once the request is planned (deferred responses):
 	void srv_make_plan_to(
-		const std::shared_ptr<mrpt_nav_interfaces::srv::MakePlanTo::Request>
-			req,
-		std::shared_ptr<mrpt_nav_interfaces::srv::MakePlanTo::Response> resp);
+		const std::shared_ptr<rmw_request_id_t>& header,
+		const std::shared_ptr<mrpt_nav_interfaces::srv::MakePlanTo::Request>&
+			req);
 
 	rclcpp::Service<mrpt_nav_interfaces::srv::MakePlanTo>::SharedPtr
 		srvMakePlanTo_;
 
 	void srv_make_plan_from_to(
-		const std::shared_ptr<mrpt_nav_interfaces::srv::MakePlanFromTo::Request>
-			req,
-		std::shared_ptr<mrpt_nav_interfaces::srv::MakePlanFromTo::Response>
-			resp);
+		const std::shared_ptr<rmw_request_id_t>& header,
+		const std::shared_ptr<
+			mrpt_nav_interfaces::srv::MakePlanFromTo::Request>& req);
 
 	rclcpp::Service<mrpt_nav_interfaces::srv::MakePlanFromTo>::SharedPtr
 		srvMakePlanFromTo_;
 
+	void srv_make_plans_from_to(
+		const std::shared_ptr<rmw_request_id_t>& header,
+		const std::shared_ptr<
+			mrpt_nav_interfaces::srv::MakePlansFromTo::Request>& req);
+
+	rclcpp::Service<mrpt_nav_interfaces::srv::MakePlansFromTo>::SharedPtr
+		srvMakePlansFromTo_;
+
+	// ACTION INTERFACE: MakePlan
+	using MakePlan = mrpt_nav_interfaces::action::MakePlan;
+	using HandleMakePlan = rclcpp_action::ServerGoalHandle<MakePlan>;
+
+	rclcpp_action::Server<MakePlan>::SharedPtr action_server_make_plan_;
+
+	rclcpp_action::GoalResponse handle_goal_make_plan(
+		const rclcpp_action::GoalUUID& uuid,
+		std::shared_ptr<const MakePlan::Goal> goal);
+
+	rclcpp_action::CancelResponse handle_cancel_make_plan(
+		const std::shared_ptr<HandleMakePlan> goal_handle);
+
+	void handle_accepted_make_plan(
+		const std::shared_ptr<HandleMakePlan> goal_handle);
+
 	/**
 	 * @brief Debug method to visualize the planning
 	 */
@@ -291,6 +668,25 @@ class TPS_Astar_Planner_Node : public rclcpp::Node
 	 * @param wps Waypoint sequence object
 	 */
 	void publish_waypoint_sequence(const mrpt_msgs::msg::WaypointSequence& wps);
+
+	/**
+	 * @brief Timer callback: publishes the latest search progress sample
+	 * from progressBuffer_, if any
+	 */
+	void publish_plan_progress();
+
+	/**
+	 * @brief Final metrics of a search, including its progress history and
+	 * the planner profiler statistics of this search alone, i.e. the
+	 * difference between the current profiler stats and `profilerBefore`,
+	 * the snapshot taken when the search started.
+	 */
+	mrpt_nav_interfaces::msg::PlannerMetrics plan_metrics(
+		const mpp::PlannerOutput& plan,
+		const mrpt_tps_astar_planner::PlanProgressHistory& history,
+		const std::map<std::string, mrpt::system::CTimeLogger::TCallStats>&
+			profilerBefore,
+		double elapsedTime, const std::string& request);
 };
 
 TPS_Astar_Planner_Node::TPS_Astar_Planner_Node() : rclcpp::Node(NODE_NAME)
@@ -355,32 +751,93 @@ TPS_Astar_Planner_Node::TPS_Astar_Planner_Node() : rclcpp::Node(NODE_NAME)
 			{ this->callback_obstacles(msg, e); });
 	}
 
+	// Clouds whose TF was not available on arrival are retried periodically:
+	if (!obstacle_points_.empty())
+	{
+		timerPendingClouds_ = this->create_wall_timer(
+			std::chrono::milliseconds(50),
+			[this]()
+			{
+				for (auto& e : obstacle_points_) process_pending_obstacles(e);
+			});
+	}
+
 	// Init ROS publishers:
 	// -----------------------
 	pub_wp_seq_ = this->create_publisher<mrpt_msgs::msg::WaypointSequence>(
 		topic_wp_seq_pub_, qos);
 
+	pub_planner_metrics_ =
+		this->create_publisher<mrpt_nav_interfaces::msg::PlannerMetrics>(
+			topic_planner_metrics_pub_, qos);
+
+	if (planner_metrics_period_ > 0)
+	{
+		timerPlannerMetrics_ = this->create_wall_timer(
+			std::chrono::duration<double>(planner_metrics_period_),
+			[this]() { publish_plan_progress(); });
+	}
+
 	// Init services:
 	// --------------------------
 	srvMakePlanTo_ = this->create_service<mrpt_nav_interfaces::srv::MakePlanTo>(
 		this->get_fully_qualified_name() + "/make_plan_to"s,
 		[this](
-			const mrpt_nav_interfaces::srv::MakePlanTo::Request::SharedPtr req,
-			mrpt_nav_interfaces::srv::MakePlanTo::Response::SharedPtr res)
-		{ srv_make_plan_to(req, res); });
+			const std::shared_ptr<rmw_request_id_t> header,
+			const mrpt_nav_interfaces::srv::MakePlanTo::Request::SharedPtr req)
+		{ srv_make_plan_to(header, req); });
 
 	srvMakePlanFromTo_ = this->create_service<
 		mrpt_nav_interfaces::srv::MakePlanFromTo>(
 		this->get_fully_qualified_name() + "/make_plan_from_to"s,
 		[this](
+			const std::shared_ptr<rmw_request_id_t> header,
 			const mrpt_nav_interfaces::srv::MakePlanFromTo::Request::SharedPtr
-				req,
-			mrpt_nav_interfaces::srv::MakePlanFromTo::Response::SharedPtr res)
-		{ srv_make_plan_from_to(req, res); });
+				req) { srv_make_plan_from_to(header, req); });
+
+	srvMakePlansFromTo_ = this->create_service<
+		mrpt_nav_interfaces::srv::MakePlansFromTo>(
+		this->get_fully_qualified_name() + "/make_plans_from_to"s,
+		[this](
+			const std::shared_ptr<rmw_request_id_t> header,
+			const mrpt_nav_interfaces::srv::MakePlansFromTo::Request::SharedPtr
+				req) { srv_make_plans_from_to(header, req); });
+
+	// Actions
+	// --------------------------
+	using namespace std::placeholders;
+
+	action_server_make_plan_ = rclcpp_action::create_server<MakePlan>(
+		this, "make_plan",
+		std::bind(&TPS_Astar_Planner_Node::handle_goal_make_plan, this, _1, _2),
+		std::bind(&TPS_Astar_Planner_Node::handle_cancel_make_plan, this, _1),
+		std::bind(
+			&TPS_Astar_Planner_Node::handle_accepted_make_plan, this, _1));
 
 	// Init planner:
 	// --------------------------
 	initialize_planner();
+
+	planWorker_ = std::thread([this]() { plan_worker(); });
+}
+
+TPS_Astar_Planner_Node::~TPS_Astar_Planner_Node()
+{
+	{
+		auto lck = mrpt::lockHelper(planQueueMtx_);
+		planWorkerExit_ = true;
+		cancelCurrentPlan_ = true;
+	}
+	planQueueCv_.notify_all();
+	if (planWorker_.joinable()) planWorker_.join();
+
+	// Do not leave service clients or action goals waiting:
+	std::deque<PlanRequestPtr> pending;
+	{
+		auto lck = mrpt::lockHelper(planQueueMtx_);
+		pending.swap(planQueue_);
+	}
+	for (const auto& r : pending) drop_plan_request(r, "node shutting down");
 }
 
 bool TPS_Astar_Planner_Node::wait_for_transform(
@@ -413,6 +870,30 @@ bool TPS_Astar_Planner_Node::wait_for_transform(
 	}
 }
 
+bool TPS_Astar_Planner_Node::lookup_transform_at(
+	mrpt::poses::CPose3D& des, const std::string& target_frame,
+	const std::string& source_frame, const builtin_interfaces::msg::Time& stamp)
+{
+	const tf2::TimePoint t = tf2_ros::fromMsg(stamp);
+	if (!tf_buffer_->canTransform(source_frame, target_frame, t)) return false;
+
+	try
+	{
+		geometry_msgs::msg::TransformStamped src_to_trg_frame =
+			tf_buffer_->lookupTransform(source_frame, target_frame, t);
+
+		tf2::Transform tf;
+		tf2::fromMsg(src_to_trg_frame.transform, tf);
+		des = mrpt::ros2bridge::fromROS(tf);
+		return true;
+	}
+	catch (const tf2::TransformException& ex)
+	{
+		RCLCPP_DEBUG(get_logger(), "[lookup_transform_at] %s", ex.what());
+		return false;
+	}
+}
+
 void TPS_Astar_Planner_Node::read_parameters()
 {
 	this->declare_parameter<bool>("show_gui", false);
@@ -449,6 +930,20 @@ void TPS_Astar_Planner_Node::read_parameters()
 		this->get_logger(), "topic_obstacles_sub: %s",
 		topic_obstacle_points_sub_.c_str());
 
+	this->declare_parameter<double>(
+		"obstacles_tf_timeout", obstacles_tf_timeout_);
+	this->get_parameter("obstacles_tf_timeout", obstacles_tf_timeout_);
+	RCLCPP_INFO(
+		this->get_logger(), "obstacles_tf_timeout: %.03f",
+		obstacles_tf_timeout_);
+
+	this->declare_parameter<int>(
+		"obstacles_tf_queue_size", obstacles_tf_queue_size_);
+	this->get_parameter("obstacles_tf_queue_size", obstacles_tf_queue_size_);
+	RCLCPP_INFO(
+		this->get_logger(), "obstacles_tf_queue_size: %i",
+		obstacles_tf_queue_size_);
+
 	this->declare_parameter<std::string>(
 		"topic_static_maps", topic_static_maps_);
 	this->get_parameter("topic_static_maps", topic_static_maps_);
@@ -461,10 +956,31 @@ void TPS_Astar_Planner_Node::read_parameters()
 	RCLCPP_INFO(
 		this->get_logger(), "topic_wp_seq_pub%s", topic_wp_seq_pub_.c_str());
 
+	this->declare_parameter<std::string>(
+		"topic_planner_metrics_pub", topic_planner_metrics_pub_);
+	this->get_parameter(
+		"topic_planner_metrics_pub", topic_planner_metrics_pub_);
+	RCLCPP_INFO(
+		this->get_logger(), "topic_planner_metrics_pub: %s",
+		topic_planner_metrics_pub_.c_str());
+
+	this->declare_parameter<double>(
+		"planner_metrics_period", planner_metrics_period_);
+	this->get_parameter("planner_metrics_period", planner_metrics_period_);
+	RCLCPP_INFO(
+		this->get_logger(), "planner_metrics_period: %.03f",
+		planner_metrics_period_);
+
 	this->declare_parameter<std::string>("ptg_ini", ptg_ini_file_);
 	this->get_parameter("ptg_ini", ptg_ini_file_);
 	RCLCPP_INFO(this->get_logger(), "ptg_ini_file %s", ptg_ini_file_.c_str());
 
+	this->declare_parameter<std::string>("ptg_cache_dir", ptg_cache_dir_);
+	this->get_parameter("ptg_cache_dir", ptg_cache_dir_);
+	RCLCPP_INFO(
+		this->get_logger(), "ptg_cache_dir: %s",
+		ptg_cache_dir_.empty() ? "(none)" : ptg_cache_dir_.c_str());
+
 	ASSERT_FILE_EXISTS_(ptg_ini_file_);
 
 	this->declare_parameter<std::string>(
@@ -494,6 +1010,167 @@ void TPS_Astar_Planner_Node::read_parameters()
 
 	ASSERT_FILE_EXISTS_(planner_params_file_);
 
+	this->declare_parameter<std::string>(
+		"parallel_planner_parameters", parallel_planner_parameters_);
+	this->get_parameter(
+		"parallel_planner_parameters", parallel_planner_parameters_);
+	RCLCPP_INFO(
+		this->get_logger(), "parallel_planner_parameters: %s",
+		parallel_planner_parameters_.c_str());
+
+	this->declare_parameter<std::string>(
+		"plan_queue_policy", plan_queue_policy_);
+	this->get_parameter("plan_queue_policy", plan_queue_policy_);
+	RCLCPP_INFO(
+		this->get_logger(), "plan_queue_policy: %s",
+		plan_queue_policy_.c_str());
+	ASSERTMSG_(
+		plan_queue_policy_ == "latest_goal_wins" ||
+			plan_queue_policy_ == "fifo",
+		"plan_queue_policy must be 'latest_goal_wins' or 'fifo'");
+
+	this->declare_parameter<double>(
+		"anytime_publish_period", anytime_publish_period_);
+	this->get_parameter("anytime_publish_period", anytime_publish_period_);
+	RCLCPP_INFO(
+		this->get_logger(), "anytime_publish_period: %.03f",
+		anytime_publish_period_);
+
+	this->declare_parameter<double>(
+		"anytime_refinement_time_budget", anytime_refinement_time_budget_);
+	this->get_parameter(
+		"anytime_refinement_time_budget", anytime_refinement_time_budget_);
+	RCLCPP_INFO(
+		this->get_logger(), "anytime_refinement_time_budget: %.03f",
+		anytime_refinement_time_budget_);
+
+	this->declare_parameter<int>(
+		"anytime_max_refinements", anytime_max_refinements_);
+	this->get_parameter("anytime_max_refinements", anytime_max_refinements_);
+	RCLCPP_INFO(
+		this->get_logger(), "anytime_max_refinements: %i",
+		anytime_max_refinements_);
+
+	this->declare_parameter<double>(
+		"planning_time_budget", planning_time_budget_);
+	this->get_parameter("planning_time_budget", planning_time_budget_);
+	RCLCPP_INFO(
+		this->get_logger(), "planning_time_budget: %.03f",
+		planning_time_budget_);
+
+	this->declare_parameter<bool>(
+		"replan_reuse_previous_path", replan_reuse_previous_path_);
+	this->get_parameter(
+		"replan_reuse_previous_path", replan_reuse_previous_path_);
+	RCLCPP_INFO(
+		this->get_logger(), "replan_reuse_previous_path: %s",
+		replan_reuse_previous_path_ ? "true" : "false");
+
+	this->declare_parameter<double>(
+		"replan_max_path_deviation", replan_max_path_deviation_);
+	this->get_parameter(
+		"replan_max_path_deviation", replan_max_path_deviation_);
+	RCLCPP_INFO(
+		this->get_logger(), "replan_max_path_deviation: %.03f",
+		replan_max_path_deviation_);
+
+	this->declare_parameter<double>(
+		"replan_repair_margin", replan_repair_margin_);
+	this->get_parameter("replan_repair_margin", replan_repair_margin_);
+	RCLCPP_INFO(
+		this->get_logger(), "replan_repair_margin: %.03f",
+		replan_repair_margin_);
+
+	this->declare_parameter<double>(
+		"replan_repair_time_budget", replan_repair_time_budget_);
+	this->get_parameter(
+		"replan_repair_time_budget", replan_repair_time_budget_);
+	RCLCPP_INFO(
+		this->get_logger(), "replan_repair_time_budget: %.03f",
+		replan_repair_time_budget_);
+
+	this->declare_parameter<double>(
+		"planning_corridor_margin", planning_corridor_margin_);
+	this->get_parameter("planning_corridor_margin", planning_corridor_margin_);
+	RCLCPP_INFO(
+		this->get_logger(), "planning_corridor_margin: %.03f",
+		planning_corridor_margin_);
+
+	this->declare_parameter<double>(
+		"planning_corridor_obstacle_border",
+		planning_corridor_obstacle_border_);
+	this->get_parameter(
+		"planning_corridor_obstacle_border",
+		planning_corridor_obstacle_border_);
+	RCLCPP_INFO(
+		this->get_logger(), "planning_corridor_obstacle_border: %.03f",
+		planning_corridor_obstacle_border_);
+
+	this->declare_parameter<int>(
+		"planning_corridor_max_widenings", planning_corridor_max_widenings_);
+	this->get_parameter(
+		"planning_corridor_max_widenings", planning_corridor_max_widenings_);
+	RCLCPP_INFO(
+		this->get_logger(), "planning_corridor_max_widenings: %i",
+		planning_corridor_max_widenings_);
+
+	this->declare_parameter<double>(
+		"batch_goal_tolerance_xy", batch_goal_tolerance_xy_);
+	this->get_parameter("batch_goal_tolerance_xy", batch_goal_tolerance_xy_);
+	RCLCPP_INFO(
+		this->get_logger(), "batch_goal_tolerance_xy: %.03f",
+		batch_goal_tolerance_xy_);
+
+	double batchGoalTolerancePhi = mrpt::RAD2DEG(batch_goal_tolerance_phi_);
+	this->declare_parameter<double>(
+		"batch_goal_tolerance_phi", batchGoalTolerancePhi);
+	this->get_parameter("batch_goal_tolerance_phi", batchGoalTolerancePhi);
+	batch_goal_tolerance_phi_ = mrpt::DEG2RAD(batchGoalTolerancePhi);
+	RCLCPP_INFO(
+		this->get_logger(), "batch_goal_tolerance_phi: %.03f deg",
+		batchGoalTolerancePhi);
+
+	auto& cp = obstacleSourceCache_.params;
+	this->declare_parameter<double>(
+		"costmap_reuse_distance", cp.costmap_reuse_distance);
+	this->get_parameter("costmap_reuse_distance", cp.costmap_reuse_distance);
+	RCLCPP_INFO(
+		this->get_logger(), "costmap_reuse_distance: %.03f",
+		cp.costmap_reuse_distance);
+
+	this->declare_parameter<bool>(
+		"background_costmap_build", cp.background_build);
+	this->get_parameter("background_costmap_build", cp.background_build);
+	RCLCPP_INFO(
+		this->get_logger(), "background_costmap_build: %s",
+		cp.background_build ? "true" : "false");
+
+	auto& pcp = planCache_.params;
+	int planCacheMaxEntries = static_cast<int>(pcp.max_entries);
+	this->declare_parameter<int>("plan_cache_max_entries", planCacheMaxEntries);
+	this->get_parameter("plan_cache_max_entries", planCacheMaxEntries);
+	pcp.max_entries = static_cast<size_t>(std::max(0, planCacheMaxEntries));
+	RCLCPP_INFO(
+		this->get_logger(), "plan_cache_max_entries: %i", planCacheMaxEntries);
+
+	this->declare_parameter<double>(
+		"plan_cache_position_resolution", pcp.position_resolution);
+	this->get_parameter(
+		"plan_cache_position_resolution", pcp.position_resolution);
+	RCLCPP_INFO(
+		this->get_logger(), "plan_cache_position_resolution: %.03f",
+		pcp.position_resolution);
+
+	double planCacheHeadingResolution = mrpt::RAD2DEG(pcp.heading_resolution);
+	this->declare_parameter<double>(
+		"plan_cache_heading_resolution", planCacheHeadingResolution);
+	this->get_parameter(
+		"plan_cache_heading_resolution", planCacheHeadingResolution);
+	pcp.heading_resolution = mrpt::DEG2RAD(planCacheHeadingResolution);
+	RCLCPP_INFO(
+		this->get_logger(), "plan_cache_heading_resolution: %.03f deg",
+		planCacheHeadingResolution);
+
 	this->declare_parameter<double>(
 		"mid_waypoints_allowed_distance", mid_waypoints_allowed_distance_);
 	this->get_parameter(
@@ -551,15 +1228,53 @@ void TPS_Astar_Planner_Node::initialize_planner()
 
 	const auto c = mrpt::containers::yaml::FromFile(planner_params_file_);
 	planner_->params_from_yaml(c);
+	planner_max_computation_time_ =
+		planner_->params_as_yaml()["maximumComputationTime"].as<double>();
 	RCLCPP_INFO_STREAM(
 		this->get_logger(),
 		"Loaded these planner params:" << planner_->params_as_yaml());
 
-	mrpt::config::CConfigFile cfg(ptg_ini_file_);
-	ptgs_.initFromConfigFile(cfg, "SelfDriving");
+	{
+		const auto tStart = mrpt::Clock::now();
+		const bool fromCache = mrpt_tps_astar_planner::init_ptgs_with_cache(
+			ptgs_, ptg_ini_file_, "SelfDriving", ptg_cache_dir_);
+		RCLCPP_INFO_STREAM(
+			this->get_logger(),
+			"PTGs " << (fromCache ? "loaded from cache" : "built") << " in "
+					<< mrpt::system::timeDifference(
+						   tStart, mrpt::Clock::now())
+					<< " s");
+	}
+
+	std::vector<std::string> lstVariantFiles;
+	mrpt::system::tokenize(
+		parallel_planner_parameters_, ", \t\r\n", lstVariantFiles);
+	planner_variants_.clear();
+	for (const auto& f : lstVariantFiles)
+	{
+		ASSERT_FILE_EXISTS_(f);
+
+		auto& v = planner_variants_.emplace_back();
+		v.params_file = f;
+		v.planner = mpp::TPS_Astar::Create();
+		v.planner->params_from_yaml(mrpt::containers::yaml::FromFile(f));
+		v.max_computation_time =
+			v.planner->params_as_yaml()["maximumComputationTime"].as<double>();
+		mrpt_tps_astar_planner::init_ptgs_with_cache(
+			v.ptgs, ptg_ini_file_, "SelfDriving", ptg_cache_dir_);
+
+		RCLCPP_INFO_STREAM(
+			this->get_logger(),
+			"Loaded parallel planner params from: " << f);
+	}
+
+	robot_radius_ = 0;
+	for (const auto& ptg : ptgs_.ptgs)
+		robot_radius_ = std::max(robot_radius_, ptg->getMaxRobotRadius());
 
 	costMapParams_ = mpp::CostEvaluatorCostMap::Parameters::FromYAML(
 		mrpt::containers::yaml::FromFile(costmap_params_file_));
+	obstacleSourceCache_.set_costmap_parameters(costMapParams_);
 }
 
 void TPS_Astar_Planner_Node::callback_goal(
@@ -568,24 +1283,20 @@ void TPS_Astar_Planner_Node::callback_goal(
 	try
 	{
 		const auto p = mrpt::ros2bridge::fromROS(_goal.pose);
-		mrpt::math::TPose2D nav_goal = mrpt::math::TPose2D(p.asTPose());
-
-		mrpt::poses::CPose3D robot_pose;
-		const bool robot_pose_ok =
-			wait_for_transform(robot_pose, frame_id_robot_, frame_id_map_);
-
-		ASSERT_(robot_pose_ok);
-
-		/// Navigation start position
-		mrpt::math::TPose2D start_pose;
-		start_pose.x = robot_pose.x();
-		start_pose.y = robot_pose.y();
-		start_pose.phi = robot_pose.yaw();
 
-		const auto res = do_path_plan(start_pose, nav_goal);
+		auto req = std::make_shared<PlanRequest>();
+		req->goal = mrpt::math::TPose2D(p.asTPose());
+		req->timeBudget = planning_time_budget_;
+		req->publishProgress = true;
+		req->description = "goal topic";
+		req->onDone = [this](const PlanResult* res)
+		{
+			// Publish, unless it was already done while refining it:
+			if (res && !res->published && (res->valid || res->partial))
+				publish_waypoint_sequence(res->wps);
+		};
 
-		// Publish:
-		if (res.valid) publish_waypoint_sequence(res.wps);
+		enqueue_plan_request(req);
 	}
 	catch (const std::exception& e)
 	{
@@ -594,14 +1305,163 @@ void TPS_Astar_Planner_Node::callback_goal(
 	}
 }
 
-void TPS_Astar_Planner_Node::callback_map(
-	const nav_msgs::msg::OccupancyGrid::SharedPtr& grid,
-	TPS_Astar_Planner_Node::InfoPerGridMapSource& e)
+void TPS_Astar_Planner_Node::enqueue_plan_request(const PlanRequestPtr& req)
 {
-	RCLCPP_INFO_STREAM(
-		this->get_logger(),
-		"Received gridmap from topic: " << e.sub->get_topic_name());
-
+	std::deque<PlanRequestPtr> preempted;
+	{
+		auto lck = mrpt::lockHelper(planQueueMtx_);
+		if (plan_queue_policy_ == "latest_goal_wins")
+		{
+			// Only requests from the same interface are preempted, e.g. a
+			// goal topic message does not drop pending service calls:
+			auto sameSource = [&](const PlanRequestPtr& r)
+			{ return r->description == req->description; };
+
+			for (auto it = planQueue_.begin(); it != planQueue_.end();)
+			{
+				if (!sameSource(*it))
+				{
+					++it;
+					continue;
+				}
+				preempted.push_back(*it);
+				it = planQueue_.erase(it);
+			}
+			if (currentPlanRequest_ && sameSource(currentPlanRequest_))
+				cancelCurrentPlan_ = true;
+		}
+		planQueue_.push_back(req);
+	}
+	planQueueCv_.notify_one();
+
+	for (const auto& r : preempted)
+		drop_plan_request(r, "preempted by a newer one");
+}
+
+void TPS_Astar_Planner_Node::drop_plan_request(
+	const PlanRequestPtr& req, const char* reason)
+{
+	RCLCPP_INFO_STREAM(
+		this->get_logger(), "Dropped pending plan request from "
+								<< req->description << ": " << reason << ".");
+	if (req->onDone) req->onDone(nullptr);
+	if (req->onBatchDone) req->onBatchDone(nullptr);
+}
+
+void TPS_Astar_Planner_Node::drop_canceled_plan_requests()
+{
+	std::deque<PlanRequestPtr> canceled;
+	{
+		auto lck = mrpt::lockHelper(planQueueMtx_);
+		for (auto it = planQueue_.begin(); it != planQueue_.end();)
+		{
+			if (!(*it)->isCanceled || !(*it)->isCanceled())
+			{
+				++it;
+				continue;
+			}
+			canceled.push_back(*it);
+			it = planQueue_.erase(it);
+		}
+	}
+	for (const auto& r : canceled) drop_plan_request(r, "canceled");
+}
+
+void TPS_Astar_Planner_Node::check_plan_canceled()
+{
+	if (cancelCurrentPlan_) throw PlanCanceled();
+
+	// Answer requests canceled while queued now, not after this plan:
+	drop_canceled_plan_requests();
+
+	auto lck = mrpt::lockHelper(planQueueMtx_);
+	const auto req = currentPlanRequest_;
+	lck.unlock();
+
+	if (req && req->isCanceled && req->isCanceled()) throw PlanCanceled();
+}
+
+void TPS_Astar_Planner_Node::plan_worker()
+{
+	for (;;)
+	{
+		drop_canceled_plan_requests();
+
+		PlanRequestPtr req;
+		{
+			std::unique_lock<std::mutex> lck(planQueueMtx_);
+			planQueueCv_.wait(
+				lck,
+				[this]() { return planWorkerExit_ || !planQueue_.empty(); });
+			if (planWorkerExit_) break;
+
+			req = planQueue_.front();
+			planQueue_.pop_front();
+			currentPlanRequest_ = req;
+			cancelCurrentPlan_ = false;
+		}
+
+		std::optional<PlanResult> res;
+		std::optional<BatchPlanResult> batchRes;
+		try
+		{
+			mrpt::math::TPose2D start_pose;
+			if (req->start)
+			{
+				start_pose = *req->start;
+			}
+			else
+			{
+				mrpt::poses::CPose3D robot_pose;
+				const bool robot_pose_ok = wait_for_transform(
+					robot_pose, frame_id_robot_, frame_id_map_);
+
+				ASSERT_(robot_pose_ok);
+
+				start_pose = mrpt::poses::CPose2D(robot_pose).asTPose();
+			}
+
+			if (!req->batchGoals.empty())
+				batchRes =
+					do_batch_plan(start_pose, req->batchGoals, req->timeBudget);
+			else
+				res = do_path_plan(
+					start_pose, req->goal, req->timeBudget,
+					req->publishProgress);
+		}
+		catch (const PlanCanceled&)
+		{
+			RCLCPP_INFO_STREAM(
+				this->get_logger(),
+				"Plan request from " << req->description << " canceled.");
+		}
+		catch (const std::exception& e)
+		{
+			RCLCPP_ERROR_STREAM(
+				this->get_logger(), "Exception planning request from "
+										<< req->description << ": "
+										<< e.what());
+		}
+
+		{
+			auto lck = mrpt::lockHelper(planQueueMtx_);
+			currentPlanRequest_.reset();
+		}
+
+		if (req->onDone) req->onDone(res ? &res.value() : nullptr);
+		if (req->onBatchDone)
+			req->onBatchDone(batchRes ? &batchRes.value() : nullptr);
+	}
+}
+
+void TPS_Astar_Planner_Node::callback_map(
+	const nav_msgs::msg::OccupancyGrid::SharedPtr& grid,
+	TPS_Astar_Planner_Node::InfoPerGridMapSource& e)
+{
+	RCLCPP_INFO_STREAM(
+		this->get_logger(),
+		"Received gridmap from topic: " << e.sub->get_topic_name());
+
 	update_map(grid, e);
 }
 
@@ -620,35 +1480,81 @@ void TPS_Astar_Planner_Node::update_obstacles(
 	const sensor_msgs::msg::PointCloud2::SharedPtr& pcMsg,
 	InfoPerPointMapSource& e)
 {
-	auto lck = mrpt::lockHelper(obstacles_cs_);
-
-	auto pc = mrpt::maps::CSimplePointsMap::Create();
-	if (!mrpt::ros2bridge::fromROS(*pcMsg, *pc))
 	{
-		RCLCPP_ERROR(
-			this->get_logger(),
-			"Failed to convert Point Cloud to MRPT Points Map");
+		auto lck = mrpt::lockHelper(pendingCloudsMtx_);
+		e.pending.push_back({pcMsg, mrpt::Clock::now()});
+
+		while (e.pending.size() >
+			   static_cast<size_t>(std::max(1, obstacles_tf_queue_size_)))
+			e.pending.pop_front();
 	}
 
-	// Transform the cloud to its global pose in the map:
+	process_pending_obstacles(e);
+}
+
+void TPS_Astar_Planner_Node::process_pending_obstacles(
+	InfoPerPointMapSource& e)
+{
+	// Take the newest cloud whose TF is already available. The older ones
+	// are superseded by it, and those waiting for too long are dropped:
+	sensor_msgs::msg::PointCloud2::SharedPtr pcMsg;
 	mrpt::poses::CPose3D sensorPoseInMap;
+	{
+		auto lck = mrpt::lockHelper(pendingCloudsMtx_);
+		for (size_t i = e.pending.size(); i-- > 0;)
+		{
+			const auto& m = *e.pending[i].msg;
+			if (!lookup_transform_at(
+					sensorPoseInMap, m.header.frame_id, frame_id_map_,
+					m.header.stamp))
+				continue;
+
+			pcMsg = e.pending[i].msg;
+			e.pending.erase(e.pending.begin(), e.pending.begin() + i + 1);
+			break;
+		}
 
-	// Brief pause to allow time for the transform data to become available
-	const auto timeout = std::chrono::milliseconds(50);
-	const auto tStart = this->now();
-	const double max_duration = 5.0;  // seconds
+		const auto tNow = mrpt::Clock::now();
+		while (!e.pending.empty() &&
+			   mrpt::system::timeDifference(e.pending.front().received, tNow) >
+				   obstacles_tf_timeout_)
+		{
+			RCLCPP_WARN_STREAM(
+				this->get_logger(),
+				"Dropping obstacle points from topic '"
+					<< e.sub->get_topic_name() << "': no TF from '"
+					<< e.pending.front().msg->header.frame_id << "' to '"
+					<< frame_id_map_ << "' after " << obstacles_tf_timeout_
+					<< " s");
+			e.pending.pop_front();
+		}
+	}
+	if (!pcMsg) return;
 
-	while (!wait_for_transform(
-		sensorPoseInMap, pcMsg->header.frame_id, frame_id_map_))
+	// Convert and transform the cloud to its global pose in the map,
+	// without holding any lock:
+	auto pc = mrpt::maps::CSimplePointsMap::Create();
+	if (!mrpt::ros2bridge::fromROS(*pcMsg, *pc))
 	{
-		std::this_thread::sleep_for(timeout);
-		auto duration = this->get_clock()->now() - tStart;
-		ASSERT_(duration.seconds() < max_duration);
+		RCLCPP_ERROR(
+			this->get_logger(),
+			"Failed to convert Point Cloud to MRPT Points Map");
+		return;
 	}
-
 	pc->changeCoordinatesReference(sensorPoseInMap);
 
+	const rclcpp::Time stamp(pcMsg->header.stamp);
+
+	auto lck = mrpt::lockHelper(obstacles_cs_);
+	// Do not replace newer points, if processed in another thread:
+	if (e.obstacle_points_stamp && stamp < *e.obstacle_points_stamp) return;
 	e.obstacle_points = pc;
+	e.obstacle_points_stamp = stamp;
+	const auto startPoseHint = lastPlanStartPose_;
+	lck.unlock();
+
+	obstacleSourceCache_.update_source(
+		std::string("points:") + e.sub->get_topic_name(), pc, startPoseHint);
 }
 
 void TPS_Astar_Planner_Node::publish_waypoint_sequence(
@@ -657,6 +1563,86 @@ void TPS_Astar_Planner_Node::publish_waypoint_sequence(
 	pub_wp_seq_->publish(wps);
 }
 
+void TPS_Astar_Planner_Node::publish_plan_progress()
+{
+	const auto latest = progressBuffer_.pop_latest();
+	if (!latest) return;
+	const auto& s = *latest;
+
+	mrpt_nav_interfaces::msg::PlannerMetrics msg;
+	msg.header.stamp = this->now();
+	msg.header.frame_id = frame_id_map_;
+	{
+		auto lck = mrpt::lockHelper(planQueueMtx_);
+		if (currentPlanRequest_)
+			msg.request = currentPlanRequest_->description;
+	}
+	msg.in_progress = true;
+	msg.elapsed_time = s.elapsedTime;
+	msg.tree_nodes = s.treeNodes;
+	msg.expansions_per_second = s.expansions_per_second();
+	msg.best_cost_from_start = s.bestCostFromStart;
+	msg.best_cost_to_goal = s.bestCostToGoal;
+	msg.best_path_nodes = s.bestPathNodes;
+
+	pub_planner_metrics_->publish(msg);
+}
+
+mrpt_nav_interfaces::msg::PlannerMetrics TPS_Astar_Planner_Node::plan_metrics(
+	const mpp::PlannerOutput& plan,
+	const mrpt_tps_astar_planner::PlanProgressHistory& history,
+	const std::map<std::string, mrpt::system::CTimeLogger::TCallStats>&
+		profilerBefore,
+	double elapsedTime, const std::string& request)
+{
+	mrpt_nav_interfaces::msg::PlannerMetrics msg;
+	msg.header.stamp = this->now();
+	msg.header.frame_id = frame_id_map_;
+	msg.request = request;
+	msg.in_progress = false;
+	msg.success = plan.success;
+	msg.elapsed_time = elapsedTime;
+	msg.tree_nodes = plan.motionTree.nodes().size();
+	msg.expansions_per_second =
+		elapsedTime > 0 ? msg.tree_nodes / elapsedTime : 0;
+
+	if (const auto& last = history.last(); last)
+	{
+		msg.best_cost_from_start = last->bestCostFromStart;
+		msg.best_cost_to_goal = last->bestCostToGoal;
+		msg.best_path_nodes = last->bestPathNodes;
+	}
+
+	for (const auto& s : history.samples())
+	{
+		msg.history_elapsed_time.push_back(s.elapsedTime);
+		msg.history_best_cost_to_goal.push_back(s.bestCostToGoal);
+		msg.history_tree_nodes.push_back(s.treeNodes);
+	}
+
+	// The profiler accumulates since startup: publish only what changed
+	// during this search.
+	std::map<std::string, mrpt::system::CTimeLogger::TCallStats> stats;
+	planner_->profiler_().getStats(stats);
+	for (const auto& [name, st] : stats)
+	{
+		size_t calls = st.n_calls;
+		double totalTime = st.mean_t * st.n_calls;
+		if (auto it = profilerBefore.find(name); it != profilerBefore.end())
+		{
+			calls -= std::min(calls, it->second.n_calls);
+			totalTime -= it->second.mean_t * it->second.n_calls;
+		}
+		if (!calls) continue;
+
+		msg.profiler_sections.push_back(name);
+		msg.profiler_calls.push_back(calls);
+		msg.profiler_mean_time.push_back(std::max(0.0, totalTime / calls));
+	}
+
+	return msg;
+}
+
 void TPS_Astar_Planner_Node::init_3d_debug()
 {
 	if (win_3d_) return;
@@ -670,10 +1656,12 @@ void TPS_Astar_Planner_Node::init_3d_debug()
 
 	auto lck = mrpt::lockHelper(obstacles_cs_);
 
-	for (const auto& e : gridmaps_) scene->insert(e.grid->getVisualization());
+	for (const auto& e : gridmaps_)
+		if (e.grid) scene->insert(e.grid->getVisualization());
 
 	for (const auto& e : obstacle_points_)
-		scene->insert(e.obstacle_points->getVisualization());
+		if (e.obstacle_points)
+			scene->insert(e.obstacle_points->getVisualization());
 
 	lck.unlock();
 
@@ -685,17 +1673,421 @@ void TPS_Astar_Planner_Node::init_3d_debug()
 void TPS_Astar_Planner_Node::update_map(
 	const nav_msgs::msg::OccupancyGrid::SharedPtr& msg, InfoPerGridMapSource& e)
 {
+	// Convert without holding the lock, and only the cells that changed
+	// since the former grid from this topic:
+	mrpt_tps_astar_planner::OccupancyGridObstacles::GridInfo info;
+	info.width = msg->info.width;
+	info.height = msg->info.height;
+	info.resolution = msg->info.resolution;
+	info.origin_x = msg->info.origin.position.x;
+	info.origin_y = msg->info.origin.position.y;
+
+	const auto r = e.converter.update(info, msg->data);
+
+	// The full gridmap is only needed for the GUI:
+	mrpt::maps::COccupancyGridMap2D::Ptr grid;
+	if (gui_mrpt_)
+	{
+		grid = mrpt::maps::COccupancyGridMap2D::Create();
+		mrpt::ros2bridge::fromROS(*msg, *grid);
+	}
+
+	RCLCPP_DEBUG_STREAM(
+		this->get_logger(), "Gridmap from topic '"
+								<< e.sub->get_topic_name() << "': "
+								<< r.changedCells << " changed cells, "
+								<< r.points->size() << " obstacle points.");
+
 	auto lck = mrpt::lockHelper(obstacles_cs_);
+	if (grid) e.grid = grid;
+	e.grid_obstacles = r.points;
+	const auto startPoseHint = lastPlanStartPose_;
+	lck.unlock();
 
-	e.grid = mrpt::maps::COccupancyGridMap2D::Create();
-	mrpt::ros2bridge::fromROS(*msg, *e.grid);
+	if (!r.changed) return;
 
-	e.grid_obstacles = mrpt::maps::CSimplePointsMap::Create();
-	e.grid->getAsPointCloud(*e.grid_obstacles);
+	obstacleSourceCache_.update_source(
+		std::string("gridmap:") + e.sub->get_topic_name(), r.points,
+		startPoseHint, r.changedArea);
 }
 
 TPS_Astar_Planner_Node::PlanResult TPS_Astar_Planner_Node::do_path_plan(
-	const mrpt::math::TPose2D& start, const mrpt::math::TPose2D& goal)
+	const mrpt::math::TPose2D& start, const mrpt::math::TPose2D& goal,
+	double timeBudget, bool publishProgress)
+{
+	if (replan_reuse_previous_path_)
+	{
+		const auto tStart = mrpt::Clock::now();
+		if (auto res = repair_active_plan(start, goal); res)
+		{
+			const double dt =
+				mrpt::system::timeDifference(tStart, mrpt::Clock::now());
+			RCLCPP_INFO_STREAM(
+				this->get_logger(),
+				"Reused the previous plan in " << 1e3 * dt << " ms");
+			res->metrics.success = true;
+			res->metrics.elapsed_time = dt;
+			return std::move(*res);
+		}
+	}
+
+	if (auto res = cached_plan(start, goal); res)
+	{
+		activePlan_ = ActivePlan{goal, res->path, res->obstacleVersions};
+		return std::move(*res);
+	}
+
+	// Search within the planning corridor, widening it if no path is found,
+	// and finally without corridor. All attempts share the time budget:
+	const double budget =
+		timeBudget > 0 ? timeBudget : planner_max_computation_time_;
+	const auto tStart = mrpt::Clock::now();
+
+	PlanResult res;
+	double corridorMargin = planning_corridor_margin_;
+	for (int nWidenings = 0;; nWidenings++)
+	{
+		const double remaining = budget -
+			mrpt::system::timeDifference(tStart, mrpt::Clock::now());
+
+		res = search_path(
+			start, goal, budget > 0 ? remaining : 0, publishProgress,
+			corridorMargin);
+
+		// Do not retry if the time budget ran out (partial path):
+		if (res.valid || res.partial || corridorMargin <= 0) break;
+
+		if (budget > 0 &&
+			mrpt::system::timeDifference(tStart, mrpt::Clock::now()) >=
+				budget)
+		{
+			RCLCPP_INFO(
+				this->get_logger(),
+				"No path found within the planning corridor, and the time "
+				"budget is used up.");
+			break;
+		}
+
+		corridorMargin = nWidenings < planning_corridor_max_widenings_
+			? 2 * corridorMargin
+			: 0;
+
+		RCLCPP_INFO_STREAM(
+			this->get_logger(),
+			"No path found within the planning corridor, retrying "
+				<< (corridorMargin > 0
+						? "with margin " + std::to_string(corridorMargin) +
+							" m"
+						: "without corridor"));
+	}
+
+	// Publish the path found right away, then try to improve it:
+	if (res.valid && publishProgress && anytime_refinement_time_budget_ > 0 &&
+		anytime_max_refinements_ > 0)
+	{
+		publish_waypoint_sequence(res.wps);
+		res.published = true;
+		refine_path(res, goal);
+	}
+
+	if (res.valid)
+	{
+		activePlan_ = ActivePlan{goal, res.path, res.obstacleVersions};
+		planCache_.insert(start, goal, res.path, res.obstacleVersions);
+	}
+	else
+		activePlan_.reset();
+
+	return res;
+}
+
+TPS_Astar_Planner_Node::BatchPlanResult TPS_Astar_Planner_Node::do_batch_plan(
+	const mrpt::math::TPose2D& start,
+	const std::vector<mrpt::math::TPose2D>& goals, double timeBudget)
+{
+	const size_t N = goals.size();
+
+	BatchPlanResult out;
+	out.goals.resize(N);
+
+	const double budget = timeBudget > 0 ? timeBudget
+		: planning_time_budget_ > 0	 ? planning_time_budget_
+									 : planner_max_computation_time_ * N;
+
+	// Farthest goals first: their search trees are the most likely to
+	// also reach the nearer goals.
+	std::vector<size_t> order(N);
+	std::iota(order.begin(), order.end(), 0);
+	std::sort(
+		order.begin(), order.end(),
+		[&](size_t a, size_t b)
+		{
+			return (goals[a].translation() - start.translation()).norm() >
+				(goals[b].translation() - start.translation()).norm();
+		});
+
+	std::vector<bool> pending(N, true), searched(N, false);
+
+	// Takes, for each pending goal, the cheapest path to a node of the tree
+	// within the goal tolerances. That path ends at the tree node itself:
+	// a final step to the exact goal would not be collision-checked.
+	auto resolve_goals = [&](const mpp::PlannerOutput& po)
+	{
+		const auto& tree = po.motionTree;
+
+		// Cost-to-come of the tree nodes, computed at most once per node
+		// from the parent edges instead of backtracking each candidate:
+		using mrpt::graphs::TNodeID;
+		std::map<TNodeID, std::pair<TNodeID, double>> parentOf;
+		for (const auto& [parentId, edges] : tree.edges_to_children)
+			for (const auto& e : edges)
+				parentOf[e.targetId] = {parentId, e.cost};
+
+		std::map<TNodeID, double> costToCome;
+		auto cost_to_come = [&](TNodeID id)
+		{
+			std::vector<TNodeID> chain;
+			double cost = 0;
+			for (;;)
+			{
+				if (const auto c = costToCome.find(id); c != costToCome.end())
+				{
+					cost = c->second;
+					break;
+				}
+				const auto p = parentOf.find(id);
+				if (p == parentOf.end()) break;	 // the root
+				chain.push_back(id);
+				id = p->second.first;
+			}
+			for (auto it = chain.rbegin(); it != chain.rend(); ++it)
+			{
+				cost += parentOf.at(*it).second;
+				costToCome[*it] = cost;
+			}
+			return cost;
+		};
+
+		for (size_t i = 0; i < N; i++)
+		{
+			if (!pending[i]) continue;
+
+			std::optional<TNodeID> bestNode;
+			double bestCost = std::numeric_limits<double>::max();
+			for (const auto& [nodeId, node] : tree.nodes())
+			{
+				if ((node.pose.translation() - goals[i].translation())
+							.norm() > batch_goal_tolerance_xy_ ||
+					std::abs(mrpt::math::angDistance(
+						node.pose.phi, goals[i].phi)) >
+						batch_goal_tolerance_phi_)
+					continue;
+
+				if (const double cost = cost_to_come(nodeId); cost < bestCost)
+				{
+					bestCost = cost;
+					bestNode = nodeId;
+				}
+			}
+			if (!bestNode) continue;
+
+			auto& g = out.goals[i];
+			g.valid = true;
+			g.cost = bestCost;
+			g.path = path_to_poses(tree, *bestNode, po.originalInput);
+			g.wps = poses_to_waypoints(g.path, std::nullopt);
+			pending[i] = false;
+		}
+	};
+
+	const auto tStart = mrpt::Clock::now();
+	for (;;)
+	{
+		// The farthest goal not reached by any tree so far. Goals whose own
+		// search failed are not retried:
+		const auto it = std::find_if(
+			order.begin(), order.end(),
+			[&](size_t i) { return pending[i] && !searched[i]; });
+		if (it == order.end()) break;
+
+		const double remaining = budget -
+			mrpt::system::timeDifference(tStart, mrpt::Clock::now());
+		if (budget > 0 && remaining <= 0)
+		{
+			RCLCPP_WARN(
+				this->get_logger(),
+				"Batch planning: time budget exhausted with goals pending");
+			break;
+		}
+		check_plan_canceled();
+
+		const size_t i = *it;
+		searched[i] = true;
+
+		// No planning corridor: the tree should reach the other goals too.
+		const auto res = search_path(
+			start, goals[i], budget > 0 ? remaining : 0, false, 0);
+		out.searches++;
+
+		if (res.valid)
+		{
+			auto& g = out.goals[i];
+			g.valid = true;
+			g.cost = res.plan_output.pathCost;
+			g.path = res.path;
+			g.wps = res.wps;
+			pending[i] = false;
+		}
+		resolve_goals(res.plan_output);
+	}
+
+	RCLCPP_INFO_STREAM(
+		this->get_logger(),
+		"Batch planning: "
+			<< std::count(pending.begin(), pending.end(), false) << "/" << N
+			<< " goals reached with " << out.searches << " searches in "
+			<< mrpt::system::timeDifference(tStart, mrpt::Clock::now())
+			<< " s");
+
+	return out;
+}
+
+std::optional<TPS_Astar_Planner_Node::PlanResult>
+	TPS_Astar_Planner_Node::cached_plan(
+		const mrpt::math::TPose2D& start, const mrpt::math::TPose2D& goal)
+{
+	if (planCache_.params.max_entries == 0) return {};
+
+	const auto tStart = mrpt::Clock::now();
+	// Checking the path needs no costmaps, so none is built here:
+	const auto sources = obstacleSourceCache_.get_all_points();
+	auto path = planCache_.lookup(start, goal, sources, robot_radius_);
+	const double dt = mrpt::system::timeDifference(tStart, mrpt::Clock::now());
+
+	const auto st = planCache_.stats();
+	RCLCPP_INFO_STREAM(
+		this->get_logger(),
+		"Plan cache " << (path ? "hit" : "miss") << " in " << 1e3 * dt
+					  << " ms. Hit rate: " << 100 * st.hit_rate() << "% of "
+					  << st.lookups << " (" << st.revalidated
+					  << " revalidated, " << st.invalidated
+					  << " invalidated), entries: " << st.entries << "/"
+					  << planCache_.params.max_entries
+					  << ", memory: " << st.memoryBytes / 1024 << " KiB");
+
+	if (!path || path->empty()) return {};
+
+	PlanResult res;
+	res.valid = true;
+	res.path = std::move(*path);
+	res.wps = poses_to_waypoints(res.path, goal);
+	res.metrics.success = true;
+	res.metrics.elapsed_time = dt;
+	for (const auto& d : sources)
+		res.obstacleVersions[d->sourceName] = d->version;
+	return res;
+}
+
+std::optional<TPS_Astar_Planner_Node::PlanResult>
+	TPS_Astar_Planner_Node::repair_active_plan(
+		const mrpt::math::TPose2D& start, const mrpt::math::TPose2D& goal)
+{
+	using namespace mrpt_tps_astar_planner;
+
+	if (!activePlan_ || activePlan_->path.empty()) return {};
+	auto& ap = *activePlan_;
+
+	// Only for the same goal...
+	if ((ap.goal.translation() - goal.translation()).norm() > 1e-3 ||
+		std::abs(mrpt::math::angDistance(ap.goal.phi, goal.phi)) > 1e-3)
+		return {};
+
+	// ...and while the robot is close to the path:
+	const size_t iRobot = closest_path_pose(ap.path, start);
+	if ((ap.path[iRobot].translation() - start.translation()).norm() >
+		replan_max_path_deviation_)
+		return {};
+
+	// The path starts at the actual robot pose:
+	std::vector<mrpt::math::TPose2D> path(
+		ap.path.begin() + iRobot, ap.path.end());
+	path.front() = start;
+
+	// Only obstacle sources that changed since the last plan can invalidate
+	// the path, except for the new segment from the robot, which was never
+	// checked. No costmaps are needed for these checks:
+	std::vector<mrpt::maps::CPointsMap::Ptr> changedObstacles, allObstacles;
+	std::map<std::string, uint64_t> versions;
+	for (const auto& d : obstacleSourceCache_.get_all_points())
+	{
+		allObstacles.push_back(d->points);
+		versions[d->sourceName] = d->version;
+		const auto it = ap.obstacleVersions.find(d->sourceName);
+		if (it == ap.obstacleVersions.end() || it->second != d->version)
+			changedObstacles.push_back(d->points);
+	}
+
+	// Replan blocked stretches, from a pose a margin before them to a pose
+	// a margin after them (or to the goal), and splice the new paths:
+	const std::vector<mrpt::math::TPose2D> firstSegment(
+		path.begin(), path.begin() + std::min<size_t>(2, path.size()));
+	const bool firstSegmentBlocked =
+		first_path_collision(firstSegment, allObstacles, robot_radius_)
+			.has_value();
+
+	const size_t MAX_REPAIRS = 3;
+	for (size_t nRepairs = 0;; nRepairs++)
+	{
+		// A repaired stretch from the robot is a new path, already checked:
+		const auto iCol = nRepairs == 0 && firstSegmentBlocked
+			? std::optional<size_t>(0)
+			: first_path_collision(path, changedObstacles, robot_radius_);
+		if (!iCol) break;
+		if (nRepairs >= MAX_REPAIRS) return {};
+
+		size_t iFrom = *iCol;
+		while (iFrom > 0 &&
+			   path_length(path, iFrom, *iCol) < replan_repair_margin_)
+			iFrom--;
+		size_t iTo = *iCol + 1;
+		while (iTo < path.size() &&
+			   path_length(path, *iCol, iTo) < replan_repair_margin_)
+			iTo++;
+		const bool toGoal = iTo >= path.size();
+
+		RCLCPP_INFO_STREAM(
+			this->get_logger(), "Replanning blocked path stretch: poses "
+									<< iFrom << " to "
+									<< (toGoal ? "goal" : std::to_string(iTo))
+									<< " of " << path.size());
+
+		const auto sub = search_path(
+			iFrom == 0 ? start : path[iFrom], toGoal ? goal : path[iTo],
+			replan_repair_time_budget_, false, planning_corridor_margin_);
+		if (!sub.valid) return {};
+
+		std::vector<mrpt::math::TPose2D> repaired(
+			path.begin(), path.begin() + iFrom);
+		repaired.insert(repaired.end(), sub.path.begin(), sub.path.end());
+		if (!toGoal)
+			repaired.insert(repaired.end(), path.begin() + iTo, path.end());
+		path = std::move(repaired);
+	}
+
+	ap.path = path;
+	ap.obstacleVersions = versions;
+
+	PlanResult res;
+	res.valid = true;
+	res.path = std::move(path);
+	res.wps = poses_to_waypoints(res.path, goal);
+	res.obstacleVersions = std::move(versions);
+	return res;
+}
+
+TPS_Astar_Planner_Node::PlanResult TPS_Astar_Planner_Node::search_path(
+	const mrpt::math::TPose2D& start, const mrpt::math::TPose2D& goal,
+	double timeBudget, bool publishProgress, double corridorMargin)
 {
 	RCLCPP_INFO_STREAM(this->get_logger(), "Do path planning");
 
@@ -717,48 +2109,26 @@ TPS_Astar_Planner_Node::PlanResult TPS_Astar_Planner_Node::do_path_plan(
 	bbox.updateWithPoint(mrpt::math::TPoint3D(start.translation()));
 	bbox.updateWithPoint(mrpt::math::TPoint3D(goal.translation()));
 
-	// Create obstacle sources, and find out bounding box:
+	// Get the obstacle sources and costmaps, and find out bounding box.
+	// They are only rebuilt if their data changed since the last plan:
 	// --------------------------------------------------------------
-	auto lckObs = mrpt::lockHelper(obstacles_cs_);
+	{
+		auto lckObs = mrpt::lockHelper(obstacles_cs_);
+		lastPlanStartPose_ = start;
+	}
 
 	planner_->costEvaluators_.clear();
 	pi.obstacles.clear();
 
-	size_t obstacleSources = 0, totalObstaclePoints = 0;
-	// gridmaps:
-	for (const auto& e : gridmaps_)
+	// With a planning corridor, the search domain is limited to its box,
+	// and obstacles far from that box are left out:
+	std::optional<mrpt_tps_astar_planner::PlanningCorridor> corridor;
+	if (corridorMargin > 0)
 	{
-		auto obs = mpp::ObstacleSource::FromStaticPointcloud(e.grid_obstacles);
-		pi.obstacles.emplace_back(obs);
-
-		auto bb = e.grid_obstacles->boundingBox();
-		bbox = bbox.unionWith(bb);
-
-		obstacleSources++;
-		totalObstaclePoints += e.grid_obstacles->size();
-
-		auto costmap = mpp::CostEvaluatorCostMap::FromStaticPointObstacles(
-			*e.grid_obstacles, costMapParams_, pi.stateStart.pose);
-		planner_->costEvaluators_.push_back(costmap);
+		corridor.emplace(
+			start.translation(), goal.translation(), corridorMargin);
+		bbox = bbox.unionWith(corridor->bounding_box());
 	}
-	// points:
-	for (const auto& e : obstacle_points_)
-	{
-		auto obs = mpp::ObstacleSource::FromStaticPointcloud(e.obstacle_points);
-		pi.obstacles.emplace_back(obs);
-
-		auto bb = obs->obstacles()->boundingBox();
-		bbox = bbox.unionWith(bb);
-
-		obstacleSources++;
-		totalObstaclePoints += e.obstacle_points->size();
-
-		auto costmap = mpp::CostEvaluatorCostMap::FromStaticPointObstacles(
-			*e.obstacle_points, costMapParams_, pi.stateStart.pose);
-		planner_->costEvaluators_.push_back(costmap);
-	}
-
-	lckObs.unlock();
 
 	{
 		const auto bboxMargin = mrpt::math::TPoint3Df(2.0, 2.0, .0);
@@ -773,6 +2143,35 @@ TPS_Astar_Planner_Node::PlanResult TPS_Astar_Planner_Node::do_path_plan(
 		bbox.updateWithPoint(ptGoal + bboxMargin);
 	}
 
+	const double obstacleBorder =
+		robot_radius_ + planning_corridor_obstacle_border_;
+
+	std::map<std::string, uint64_t> obstacleVersions;
+	size_t obstacleSources = 0, totalObstaclePoints = 0;
+	for (const auto& d : obstacleSourceCache_.get_all(start))
+	{
+		obstacleVersions[d->sourceName] = d->version;
+		obstacleSources++;
+
+		// Costmaps are bounded by maxRadiusFromRobot and cached, so they
+		// are used as they are:
+		planner_->costEvaluators_.push_back(d->costmap);
+
+		if (!corridor)
+		{
+			pi.obstacles.emplace_back(d->obstacleSource);
+			bbox = bbox.unionWith(d->bbox);
+			totalObstaclePoints += d->points->size();
+			continue;
+		}
+
+		auto cropped = mrpt_tps_astar_planner::crop_points(
+			*d->points, bbox, obstacleBorder);
+		totalObstaclePoints += cropped->size();
+		pi.obstacles.emplace_back(
+			mpp::ObstacleSource::FromStaticPointcloud(cropped));
+	}
+
 	pi.worldBboxMax = {bbox.max.x, bbox.max.y, M_PI};
 	pi.worldBboxMin = {bbox.min.x, bbox.min.y, -M_PI};
 
@@ -785,22 +2184,203 @@ TPS_Astar_Planner_Node::PlanResult TPS_Astar_Planner_Node::do_path_plan(
 						<< "\n  World bbox : " << pi.worldBboxMin.asString()
 						<< "-" << pi.worldBboxMax.asString());
 
+	// Planning deadline:
+	auto maxTimeFor = [timeBudget](double maxFromFile)
+	{
+		return timeBudget > 0 ? std::min(timeBudget, maxFromFile)
+							  : maxFromFile;
+	};
+	auto setDeadline = [&](mpp::Planner& p, double maxFromFile)
+	{
+		auto c = p.params_as_yaml();
+		c["maximumComputationTime"] = maxTimeFor(maxFromFile);
+		p.params_from_yaml(c);
+	};
+	setDeadline(*planner_, planner_max_computation_time_);
+
+	const bool anytime = anytime_publish_period_ > 0;
+
 	// Insert custom progress callback:
-	planner_->progressCallback_ = [](const mpp::ProgressCallbackData& pcd)
+	// In anytime mode, it also publishes the best partial path so far,
+	// whenever it gets closer to the goal, at most once per period:
+	const auto tPlanStart = mrpt::Clock::now();
+	auto lastPublishTime = tPlanStart;
+	double lastPublishedCostToGoal = std::numeric_limits<double>::max();
+
+	PlanRequestPtr currentRequest;
+	{
+		auto lck = mrpt::lockHelper(planQueueMtx_);
+		currentRequest = currentPlanRequest_;
+	}
+
+	// Search progress, without any I/O from the planner thread:
+	mrpt_tps_astar_planner::PlanProgressHistory progressHistory;
+
+	// Profiler snapshot, to publish the timings of this search alone:
+	std::map<std::string, mrpt::system::CTimeLogger::TCallStats>
+		profilerBefore;
+	planner_->profiler_().getStats(profilerBefore);
+
+	// Planner variants, if any, run in parallel with the main planner, in
+	// order of priority (0: main planner, i+1: variant i). The path of the
+	// highest priority planner that succeeds is used, no matter which one
+	// finishes first. Planners of lower priority than a successful one are
+	// stopped from their progress callbacks, since they cannot be used.
+	auto bestSuccess =
+		std::make_shared<std::atomic_int>(std::numeric_limits<int>::max());
+	auto reportSuccess = [bestSuccess](int id)
+	{
+		int cur = *bestSuccess;
+		while (id < cur && !bestSuccess->compare_exchange_weak(cur, id))
+		{
+		}
+	};
+
+	planner_->progressCallback_ = [&](const mpp::ProgressCallbackData& pcd)
+	{
+		check_plan_canceled();
+		if (currentRequest && currentRequest->onProgress)
+			currentRequest->onProgress(pcd);
+
+		mrpt_tps_astar_planner::PlanProgressSample sample;
+		sample.elapsedTime =
+			mrpt::system::timeDifference(tPlanStart, mrpt::Clock::now());
+		sample.treeNodes = pcd.tree ? pcd.tree->nodes().size() : 0;
+		sample.bestCostFromStart = pcd.bestCostFromStart;
+		sample.bestCostToGoal = pcd.bestCostToGoal;
+		sample.bestPathNodes = pcd.bestPath.size();
+
+		progressHistory.add(sample);
+		if (planner_metrics_period_ > 0) progressBuffer_.push(sample);
+
+		if (!anytime || !publishProgress || !pcd.tree ||
+			pcd.bestPath.size() < 2 ||
+			pcd.bestCostToGoal >= lastPublishedCostToGoal)
+			return;
+
+		const auto tNow = mrpt::Clock::now();
+		if (mrpt::system::timeDifference(lastPublishTime, tNow) <
+			anytime_publish_period_)
+			return;
+
+		const auto wps = poses_to_waypoints(
+			path_to_poses(*pcd.tree, pcd.bestPath.back(), pi), std::nullopt);
+		if (wps.waypoints.empty()) return;
+
+		publish_waypoint_sequence(wps);
+		lastPublishTime = tNow;
+		lastPublishedCostToGoal = pcd.bestCostToGoal;
+
+		RCLCPP_INFO_STREAM(
+			this->get_logger(),
+			"[anytime] Published partial path with "
+				<< wps.waypoints.size() << " waypoints, cost to goal: "
+				<< pcd.bestCostToGoal << " after "
+				<< mrpt::system::timeDifference(tPlanStart, tNow) << " s");
+	};
+
+	// Obstacle KD-trees and costmaps are shared (read only), PTGs are not:
+	std::vector<std::future<mpp::PlannerOutput>> variantPlans;
+	for (size_t i = 0; i < planner_variants_.size(); i++)
 	{
-		std::cout << "[progressCallback] bestCostFromStart: "
-				  << pcd.bestCostFromStart
-				  << " bestCostToGoal: " << pcd.bestCostToGoal
-				  << " bestPathLength: " << pcd.bestPath.size() << std::endl;
+		auto& v = planner_variants_[i];
+		const int id = static_cast<int>(i) + 1;
+
+		setDeadline(*v.planner, v.max_computation_time);
+		v.planner->costEvaluators_ = planner_->costEvaluators_;
+		v.planner->progressCallback_ =
+			[this, bestSuccess, id](const mpp::ProgressCallbackData&)
+		{
+			check_plan_canceled();
+			if (*bestSuccess < id) throw PlannerPreempted();
+		};
+
+		mpp::PlannerInput vpi = pi;
+		vpi.ptgs = v.ptgs;
+		variantPlans.emplace_back(std::async(
+			std::launch::async,
+			[planner = v.planner, vpi, reportSuccess, id]()
+			{
+				auto out = planner->plan(vpi);
+				if (out.success && out.bestNodeId) reportSuccess(id);
+				return out;
+			}));
+	}
+
+	// Waits for the variants, once the main planner is done. Returns the
+	// output of the highest priority variant that succeeded, if the main
+	// planner did not. Variants are waited for in order of priority, so
+	// when variant i is checked, no other one can outrank it anymore:
+	auto collectVariants = [&]()
+	{
+		std::optional<mpp::PlannerOutput> won;
+		for (size_t i = 0; i < variantPlans.size(); i++)
+		{
+			try
+			{
+				auto vp = variantPlans[i].get();
+				if (*bestSuccess != static_cast<int>(i) + 1) continue;
+
+				RCLCPP_INFO_STREAM(
+					this->get_logger(), "Parallel planner '"
+											<< planner_variants_[i].params_file
+											<< "' found the path, cost: "
+											<< vp.pathCost);
+				won = std::move(vp);
+			}
+			catch (const PlannerPreempted&)
+			{
+			}
+			catch (const PlanCanceled&)
+			{
+			}
+			catch (const std::exception& e)
+			{
+				RCLCPP_WARN_STREAM(
+					this->get_logger(), "Parallel planner '"
+											<< planner_variants_[i].params_file
+											<< "' failed: " << e.what());
+			}
+		}
+		return won;
 	};
 
-	const mpp::PlannerOutput plan = planner_->plan(pi);
+	// The main planner has the highest priority, so it is never stopped:
+	mpp::PlannerOutput plan;
+	try
+	{
+		plan = planner_->plan(pi);
+		if (plan.success && plan.bestNodeId) reportSuccess(0);
+	}
+	catch (...)
+	{
+		// The callback refers to local variables:
+		planner_->progressCallback_ = {};
+		*bestSuccess = 0;  // stop all variants
+		collectVariants();
+		throw;
+	}
 
-	std::cout << "\nDone.\n";
-	std::cout << "Success: " << (plan.success ? "YES" : "NO") << "\n";
-	std::cout << "Plan has " << plan.motionTree.edges_to_children.size()
-			  << " overall edges, " << plan.motionTree.nodes().size()
-			  << " nodes\n";
+	planner_->progressCallback_ = {};
+
+	// If the main planner failed, the variants keep searching until the
+	// first one of them succeeds or fails, then the second one, etc.:
+	if (auto won = collectVariants(); won) plan = std::move(*won);
+
+	const double planningTime =
+		mrpt::system::timeDifference(tPlanStart, mrpt::Clock::now());
+	RCLCPP_INFO_STREAM(
+		this->get_logger(), "Planning done in "
+								<< planningTime << " s. Success: "
+								<< (plan.success ? "YES" : "NO") << ". Tree: "
+								<< plan.motionTree.nodes().size() << " nodes, "
+								<< plan.motionTree.edges_to_children.size()
+								<< " edges.");
+
+	const auto metrics = plan_metrics(
+		plan, progressHistory, profilerBefore, planningTime,
+		currentRequest ? currentRequest->description : std::string());
+	pub_planner_metrics_->publish(metrics);
 
 	if (!plan.bestNodeId.has_value())
 	{
@@ -817,14 +2397,6 @@ TPS_Astar_Planner_Node::PlanResult TPS_Astar_Planner_Node::do_path_plan(
 		planner_->costEvaluators_.clear();
 	}
 
-	// backtrack:
-	auto [plannedPath, pathEdges] =
-		plan.motionTree.backtrack_path(*plan.bestNodeId);
-
-#if 0  // JLBC: disabled to check if this is causing troubles
-mpp::refine_trajectory(plannedPath, pathEdges, planner_input.ptgs);
-#endif
-
 	// Show plan in a GUI for debugging
 	if (plan.success && gui_mrpt_)
 	{
@@ -839,122 +2411,374 @@ mpp::refine_trajectory(plannedPath, pathEdges, planner_input.ptgs);
 		mpp::viz_nav_plan(plan, vizOpts, planner_->costEvaluators_);
 	}
 
-	// Interpolate so we have many waypoints:
-	mpp::trajectory_t interpPath;
-	if (plan.success)
-	{
-		const double interpPeriod = 0.25;  // [s]
-
-		interpPath = mpp::plan_to_trajectory(pathEdges, pi.ptgs, interpPeriod);
-
-		// Note: trajectory is in local frame of reference
-		// of plan.originalInput.stateStart.pose
-		// so, correct that relative pose so we keep everything in global
-		// frame:
-		const auto& startPose = plan.originalInput.stateStart.pose;
-		for (auto& kv : interpPath)
-			kv.second.state.pose = startPose + kv.second.state.pose;
-	}
-
 	// Prepare return data:
 	PlanResult res;
 	res.valid = plan.success;
 	res.plan_output = plan;
+	res.obstacleVersions = std::move(obstacleVersions);
+	res.metrics = metrics;
 
 	if (plan.success)
 	{
-		for (auto& kv : interpPath)
+		res.path = path_to_poses(
+			plan.motionTree, *plan.bestNodeId, plan.originalInput);
+		res.wps = poses_to_waypoints(res.path, goal);
+	}
+	else if (anytime)
+	{
+		// Deadline reached: return the best partial path, if any.
+		res.path = path_to_poses(
+			plan.motionTree, *plan.bestNodeId, plan.originalInput);
+		res.wps = poses_to_waypoints(res.path, std::nullopt);
+		res.partial = !res.wps.waypoints.empty();
+	}
+
+	return res;
+}
+
+void TPS_Astar_Planner_Node::refine_path(
+	PlanResult& res, const mrpt::math::TPose2D& goal)
+{
+	const auto tStart = mrpt::Clock::now();
+	const auto origParams = planner_->params_as_yaml();
+	double resXY = origParams["grid_resolution_xy"].as<double>();
+	double resYaw = origParams["grid_resolution_yaw"].as<double>();
+
+	// Same obstacles, but the path may come from a planner variant:
+	mpp::PlannerInput pi = res.plan_output.originalInput;
+	pi.ptgs = ptgs_;
+
+	planner_->progressCallback_ = [this](const mpp::ProgressCallbackData&)
+	{ check_plan_canceled(); };
+
+	auto restoreParams = [&]()
+	{
+		planner_->params_from_yaml(origParams);
+		planner_->progressCallback_ = {};
+	};
+
+	try
+	{
+		for (int i = 0; i < anytime_max_refinements_; i++)
 		{
-			const auto& goal_state = kv.second.state;
+			const double remaining = anytime_refinement_time_budget_ -
+				mrpt::system::timeDifference(tStart, mrpt::Clock::now());
+			if (remaining <= 0) break;
+
+			resXY *= 0.5;
+			resYaw *= 0.5;
+			auto c = origParams;
+			c["grid_resolution_xy"] = resXY;
+			c["grid_resolution_yaw"] = resYaw;
+			c["maximumComputationTime"] = remaining;
+			planner_->params_from_yaml(c);
+
+			mpp::PlannerOutput refined = planner_->plan(pi);
+			if (!refined.success || !refined.bestNodeId ||
+				refined.pathCost >= res.plan_output.pathCost)
+				continue;
+
+			RCLCPP_INFO_STREAM(
+				this->get_logger(),
+				"[anytime] Refined path cost: "
+					<< res.plan_output.pathCost << " -> " << refined.pathCost
+					<< " (lattice resolution " << resXY << " m)");
+
+			res.plan_output = std::move(refined);
+			res.path = path_to_poses(
+				res.plan_output.motionTree, *res.plan_output.bestNodeId,
+				res.plan_output.originalInput);
+			res.wps = poses_to_waypoints(res.path, goal);
+			publish_waypoint_sequence(res.wps);
+		}
+	}
+	catch (...)
+	{
+		restoreParams();
+		throw;
+	}
+	restoreParams();
+}
+
+std::vector<mrpt::math::TPose2D> TPS_Astar_Planner_Node::path_to_poses(
+	const mpp::MotionPrimitivesTreeSE2& tree, mrpt::graphs::TNodeID node,
+	const mpp::PlannerInput& pi)
+{
+	std::vector<mrpt::math::TPose2D> poses;
+
+	// backtrack:
+	auto [plannedPath, pathEdges] = tree.backtrack_path(node);
+	if (pathEdges.empty()) return poses;
+
+#if 0  // JLBC: disabled to check if this is causing troubles
+mpp::refine_trajectory(plannedPath, pathEdges, planner_input.ptgs);
+#endif
+
+	// Interpolate so we have many waypoints:
+	const double interpPeriod = 0.25;  // [s]
+
+	const mpp::trajectory_t interpPath =
+		mpp::plan_to_trajectory(pathEdges, pi.ptgs, interpPeriod);
+
+	// Note: trajectory is in local frame of reference
+	// of pi.stateStart.pose
+	// so, correct that relative pose so we keep everything in global
+	// frame:
+	const auto& startPose = pi.stateStart.pose;
+	for (const auto& kv : interpPath)
+		poses.push_back(startPose + kv.second.state.pose);
+
+	return poses;
+}
+
+mrpt_msgs::msg::WaypointSequence TPS_Astar_Planner_Node::poses_to_waypoints(
+	const std::vector<mrpt::math::TPose2D>& poses,
+	const std::optional<mrpt::math::TPose2D>& goal)
+{
+	mrpt_msgs::msg::WaypointSequence wps;
+
+	for (const auto& pose : poses)
+	{
 #if 0
-			std::cout << "Waypoint: x = " << goal_state.pose.x
-					  << ", y= " << goal_state.pose.y << std::endl;
+		std::cout << "Waypoint: x = " << pose.x << ", y= " << pose.y
+				  << std::endl;
 #endif
-			auto wp_msg = mrpt_msgs::msg::Waypoint();
-			wp_msg.target = mrpt::ros2bridge::toROS_Pose(goal_state.pose);
+		auto wp_msg = mrpt_msgs::msg::Waypoint();
+		wp_msg.target = mrpt::ros2bridge::toROS_Pose(pose);
 
-			wp_msg.allowed_distance = mid_waypoints_allowed_distance_;
-			wp_msg.allow_skip = mid_waypoints_allow_skip_;
-			wp_msg.ignore_heading = mid_waypoints_ignore_heading_;
+		wp_msg.allowed_distance = mid_waypoints_allowed_distance_;
+		wp_msg.allow_skip = mid_waypoints_allow_skip_;
+		wp_msg.ignore_heading = mid_waypoints_ignore_heading_;
 
-			res.wps.waypoints.push_back(wp_msg);
-		}
+		wps.waypoints.push_back(wp_msg);
+	}
 
+	if (goal)
+	{
 		auto wp_msg = mrpt_msgs::msg::Waypoint();
-		wp_msg.target = mrpt::ros2bridge::toROS_Pose(goal);
+		wp_msg.target = mrpt::ros2bridge::toROS_Pose(*goal);
+		wps.waypoints.push_back(wp_msg);
+	}
 
+	// The last waypoint (the goal, or the end of a partial path) must be
+	// reached:
+	if (!wps.waypoints.empty())
+	{
+		auto& wp_msg = wps.waypoints.back();
 		wp_msg.allowed_distance = final_waypoint_allowed_distance_;
 		wp_msg.allow_skip = final_waypoint_allow_skip_;
 		wp_msg.ignore_heading = final_waypoint_ignore_heading_;
-
-		res.wps.waypoints.push_back(wp_msg);
-
-		res.wps.header.frame_id = frame_id_map_;
-		res.wps.header.stamp = this->now();
 	}
 
-	return res;
+	wps.header.frame_id = frame_id_map_;
+	wps.header.stamp = this->now();
+
+	return wps;
 }
 
 void TPS_Astar_Planner_Node::srv_make_plan_to(
-	const std::shared_ptr<mrpt_nav_interfaces::srv::MakePlanTo::Request> req,
-	std::shared_ptr<mrpt_nav_interfaces::srv::MakePlanTo::Response> resp)
+	const std::shared_ptr<rmw_request_id_t>& header,
+	const std::shared_ptr<mrpt_nav_interfaces::srv::MakePlanTo::Request>& req)
 {
 	try
 	{
 		const auto p = mrpt::ros2bridge::fromROS(req->target.pose);
-		const auto nav_goal = mrpt::math::TPose2D(p.asTPose());
 
-		mrpt::poses::CPose3D robot_pose;
-		const bool robot_pose_ok =
-			wait_for_transform(robot_pose, frame_id_robot_, frame_id_map_);
-
-		ASSERT_(robot_pose_ok);
-
-		const auto start_pose = mrpt::poses::CPose2D(robot_pose).asTPose();
-
-		const auto res = do_path_plan(start_pose, nav_goal);
-
-		resp->valid_path_found = res.valid;
-		resp->waypoints = res.wps;
+		auto r = std::make_shared<PlanRequest>();
+		r->goal = mrpt::math::TPose2D(p.asTPose());
+		r->timeBudget =
+			req->time_budget > 0 ? req->time_budget : planning_time_budget_;
+		r->description = "make_plan_to service";
+		r->onDone = [this, header](const PlanResult* res)
+		{
+			mrpt_nav_interfaces::srv::MakePlanTo::Response resp;
+			resp.valid_path_found = res && res->valid;
+			if (res) resp.waypoints = res->wps;
+			if (res) resp.metrics = res->metrics;
+			srvMakePlanTo_->send_response(*header, resp);
+		};
+
+		enqueue_plan_request(r);
 	}
 	catch (const std::exception& e)
 	{
 		RCLCPP_ERROR(
 			this->get_logger(), "Exception in srv_make_plan_to: %s", e.what());
+
+		mrpt_nav_interfaces::srv::MakePlanTo::Response resp;
+		srvMakePlanTo_->send_response(*header, resp);
 	}
 }
 
 void TPS_Astar_Planner_Node::srv_make_plan_from_to(
-	const std::shared_ptr<mrpt_nav_interfaces::srv::MakePlanFromTo::Request>
-		req,
-	std::shared_ptr<mrpt_nav_interfaces::srv::MakePlanFromTo::Response> resp)
+	const std::shared_ptr<rmw_request_id_t>& header,
+	const std::shared_ptr<mrpt_nav_interfaces::srv::MakePlanFromTo::Request>&
+		req)
 {
 	try
 	{
 		const auto p = mrpt::ros2bridge::fromROS(req->target);
-		const auto nav_goal = mrpt::math::TPose2D(p.asTPose());
+		const auto pStart = mrpt::ros2bridge::fromROS(req->start);
+
+		auto r = std::make_shared<PlanRequest>();
+		r->start = mrpt::math::TPose2D(pStart.asTPose());
+		r->goal = mrpt::math::TPose2D(p.asTPose());
+		r->timeBudget =
+			req->time_budget > 0 ? req->time_budget : planning_time_budget_;
+		r->description = "make_plan_from_to service";
+		r->onDone = [this, header](const PlanResult* res)
+		{
+			mrpt_nav_interfaces::srv::MakePlanFromTo::Response resp;
+			resp.valid_path_found = res && res->valid;
+			if (res) resp.waypoints = res->wps;
+			if (res) resp.metrics = res->metrics;
+			srvMakePlanFromTo_->send_response(*header, resp);
+		};
+
+		enqueue_plan_request(r);
+	}
+	catch (const std::exception& e)
+	{
+		RCLCPP_ERROR(
+			this->get_logger(), "Exception in srv_make_plan_from_to: %s",
+			e.what());
 
-		mrpt::poses::CPose3D robot_pose;
-		const bool robot_pose_ok =
-			wait_for_transform(robot_pose, frame_id_robot_, frame_id_map_);
+		mrpt_nav_interfaces::srv::MakePlanFromTo::Response resp;
+		srvMakePlanFromTo_->send_response(*header, resp);
+	}
+}
 
-		ASSERT_(robot_pose_ok);
+void TPS_Astar_Planner_Node::srv_make_plans_from_to(
+	const std::shared_ptr<rmw_request_id_t>& header,
+	const std::shared_ptr<mrpt_nav_interfaces::srv::MakePlansFromTo::Request>&
+		req)
+{
+	try
+	{
+		const auto pStart = mrpt::ros2bridge::fromROS(req->start);
 
-		const auto start_pose = mrpt::poses::CPose2D(robot_pose).asTPose();
+		auto r = std::make_shared<PlanRequest>();
+		r->start = mrpt::math::TPose2D(pStart.asTPose());
+		for (const auto& target : req->targets)
+		{
+			const auto p = mrpt::ros2bridge::fromROS(target);
+			r->batchGoals.push_back(mrpt::math::TPose2D(p.asTPose()));
+		}
+		ASSERT_(!r->batchGoals.empty());
 
-		const auto res = do_path_plan(start_pose, nav_goal);
+		r->timeBudget = req->time_budget;
+		r->description = "make_plans_from_to service";
 
-		resp->valid_path_found = res.valid;
-		resp->waypoints = res.wps;
+		const size_t N = r->batchGoals.size();
+		r->onBatchDone = [this, header, N](const BatchPlanResult* res)
+		{
+			mrpt_nav_interfaces::srv::MakePlansFromTo::Response resp;
+			resp.valid_path_found.resize(N, false);
+			resp.waypoints.resize(N);
+			resp.costs.resize(N, 0);
+			if (res)
+			{
+				for (size_t i = 0; i < N; i++)
+				{
+					const auto& g = res->goals.at(i);
+					resp.valid_path_found[i] = g.valid;
+					resp.waypoints[i] = g.wps;
+					resp.costs[i] = g.cost;
+				}
+				resp.searches = res->searches;
+			}
+			srvMakePlansFromTo_->send_response(*header, resp);
+		};
+
+		enqueue_plan_request(r);
 	}
 	catch (const std::exception& e)
 	{
 		RCLCPP_ERROR(
-			this->get_logger(), "Exception in srv_make_plan_to: %s", e.what());
+			this->get_logger(), "Exception in srv_make_plans_from_to: %s",
+			e.what());
+
+		mrpt_nav_interfaces::srv::MakePlansFromTo::Response resp;
+		srvMakePlansFromTo_->send_response(*header, resp);
 	}
 }
 
+// ACTION INTERFACE: MakePlan
+// --------------------------------------
+rclcpp_action::GoalResponse TPS_Astar_Planner_Node::handle_goal_make_plan(
+	const rclcpp_action::GoalUUID& uuid,
+	std::shared_ptr<const MakePlan::Goal> goal)
+{
+	RCLCPP_INFO_STREAM(
+		get_logger(), "[MakePlan] Received request for: "
+						  << mrpt::ros2bridge::fromROS(goal->target.pose));
+	(void)uuid;
+	return rclcpp_action::GoalResponse::ACCEPT_AND_EXECUTE;
+}
+
+rclcpp_action::CancelResponse TPS_Astar_Planner_Node::handle_cancel_make_plan(
+	const std::shared_ptr<HandleMakePlan> goal_handle)
+{
+	RCLCPP_INFO(
+		this->get_logger(), "[MakePlan] Received request to cancel goal");
+	(void)goal_handle;
+	// The planner polls goal_handle->is_canceling() while planning, and
+	// drops canceled goals still waiting in the queue.
+	return rclcpp_action::CancelResponse::ACCEPT;
+}
+
+void TPS_Astar_Planner_Node::handle_accepted_make_plan(
+	const std::shared_ptr<HandleMakePlan> goal_handle)
+{
+	const auto goal = goal_handle->get_goal();
+
+	auto r = std::make_shared<PlanRequest>();
+	if (goal->use_start)
+		r->start = mrpt::math::TPose2D(
+			mrpt::ros2bridge::fromROS(goal->start).asTPose());
+	r->goal = mrpt::math::TPose2D(
+		mrpt::ros2bridge::fromROS(goal->target.pose).asTPose());
+	r->timeBudget =
+		goal->time_budget > 0 ? goal->time_budget : planning_time_budget_;
+	r->description = "make_plan action";
+
+	r->isCanceled = [goal_handle]() { return goal_handle->is_canceling(); };
+
+	// Feedback, at most every 0.1 s:
+	const auto tStart = mrpt::Clock::now();
+	auto lastFeedback = std::make_shared<mrpt::Clock::time_point>();
+	r->onProgress = [goal_handle, tStart, lastFeedback](
+						const mpp::ProgressCallbackData& pcd)
+	{
+		const auto tNow = mrpt::Clock::now();
+		if (mrpt::system::timeDifference(*lastFeedback, tNow) < 0.1) return;
+		*lastFeedback = tNow;
+
+		auto feedback = std::make_shared<MakePlan::Feedback>();
+		feedback->elapsed_time = mrpt::system::timeDifference(tStart, tNow);
+		feedback->best_cost_to_goal = pcd.bestCostToGoal;
+		feedback->best_path_nodes = pcd.bestPath.size();
+		goal_handle->publish_feedback(feedback);
+	};
+
+	r->onDone = [goal_handle](const PlanResult* res)
+	{
+		auto result = std::make_shared<MakePlan::Result>();
+		result->valid_path_found = res && res->valid;
+		if (res) result->waypoints = res->wps;
+		if (res) result->metrics = res->metrics;
+
+		if (goal_handle->is_canceling())
+			goal_handle->canceled(result);
+		else if (result->valid_path_found)
+			goal_handle->succeed(result);
+		else
+			goal_handle->abort(result);
+	};
+
+	enqueue_plan_request(r);
+}
+
 // ------------------------------------
 int main(int argc, char** argv)
 {
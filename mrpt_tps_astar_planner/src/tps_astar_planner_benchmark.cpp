@@ -0,0 +1,467 @@
+/* +------------------------------------------------------------------------+
+   |                             mrpt_navigation                            |
+   |                                                                        |
+   | Copyright (c) 2014-2024, Individual contributors, see commit authors   |
+   | See: https://github.com/mrpt-ros-pkg/mrpt_navigation                   |
+   | All rights reserved. Released under BSD 3-Clause license. See LICENSE  |
+   +------------------------------------------------------------------------+ */
+
+/* Offline benchmark for the TPS-A* planner.
+ *
+ * Runs a seeded batch of random, feasible start/goal queries on one or more
+ * occupancy grid maps, with the same planner, PTG and costmap configuration
+ * files than the ROS 2 node, and reports the planning time percentiles,
+ * search tree size, path cost and success rate.
+ *
+ * Queries are feasible in the sense that both start and goal are at a
+ * distance larger than the robot radius from any obstacle, and connected
+ * through cells with that clearance.
+ *
+ * Example:
+ *  tps_astar_planner_benchmark \
+ *    -m mrpt_tps_astar_planner/path-planner-sandbox/ \
+ *    -p mrpt_tps_astar_planner/configs/params/planner-params.yaml \
+ *    -c mrpt_tps_astar_planner/configs/ini/ptgs_jackal.ini \
+ *    --costmap mrpt_tps_astar_planner/configs/params/costmap-obstacles.yaml \
+ *    --queries 50 --json results.json
+ */
+
+#include <mpp/algos/TPS_Astar.h>
+#include <mpp/data/TrajectoriesAndRobotShape.h>
+#include <mrpt/3rdparty/tclap/CmdLine.h>
+#include <mrpt/config/CConfigFile.h>
+#include <mrpt/containers/yaml.h>
+#include <mrpt/core/exceptions.h>
+#include <mrpt/core/format.h>
+#include <mrpt/maps/COccupancyGridMap2D.h>
+#include <mrpt/maps/CSimplePointsMap.h>
+#include <mrpt/system/CTicTac.h>
+#include <mrpt_nav_common/benchmark_report.hpp>
+#include <mrpt_tps_astar_planner/mrpt_tps_astar_planner_core.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <filesystem>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <vector>
+
+using namespace mrpt_tps_astar_planner;
+using namespace mrpt_nav_common::benchmark;
+
+// CLI flags:
+static TCLAP::CmdLine cmd(
+	"tps_astar_planner_benchmark", ' ', MRPT_getVersion().c_str());
+
+static TCLAP::MultiArg<std::string> arg_maps(
+	"m", "map",
+	"World map, as a ROS map_server YAML file, or a directory to use all "
+	"the map YAML files in it. Can be given several times.",
+	true, "map.yaml", cmd);
+
+static TCLAP::ValueArg<std::string> arg_planner_params(
+	"p", "planner-parameters", "Planner parameters file (*.yaml)", true, "",
+	"planner-params.yaml", cmd);
+
+static TCLAP::ValueArg<std::string> arg_ptg_ini(
+	"c", "ptg-ini", "PTG configuration file (*.ini)", true, "",
+	"ptgs.ini", cmd);
+
+static TCLAP::ValueArg<std::string> arg_costmap_params(
+	"", "costmap",
+	"Costmap parameters file (*.yaml). If not given, no costmap is used.",
+	false, "", "costmap-obstacles.yaml", cmd);
+
+static TCLAP::ValueArg<unsigned int> arg_queries(
+	"", "queries", "Number of random queries per map (Default: 20)", false,
+	20, "20", cmd);
+
+static TCLAP::ValueArg<unsigned int> arg_seed(
+	"", "seed", "Random queries generator seed (Default: 1)", false, 1, "1",
+	cmd);
+
+static TCLAP::ValueArg<double> arg_min_goal_distance(
+	"", "min-goal-distance",
+	"Minimum distance [m] between start and goal of queries (Default: 3.0)",
+	false, 3.0, "3.0", cmd);
+
+static TCLAP::ValueArg<double> arg_extra_clearance(
+	"", "extra-clearance",
+	"Clearance [m] to obstacles of start and goal, besides the robot "
+	"radius (Default: 0.1)",
+	false, 0.1, "0.1", cmd);
+
+static TCLAP::ValueArg<std::string> arg_json(
+	"", "json", "Optional output file to save the results as JSON", false, "",
+	"results.json", cmd);
+
+static TCLAP::ValueArg<double> arg_max_p95(
+	"", "max-p95-ms",
+	"Maximum 95% percentile [ms] of the planning time over all maps. If "
+	"given, exit with code 2 when it is exceeded.",
+	false, 0.0, "0.0", cmd);
+
+static TCLAP::ValueArg<double> arg_min_success_rate(
+	"", "min-success-rate",
+	"Minimum ratio [0,1] of queries, over all maps, for which a path must "
+	"be found. If given, exit with code 2 when fewer are.",
+	false, 0.0, "0.0", cmd);
+
+namespace
+{
+struct Query
+{
+	mrpt::math::TPose2D start, goal;
+};
+
+struct QueryResult
+{
+	bool success = false;
+	double planningTime = 0;  //!< [s]
+	double costmapTime = 0;	 //!< Obstacles and costmaps [s]
+	size_t treeNodes = 0;  //!< Final search tree size
+	double pathCost = 0;
+};
+
+struct MapResults
+{
+	std::string map;
+	std::vector<QueryResult> results;
+
+	double success_rate() const
+	{
+		size_t n = 0;
+		for (const auto& r : results) n += r.success ? 1 : 0;
+		return results.empty() ? 0 : static_cast<double>(n) / results.size();
+	}
+
+	template <typename F>
+	Summary summary(F&& field, bool onlySuccessful) const
+	{
+		std::vector<double> v;
+		for (const auto& r : results)
+			if (r.success || !onlySuccessful) v.push_back(field(r));
+		return Summary(std::move(v));
+	}
+};
+
+/// The map YAML files given in the command line, expanding directories.
+std::vector<std::string> list_map_files()
+{
+	namespace fs = std::filesystem;
+
+	std::vector<std::string> files;
+	for (const auto& m : arg_maps.getValue())
+	{
+		if (!fs::is_directory(m))
+		{
+			files.push_back(m);
+			continue;
+		}
+		// Directories also hold configuration YAML files, only take maps:
+		std::vector<std::string> dirFiles;
+		for (const auto& e : fs::directory_iterator(m))
+		{
+			if (!e.is_regular_file() || e.path().extension() != ".yaml")
+				continue;
+			const auto y = mrpt::containers::yaml::FromFile(e.path().string());
+			if (y.isMap() && y.has("image"))
+				dirFiles.push_back(e.path().string());
+		}
+		std::sort(dirFiles.begin(), dirFiles.end());
+		files.insert(files.end(), dirFiles.begin(), dirFiles.end());
+	}
+	return files;
+}
+
+/** Random queries between free cells of the same connected region, with
+ * enough clearance to obstacles for the robot. */
+std::vector<Query> random_queries(
+	const mrpt::maps::COccupancyGridMap2D& grid,
+	const mrpt::maps::CPointsMap& obstacles, double minClearance,
+	size_t count, std::mt19937& rng)
+{
+	const int nx = static_cast<int>(grid.getSizeX());
+	const int ny = static_cast<int>(grid.getSizeY());
+	const float minClearance2 = mrpt::square(minClearance);
+
+	// Label the connected regions of cells the robot fits in:
+	std::vector<int> region(nx * ny, -1);
+	std::vector<bool> fits(nx * ny, false);
+	for (int cy = 0; cy < ny; cy++)
+		for (int cx = 0; cx < nx; cx++)
+		{
+			// Grid cells store the probability of being free:
+			if (grid.getCell(cx, cy) <= 0.5f) continue;
+			fits[cx + cy * nx] = obstacles.empty() ||
+				obstacles.kdTreeClosestPoint2DsqrError(
+					grid.idx2x(cx), grid.idx2y(cy)) > minClearance2;
+		}
+
+	std::vector<int> freeCells;
+	int nRegions = 0;
+	for (int i = 0; i < nx * ny; i++)
+	{
+		if (!fits[i]) continue;
+		freeCells.push_back(i);
+		if (region[i] >= 0) continue;
+
+		std::deque<int> q = {i};
+		region[i] = nRegions;
+		while (!q.empty())
+		{
+			const int c = q.front();
+			q.pop_front();
+			const int cx = c % nx, cy = c / nx;
+			const int neighbors[4][2] = {
+				{cx - 1, cy}, {cx + 1, cy}, {cx, cy - 1}, {cx, cy + 1}};
+			for (const auto& n : neighbors)
+			{
+				if (n[0] < 0 || n[1] < 0 || n[0] >= nx || n[1] >= ny)
+					continue;
+				const int nc = n[0] + n[1] * nx;
+				if (!fits[nc] || region[nc] >= 0) continue;
+				region[nc] = nRegions;
+				q.push_back(nc);
+			}
+		}
+		nRegions++;
+	}
+	ASSERTMSG_(!freeCells.empty(), "No free space in the map for the robot");
+
+	std::uniform_int_distribution<size_t> rCell(0, freeCells.size() - 1);
+	std::uniform_real_distribution<double> rphi(-M_PI, M_PI);
+	auto cellPose = [&](int c)
+	{
+		return mrpt::math::TPose2D(
+			grid.idx2x(c % nx), grid.idx2y(c / nx), rphi(rng));
+	};
+
+	std::vector<Query> queries;
+	for (size_t attempts = 0; queries.size() < count; attempts++)
+	{
+		ASSERTMSG_(
+			attempts < 1000 * count,
+			"Could not find enough feasible queries, try a smaller "
+			"--min-goal-distance");
+
+		const int c0 = freeCells[rCell(rng)], c1 = freeCells[rCell(rng)];
+		if (region[c0] != region[c1]) continue;
+
+		Query qr;
+		qr.start = cellPose(c0);
+		qr.goal = cellPose(c1);
+		if ((qr.goal.translation() - qr.start.translation()).norm() <
+			arg_min_goal_distance.getValue())
+			continue;
+		queries.push_back(qr);
+	}
+	return queries;
+}
+
+QueryResult run_query(
+	const Query& q, mpp::TPS_Astar& planner,
+	const mpp::TrajectoriesAndRobotShape& ptgs, ObstacleSourceCache& sources,
+	bool useCostmaps)
+{
+	QueryResult r;
+
+	mpp::PlannerInput pi;
+	pi.ptgs = ptgs;
+	pi.stateStart.pose = q.start;
+	pi.stateStart.vel = {0, 0, 0};
+	pi.stateGoal.state = q.goal;
+
+	// Obstacles and world bounding box, as in the planner node:
+	mrpt::system::CTicTac tictac;
+	auto bbox = mrpt::math::TBoundingBoxf::PlusMinusInfinity();
+	planner.costEvaluators_.clear();
+	for (const auto& d : sources.get_all(q.start))
+	{
+		pi.obstacles.emplace_back(d->obstacleSource);
+		bbox = bbox.unionWith(d->bbox);
+		if (useCostmaps) planner.costEvaluators_.push_back(d->costmap);
+	}
+	r.costmapTime = tictac.Tac();
+
+	const auto bboxMargin = mrpt::math::TPoint3Df(2.0, 2.0, .0);
+	for (const auto& p : {q.start, q.goal})
+	{
+		const auto pt = mrpt::math::TPoint3Df(p.x, p.y, 0);
+		bbox.updateWithPoint(pt - bboxMargin);
+		bbox.updateWithPoint(pt + bboxMargin);
+	}
+	pi.worldBboxMax = {bbox.max.x, bbox.max.y, M_PI};
+	pi.worldBboxMin = {bbox.min.x, bbox.min.y, -M_PI};
+
+	tictac.Tic();
+	const mpp::PlannerOutput plan = planner.plan(pi);
+	r.planningTime = tictac.Tac();
+
+	r.success = plan.success;
+	r.treeNodes = plan.motionTree.nodes().size();
+	r.pathCost = plan.success ? plan.pathCost : 0;
+	return r;
+}
+
+}  // namespace
+
+int main(int argc, char** argv)
+{
+	try
+	{
+		if (!cmd.parse(argc, argv)) return 1;
+
+		const auto mapFiles = list_map_files();
+		ASSERTMSG_(!mapFiles.empty(), "No map files found");
+
+		// Planner and PTGs, as in the planner node:
+		auto planner = mpp::TPS_Astar::Create();
+		planner->params_from_yaml(
+			mrpt::containers::yaml::FromFile(arg_planner_params.getValue()));
+
+		mpp::TrajectoriesAndRobotShape ptgs;
+		{
+			mrpt::config::CConfigFile cfg(arg_ptg_ini.getValue());
+			ptgs.initFromConfigFile(cfg, "SelfDriving");
+		}
+		ASSERT_(!ptgs.ptgs.empty());
+
+		double robotRadius = 0;
+		for (const auto& ptg : ptgs.ptgs)
+			robotRadius = std::max(robotRadius, ptg->getMaxRobotRadius());
+
+		const bool useCostmaps = arg_costmap_params.isSet();
+
+		std::mt19937 rng(arg_seed.getValue());
+		std::vector<MapResults> allMaps;
+		mrpt::system::CTicTac wallClock;
+
+		for (const auto& mapFile : mapFiles)
+		{
+			mrpt::maps::COccupancyGridMap2D grid;
+			if (!grid.loadFromROSMapServerYAML(mapFile))
+			{
+				std::cerr << "Error loading map: " << mapFile << "\n";
+				return 1;
+			}
+
+			auto obstacles = mrpt::maps::CSimplePointsMap::Create();
+			grid.getAsPointCloud(*obstacles);
+
+			ObstacleSourceCache sources;
+			sources.params.background_build = false;
+			sources.params.build_costmaps = useCostmaps;
+			if (useCostmaps)
+				sources.set_costmap_parameters(
+					mpp::CostEvaluatorCostMap::Parameters::FromYAML(
+						mrpt::containers::yaml::FromFile(
+							arg_costmap_params.getValue())));
+			sources.update_source("map", obstacles);
+
+			const auto queries = random_queries(
+				grid, *obstacles, robotRadius + arg_extra_clearance.getValue(),
+				arg_queries.getValue(), rng);
+
+			std::cout << "Map: " << mapFile << " (" << obstacles->size()
+					  << " obstacle points)\n";
+
+			auto& mr = allMaps.emplace_back();
+			mr.map = mapFile;
+			for (size_t i = 0; i < queries.size(); i++)
+			{
+				const auto& q = queries[i];
+				const auto r =
+					run_query(q, *planner, ptgs, sources, useCostmaps);
+				mr.results.push_back(r);
+
+				std::cout << mrpt::format(
+					"[%3zu/%3zu] %s -> %s: %s time=%.01fms tree=%zu "
+					"cost=%.02f\n",
+					i + 1, queries.size(), q.start.asString().c_str(),
+					q.goal.asString().c_str(), r.success ? "OK  " : "FAIL",
+					1e3 * r.planningTime, r.treeNodes, r.pathCost);
+			}
+		}
+		const double wallTime = wallClock.Tac();
+
+		// Report:
+		// -----------------------------------------------
+		auto planningTime = [](const QueryResult& r) { return r.planningTime; };
+		auto costmapTime = [](const QueryResult& r) { return r.costmapTime; };
+		auto treeNodes = [](const QueryResult& r)
+		{ return static_cast<double>(r.treeNodes); };
+		auto pathCost = [](const QueryResult& r) { return r.pathCost; };
+
+		MapResults overall;
+		overall.map = "all";
+		for (const auto& mr : allMaps)
+			overall.results.insert(
+				overall.results.end(), mr.results.begin(), mr.results.end());
+
+		auto mapAsJSON = [&](const MapResults& mr)
+		{
+			JSONObject o;
+			o.add("map", mr.map)
+				.add("queries", mr.results.size())
+				.add("success_rate", mr.success_rate())
+				.add("planning_time_ms",
+					 mr.summary(planningTime, false).asJSON(1e3))
+				.add("costmap_time_ms",
+					 mr.summary(costmapTime, false).asJSON(1e3))
+				.add("tree_nodes", mr.summary(treeNodes, false).asJSON())
+				.add("path_cost", mr.summary(pathCost, true).asJSON());
+			return o;
+		};
+
+		const auto overallTime = overall.summary(planningTime, false);
+		std::cout << mrpt::format(
+			"\nQueries: %zu  Success rate: %.01f%%\n"
+			"Planning time [ms]: %s\n"
+			"Tree nodes: mean=%.01f  Path cost: mean=%.02f\n"
+			"Wall clock: %.01fs\n",
+			overall.results.size(), 100.0 * overall.success_rate(),
+			overallTime.asString(1e3, 1).c_str(),
+			overall.summary(treeNodes, false).mean,
+			overall.summary(pathCost, true).mean, wallTime);
+
+		if (arg_json.isSet())
+		{
+			std::vector<JSONObject> maps;
+			for (const auto& mr : allMaps) maps.push_back(mapAsJSON(mr));
+
+			JSONObject report;
+			report.add("planner_parameters", arg_planner_params.getValue())
+				.add("ptg_ini", arg_ptg_ini.getValue())
+				.add("costmap", arg_costmap_params.getValue())
+				.add("seed", arg_seed.getValue())
+				.add("overall", mapAsJSON(overall))
+				.add("maps", maps)
+				.add("wall_time_s", wallTime);
+
+			if (!report.saveToFile(arg_json.getValue()))
+			{
+				std::cerr << "Error writing to: " << arg_json.getValue()
+						  << "\n";
+				return 1;
+			}
+		}
+
+		RegressionGates gates;
+		gates.checkAtMost(
+			"p95 planning time", 1e3 * overallTime.p95,
+			arg_max_p95.getValue(), "ms");
+		gates.checkAtLeast(
+			"success rate", overall.success_rate(),
+			arg_min_success_rate.getValue());
+		return gates.exitCode();
+	}
+	catch (const std::exception& e)
+	{
+		std::cerr << "Exit due to exception:\n"
+				  << mrpt::exception_to_str(e) << std::endl;
+		return 1;
+	}
+}
@@ -0,0 +1,370 @@
+/* +------------------------------------------------------------------------+
+   |                             mrpt_navigation                            |
+   |                                                                        |
+   | Copyright (c) 2014-2024, Individual contributors, see commit authors   |
+   | See: https://github.com/mrpt-ros-pkg/mrpt_navigation                   |
+   | All rights reserved. Released under BSD 3-Clause license. See LICENSE  |
+   +------------------------------------------------------------------------+ */
+
+#include <gtest/gtest.h>
+#include <mrpt/maps/CSimplePointsMap.h>
+#include <mrpt_tps_astar_planner/mrpt_tps_astar_planner_core.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <thread>
+
+using mrpt_tps_astar_planner::ObstacleSourceCache;
+
+namespace
+{
+mrpt::maps::CPointsMap::Ptr make_wall(float x)
+{
+	auto pts = mrpt::maps::CSimplePointsMap::Create();
+	for (float y = -2.0f; y <= 2.0f; y += 0.1f) pts->insertPoint(x, y, 0);
+	return pts;
+}
+}  // namespace
+
+TEST(ObstacleSourceCache, RebuildOnlyOnChanges)
+{
+	for (const bool background : {false, true})
+	{
+		ObstacleSourceCache cache;
+		cache.params.background_build = background;
+		cache.params.costmap_reuse_distance = 1.0;
+
+		EXPECT_EQ(cache.update_source("map", make_wall(3.0f)), 1U);
+		EXPECT_EQ(cache.update_source("obs", make_wall(5.0f)), 1U);
+
+		// First plan: both costmaps must be built.
+		auto all = cache.get_all({0, 0, 0});
+		ASSERT_EQ(all.size(), 2U);
+		EXPECT_EQ(all[0]->sourceName, "map");
+		EXPECT_TRUE(all[0]->costmap);
+		EXPECT_EQ(cache.stats().sourceBuilds, 2U);
+		EXPECT_EQ(cache.stats().costmapBuilds, 2U);
+
+		// Nearby start pose, no new data: everything is reused.
+		all = cache.get_all({0.5, 0, 0});
+		EXPECT_EQ(cache.stats().sourceBuilds, 2U);
+		EXPECT_EQ(cache.stats().costmapBuilds, 2U);
+		EXPECT_EQ(cache.stats().costmapHits, 2U);
+
+		// New data for one source only, with a pose hint:
+		EXPECT_EQ(
+			cache.update_source(
+				"obs", make_wall(4.0f), mrpt::math::TPose2D(0.5, 0, 0)),
+			2U);
+		all = cache.get_all({0.5, 0, 0});
+		EXPECT_EQ(all[1]->version, 2U);
+		EXPECT_EQ(cache.stats().sourceBuilds, 3U);
+		EXPECT_EQ(cache.stats().costmapBuilds, 3U);
+		EXPECT_EQ(cache.stats().costmapHits, 4U);
+
+		// Far away start pose: costmaps are rebuilt, obstacles are not.
+		all = cache.get_all({10.0, 0, 0});
+		EXPECT_EQ(cache.stats().sourceBuilds, 3U);
+		EXPECT_EQ(cache.stats().costmapBuilds, 5U);
+		EXPECT_EQ(cache.versions().at("map"), 1U);
+	}
+}
+
+TEST(ObstacleSourceCache, BackToBackBackgroundUpdates)
+{
+	ObstacleSourceCache cache;
+	cache.params.background_build = true;
+
+	// Each update replaces a build that may still be running (this used to
+	// deadlock):
+	const mrpt::math::TPose2D pose(0, 0, 0);
+	for (int i = 0; i < 10; i++)
+		cache.update_source("obs", make_wall(3.0f + 0.1f * i), pose);
+
+	const auto all = cache.get_all(pose);
+	ASSERT_EQ(all.size(), 1U);
+	EXPECT_EQ(all[0]->version, 10U);
+}
+
+TEST(OccupancyGridObstacles, IncrementalMatchesFullConversion)
+{
+	using mrpt_tps_astar_planner::OccupancyGridObstacles;
+
+	OccupancyGridObstacles::GridInfo info;
+	info.width = 40;
+	info.height = 30;
+	info.resolution = 0.1f;
+	info.origin_x = -2.0f;
+	info.origin_y = 1.0f;
+
+	auto sorted_points = [](const mrpt::maps::CPointsMap& pts)
+	{
+		std::vector<std::pair<float, float>> v;
+		for (size_t i = 0; i < pts.size(); i++)
+		{
+			float x, y, z;
+			pts.getPoint(i, x, y, z);
+			v.emplace_back(x, y);
+		}
+		std::sort(v.begin(), v.end());
+		return v;
+	};
+
+	std::vector<int8_t> cells(info.width * info.height, 0);
+	cells[0] = 100;	 // x=-1.95, y=1.05
+
+	OccupancyGridObstacles incremental;
+	auto r = incremental.update(info, cells);
+	EXPECT_TRUE(r.changed);
+	EXPECT_FALSE(r.changedArea.has_value());
+	ASSERT_EQ(r.points->size(), 1U);
+	EXPECT_NEAR(r.points->getPointsBufferRef_x()[0], -1.95f, 1e-4f);
+	EXPECT_NEAR(r.points->getPointsBufferRef_y()[0], 1.05f, 1e-4f);
+
+	// Changes that keep the occupancy do not count:
+	cells[1] = 30;
+	cells[2] = -1;
+	r = incremental.update(info, cells);
+	EXPECT_FALSE(r.changed);
+
+	std::mt19937 rng(1234);
+	for (int iter = 0; iter < 20; iter++)
+	{
+		const auto former = r.points;
+		const auto formerSize = former->size();
+		for (int k = 0; k < 50; k++)
+			cells[rng() % cells.size()] = (rng() % 2) ? 100 : 0;
+
+		r = incremental.update(info, cells);
+		OccupancyGridObstacles full;
+		const auto rFull = full.update(info, cells);
+
+		EXPECT_EQ(sorted_points(*r.points), sorted_points(*rFull.points));
+		// The former points are never modified:
+		EXPECT_EQ(former->size(), formerSize);
+		if (r.changed)
+		{
+			ASSERT_TRUE(r.changedArea.has_value());
+		}
+	}
+}
+
+TEST(ObstacleSourceCache, KeepCostmapOnFarAwayChanges)
+{
+	ObstacleSourceCache cache;
+	cache.params.background_build = false;
+
+	mpp::CostEvaluatorCostMap::Parameters cp;
+	cp.maxRadiusFromRobot = 5.0;
+	cp.preferredClearanceDistance = 0.5;
+	cache.set_costmap_parameters(cp);
+
+	const mrpt::math::TPose2D start(0, 0, 0);
+	cache.update_source("map", make_wall(3.0f), start);
+	const auto former = cache.get_all(start).at(0)->costmap;
+
+	auto area = mrpt::math::TBoundingBoxf::PlusMinusInfinity();
+	area.updateWithPoint({20.0f, 0.0f, 0.0f});
+	cache.update_source("map", make_wall(3.0f), start, area);
+	EXPECT_EQ(cache.get_all(start).at(0)->costmap, former);
+	EXPECT_EQ(cache.stats().costmapsKept, 1U);
+
+	area.updateWithPoint({4.0f, 0.0f, 0.0f});
+	cache.update_source("map", make_wall(3.0f), start, area);
+	EXPECT_NE(cache.get_all(start).at(0)->costmap, former);
+	EXPECT_EQ(cache.stats().costmapsKept, 1U);
+}
+
+TEST(PathChecks, CollisionsAlongPath)
+{
+	using namespace mrpt_tps_astar_planner;
+
+	// A straight path along +X, with poses every 1 m:
+	std::vector<mrpt::math::TPose2D> path;
+	for (int i = 0; i <= 10; i++) path.emplace_back(i, 0, 0);
+
+	EXPECT_EQ(closest_path_pose(path, {3.4, 1.0, 0}), 3U);
+	EXPECT_NEAR(path_length(path, 2, 5), 3.0, 1e-9);
+
+	// Wall far from the path:
+	std::vector<mrpt::maps::CPointsMap::Ptr> obs = {make_wall(20.0f)};
+	EXPECT_FALSE(first_path_collision(path, obs, 0.3).has_value());
+
+	// Wall crossing the segment between poses 4 and 5:
+	obs.push_back(make_wall(4.5f));
+	const auto iCol = first_path_collision(path, obs, 0.3);
+	ASSERT_TRUE(iCol.has_value());
+	EXPECT_EQ(*iCol, 4U);
+}
+
+TEST(PlanningCorridor, CropAndBoundingBox)
+{
+	using namespace mrpt_tps_astar_planner;
+
+	// Start and goal 10 m apart along +X, 1 m margin:
+	const PlanningCorridor corridor({0, 0}, {10, 0}, 1.0);
+
+	EXPECT_TRUE(corridor.contains({5, 0}));
+	EXPECT_TRUE(corridor.contains({-0.9, 0}));
+	EXPECT_FALSE(corridor.contains({-1.1, 0}));
+	EXPECT_FALSE(corridor.contains({5, 4}));
+	EXPECT_TRUE(corridor.contains({5, 4}, 2.0));
+
+	// Semi-axes: a=6, b=sqrt(36-25):
+	const auto bb = corridor.bounding_box();
+	EXPECT_NEAR(bb.min.x, -1.0, 1e-4);
+	EXPECT_NEAR(bb.max.x, 11.0, 1e-4);
+	EXPECT_NEAR(bb.max.y, std::sqrt(11.0), 1e-4);
+	EXPECT_NEAR(bb.min.y, -std::sqrt(11.0), 1e-4);
+
+	// The wall near the goal is partly out of the ellipse, but all of it is
+	// within the search box, so none of it may be dropped:
+	const auto wall = make_wall(10.5f);
+	EXPECT_FALSE(corridor.contains({10.5, 2.0}));
+	EXPECT_EQ(crop_points(*wall, bb)->size(), wall->size());
+
+	// A wall beyond the box is only kept within the extra margin:
+	const auto farWall = make_wall(12.5f);
+	EXPECT_TRUE(crop_points(*farWall, bb)->empty());
+	EXPECT_TRUE(crop_points(*farWall, bb, 1.0)->empty());
+	EXPECT_EQ(crop_points(*farWall, bb, 2.0)->size(), farWall->size());
+}
+
+TEST(PlanCache, HitsRevalidationAndEviction)
+{
+	using namespace mrpt_tps_astar_planner;
+
+	ObstacleSourceCache sources;
+	sources.params.background_build = false;
+
+	PlanCache cache;
+	cache.params.max_entries = 2;
+
+	std::vector<mrpt::math::TPose2D> path;
+	for (int i = 0; i <= 10; i++) path.emplace_back(i, 0, 0);
+	const mrpt::math::TPose2D start(0, 0, 0), goal(10, 0, 0);
+
+	sources.update_source("map", make_wall(20.0f));
+	cache.insert(start, goal, path, sources.versions());
+
+	// Same quantized start and goal, unchanged obstacles:
+	const mrpt::math::TPose2D start2(0.05, -0.05, mrpt::DEG2RAD(2.0));
+	const auto hit = cache.lookup(start2, goal, sources.get_all_points(), 0.3);
+	ASSERT_TRUE(hit);
+	EXPECT_EQ(hit->front().x, start2.x);
+	EXPECT_EQ(hit->front().y, start2.y);
+	EXPECT_FALSE(cache.lookup({1, 0, 0}, goal, sources.get_all_points(), 0.3));
+
+	// New obstacles away from the path: still valid after a check.
+	sources.update_source("map", make_wall(-5.0f));
+	EXPECT_TRUE(cache.lookup(start, goal, sources.get_all_points(), 0.3));
+	EXPECT_EQ(cache.stats().revalidated, 1U);
+
+	// A source blocking the path drops it:
+	sources.update_source("obstacles", make_wall(4.5f));
+	EXPECT_FALSE(cache.lookup(start, goal, sources.get_all_points(), 0.3));
+	EXPECT_EQ(cache.stats().invalidated, 1U);
+	EXPECT_EQ(cache.stats().entries, 0U);
+
+	// Least recently used paths are evicted:
+	for (int i = 0; i < 3; i++)
+		cache.insert({0, 0, 0}, {10.0 + i, 0, 0}, path, sources.versions());
+	const auto st = cache.stats();
+	EXPECT_EQ(st.entries, 2U);
+	EXPECT_EQ(st.evictions, 1U);
+	EXPECT_GT(st.memoryBytes, 2 * path.size() * sizeof(path[0]));
+	EXPECT_EQ(st.lookups, 4U);
+	EXPECT_EQ(st.hits, 2U);
+}
+
+TEST(PlanCache, ChecksTheSegmentFromTheActualStart)
+{
+	using namespace mrpt_tps_astar_planner;
+
+	ObstacleSourceCache sources;
+	sources.params.background_build = false;
+	sources.params.build_costmaps = false;
+
+	PlanCache cache;
+	cache.params.max_entries = 2;
+
+	std::vector<mrpt::math::TPose2D> path;
+	for (int i = 0; i <= 10; i++) path.emplace_back(i, 0, 0);
+	const mrpt::math::TPose2D start(0, 0, 0), goal(10, 0, 0);
+
+	// An obstacle 0.38 m away from the planned start, known when planning:
+	auto pts = mrpt::maps::CSimplePointsMap::Create();
+	pts->insertPoint(-0.05f, 0.38f, 0);
+	sources.update_source("map", pts);
+	cache.insert(start, goal, path, sources.versions());
+
+	// A start in the same cell, but too close to it:
+	const mrpt::math::TPose2D start2(0, 0.12, 0);
+	EXPECT_FALSE(cache.lookup(start2, goal, sources.get_all_points(), 0.3));
+	EXPECT_EQ(cache.stats().invalidated, 0U);
+
+	// The path is still there for other starts:
+	EXPECT_TRUE(cache.lookup(start, goal, sources.get_all_points(), 0.3));
+	EXPECT_EQ(cache.stats().entries, 1U);
+}
+
+TEST(PlanProgress, BufferAndBoundedHistory)
+{
+	using namespace mrpt_tps_astar_planner;
+
+	auto sample = [](int i)
+	{
+		PlanProgressSample s;
+		s.elapsedTime = i;
+		s.treeNodes = 10 * i;
+		return s;
+	};
+
+	// Latest sample slot: many more pushes than slots, the newest is kept.
+	PlanProgressBuffer buf;
+	EXPECT_FALSE(buf.pop_latest().has_value());
+	for (int i = 0; i < 100; i++) buf.push(sample(i));
+
+	auto s = buf.pop_latest();
+	ASSERT_TRUE(s.has_value());
+	EXPECT_EQ(s->elapsedTime, 99);
+	EXPECT_EQ(s->expansions_per_second(), 10);
+	EXPECT_FALSE(buf.pop_latest().has_value());
+
+	buf.push(sample(100));
+	buf.push(sample(101));
+	s = buf.pop_latest();
+	ASSERT_TRUE(s.has_value());
+	EXPECT_EQ(s->elapsedTime, 101);
+
+	// Concurrent producer: samples never go back in time.
+	std::thread producer(
+		[&]()
+		{
+			for (int i = 200; i < 20000; i++) buf.push(sample(i));
+		});
+	double lastTime = 101;
+	while (lastTime < 19999)
+	{
+		if (const auto c = buf.pop_latest(); c)
+		{
+			EXPECT_GT(c->elapsedTime, lastTime);
+			lastTime = c->elapsedTime;
+		}
+	}
+	producer.join();
+
+	// History: bounded size, evenly decimated, first and last kept.
+	PlanProgressHistory history(16);
+	for (int i = 0; i < 1000; i++) history.add(sample(i));
+
+	const auto h = history.samples();
+	ASSERT_GE(h.size(), 8U);
+	EXPECT_LE(h.size(), 17U);
+	EXPECT_EQ(h.front().elapsedTime, 0);
+	EXPECT_EQ(h.back().elapsedTime, 999);
+	const double step = h[1].elapsedTime - h[0].elapsedTime;
+	for (size_t i = 1; i + 1 < h.size(); i++)
+		EXPECT_EQ(h[i].elapsedTime - h[i - 1].elapsedTime, step);
+}